@@ -0,0 +1,184 @@
+/**
+ * @file benchmark_main.c
+ * @author Giel Willemsen
+ * @brief On target benchmarks for the led strip driver.
+ * @version 0.1 2022-09-07 Initial version
+ * @date 2022-09-07
+ *
+ * @copyright
+ * MIT License
+ *
+ * Copyright (c) 2022 Giel Willemsen
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+
+#include <stdio.h>
+#include <inttypes.h>
+#include <esp_err.h>
+#include <esp_cpu.h>
+#include <esp_idf_version.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <led_strip.h>
+
+static const led_strip_pixel_index_t benchmark_led_counts[] = {30, 300, 1000, 4096};
+static const led_strip_type benchmark_types[] = {LED_STRIP_TYPE_SK6822, LED_STRIP_TYPE_WS281x};
+
+static uint32_t cycle_count(void);
+static const char *type_name(led_strip_type type);
+static void print_result(const char *metric, led_strip_type type, bool rgbw, led_strip_pixel_index_t led_count, double value, const char *unit);
+static void run_benchmark(led_strip_type type, bool rgbw, led_strip_pixel_index_t led_count);
+static void benchmark_set_pixel(led_strip_handle_t handle, led_strip_type type, bool rgbw, led_strip_pixel_index_t led_count);
+static void benchmark_fill(led_strip_handle_t handle, led_strip_type type, bool rgbw, led_strip_pixel_index_t led_count);
+static void benchmark_flush(led_strip_handle_t handle, led_strip_type type, bool rgbw, led_strip_pixel_index_t led_count);
+
+void app_main(void)
+{
+    led_strip_init();
+    printf("BENCH_BEGIN,iterations=%d\n", CONFIG_BENCHMARK_ITERATIONS);
+    printf("BENCH,metric,timing,format,led_count,value,unit\n");
+    for (size_t t = 0; t < sizeof(benchmark_types) / sizeof(benchmark_types[0]); t++)
+    {
+        for (int rgbw = 0; rgbw < 2; rgbw++)
+        {
+            for (size_t c = 0; c < sizeof(benchmark_led_counts) / sizeof(benchmark_led_counts[0]); c++)
+            {
+                run_benchmark(benchmark_types[t], rgbw == 1, benchmark_led_counts[c]);
+            }
+        }
+    }
+    printf("BENCH_END\n");
+}
+
+static uint32_t cycle_count(void)
+{
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+    return (uint32_t)esp_cpu_get_cycle_count();
+#else
+    return esp_cpu_get_ccount();
+#endif
+}
+
+static const char *type_name(led_strip_type type)
+{
+    switch (type)
+    {
+    case LED_STRIP_TYPE_SK6822:
+        return "SK6822";
+    case LED_STRIP_TYPE_WS281x:
+        return "WS281x";
+    default:
+        return "unknown";
+    }
+}
+
+static void print_result(const char *metric, led_strip_type type, bool rgbw, led_strip_pixel_index_t led_count, double value, const char *unit)
+{
+    printf("BENCH,%s,%s,%s,%u,%.2f,%s\n", metric, type_name(type), rgbw ? "RGBW" : "RGB", (unsigned)led_count, value, unit);
+}
+
+static void run_benchmark(led_strip_type type, bool rgbw, led_strip_pixel_index_t led_count)
+{
+    led_strip_config_t config;
+    led_strip_init_config(&config);
+    config.timing_config.timing.type = type;
+    config.timing_config.use_manual_timing = false;
+    config.gpio_output_num = CONFIG_BENCHMARK_GPIO_OUTPUT_NUM;
+    config.led_count = led_count;
+    config.enable_w_channel = rgbw;
+
+    led_strip_handle_t handle = NULL;
+    esp_err_t err = led_strip_install(&handle, &config);
+    if (err != ESP_OK)
+    {
+        printf("BENCH_SKIP,%s,%s,%u,%s\n", type_name(type), rgbw ? "RGBW" : "RGB", (unsigned)led_count, esp_err_to_name(err));
+        return;
+    }
+    benchmark_set_pixel(handle, type, rgbw, led_count);
+    benchmark_fill(handle, type, rgbw, led_count);
+    benchmark_flush(handle, type, rgbw, led_count);
+    ESP_ERROR_CHECK(led_strip_free(handle));
+    // Give the idle task some time, so the task watchdog stays happy during long runs.
+    vTaskDelay(1);
+}
+
+static void benchmark_set_pixel(led_strip_handle_t handle, led_strip_type type, bool rgbw, led_strip_pixel_index_t led_count)
+{
+    const uint32_t start = cycle_count();
+    for (int i = 0; i < CONFIG_BENCHMARK_ITERATIONS; i++)
+    {
+        for (led_strip_pixel_index_t p = 0; p < led_count; p++)
+        {
+            led_strip_set_pixel_rgb(handle, p, (uint8_t)p, (uint8_t)(p + i), (uint8_t)i);
+        }
+    }
+    const uint32_t cycles = cycle_count() - start;
+    print_result("set_pixel_rgb", type, rgbw, led_count, (double)cycles / ((double)CONFIG_BENCHMARK_ITERATIONS * led_count), "cycles");
+}
+
+static void benchmark_fill(led_strip_handle_t handle, led_strip_type type, bool rgbw, led_strip_pixel_index_t led_count)
+{
+    const uint32_t start = cycle_count();
+    for (int i = 0; i < CONFIG_BENCHMARK_ITERATIONS; i++)
+    {
+        led_strip_fill_rgb(handle, (uint8_t)i, 0x55, 0xAA);
+    }
+    const uint32_t cycles = cycle_count() - start;
+    print_result("fill_rgb", type, rgbw, led_count, (double)cycles / CONFIG_BENCHMARK_ITERATIONS, "cycles");
+    print_result("fill_rgb_per_pixel", type, rgbw, led_count, (double)cycles / ((double)CONFIG_BENCHMARK_ITERATIONS * led_count), "cycles");
+}
+
+static void benchmark_flush(led_strip_handle_t handle, led_strip_type type, bool rgbw, led_strip_pixel_index_t led_count)
+{
+    const bool has_stats = led_strip_reset_stats(handle) == ESP_OK;
+    int64_t total_time = 0;
+    int64_t max_time = 0;
+    for (int i = 0; i < CONFIG_BENCHMARK_ITERATIONS; i++)
+    {
+        // Change the frame every time so nothing can be reused from the previous flush.
+        led_strip_fill_rgb(handle, (uint8_t)i, 0x55, 0xAA);
+        const int64_t start = esp_timer_get_time();
+        ESP_ERROR_CHECK(led_strip_flush(handle));
+        const int64_t time = esp_timer_get_time() - start;
+        total_time += time;
+        if (time > max_time)
+        {
+            max_time = time;
+        }
+    }
+    print_result("flush_avg", type, rgbw, led_count, (double)total_time / CONFIG_BENCHMARK_ITERATIONS, "us");
+    print_result("flush_max", type, rgbw, led_count, (double)max_time, "us");
+
+    led_strip_stats_t stats;
+    if (has_stats == false || led_strip_get_stats(handle, &stats) != ESP_OK)
+    {
+        return; // CONFIG_LED_STRIP_ENABLE_STATS is disabled.
+    }
+    if (stats.bytes_translated > 0)
+    {
+        print_result("translator_per_byte", type, rgbw, led_count, (double)stats.translator_cycles / (double)stats.bytes_translated, "cycles");
+    }
+    print_result("translator_max_call", type, rgbw, led_count, (double)stats.max_translator_call_cycles, "cycles");
+    print_result("translator_calls", type, rgbw, led_count, (double)stats.last_frame_translator_calls, "calls");
+    print_result("frame_time", type, rgbw, led_count, (double)stats.last_frame_time_us, "us");
+}
@@ -0,0 +1,312 @@
+/**
+ * @file led_strip_host_bench.c
+ * @author Giel Willemsen
+ * @brief Microbenchmarks of the set, fill and translate paths of the led strip on the host, against the simulated RMT driver.
+ * @version 0.1 2022-09-07 Initial version
+ * @date 2022-09-07
+ *
+ * @copyright
+ * MIT License
+ *
+ * Copyright (c) 2022 Giel Willemsen
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <time.h>
+#include <esp_err.h>
+#include <led_strip.h>
+#include <led_strip_sim.h>
+
+#define BENCH_GPIO_OUTPUT_NUM 18
+#define BENCH_DEFAULT_MIN_TIME_S 0.2
+#define BENCH_MAX_ITERATIONS (1ULL << 30)
+
+typedef struct bench_case
+{
+    const char *metric;
+    led_strip_pixel_format_t pixel_format;
+    uint8_t brightness;
+    void (*run)(led_strip_handle_t handle, led_strip_pixel_index_t led_count, uint64_t iterations); ///< Runs the measured operation iterations times.
+} bench_case_t;
+
+typedef struct bench_options
+{
+    const char *filter;
+    double min_time_s;
+    bool csv;
+} bench_options_t;
+
+static void bench_set_pixel_rgb(led_strip_handle_t handle, led_strip_pixel_index_t led_count, uint64_t iterations);
+static void bench_set_pixel_rgb_unchecked(led_strip_handle_t handle, led_strip_pixel_index_t led_count, uint64_t iterations);
+static void bench_set_pixels_rgb(led_strip_handle_t handle, led_strip_pixel_index_t led_count, uint64_t iterations);
+static void bench_fill_rgb(led_strip_handle_t handle, led_strip_pixel_index_t led_count, uint64_t iterations);
+static void bench_translate(led_strip_handle_t handle, led_strip_pixel_index_t led_count, uint64_t iterations);
+static void run_case(const bench_case_t *bench, led_strip_type type, bool rgbw, led_strip_pixel_index_t led_count, const bench_options_t *options);
+static uint64_t monotonic_ns(void);
+static const char *type_name(led_strip_type type);
+static void print_usage(const char *program);
+
+static const led_strip_pixel_index_t bench_led_counts[] = {30, 300, 1000, 4096};
+static const led_strip_type bench_types[] = {LED_STRIP_TYPE_WS281x};
+
+/// translate is a blocking flush, the simulated driver runs the translator for the whole frame before it returns.
+static const bench_case_t bench_cases[] = {
+    {"set_pixel_rgb", LED_STRIP_PIXEL_FORMAT_WIRE, 255, bench_set_pixel_rgb},
+    {"set_pixel_rgb_unchecked", LED_STRIP_PIXEL_FORMAT_WIRE, 255, bench_set_pixel_rgb_unchecked},
+    {"set_pixels_rgb", LED_STRIP_PIXEL_FORMAT_WIRE, 255, bench_set_pixels_rgb},
+    {"fill_rgb", LED_STRIP_PIXEL_FORMAT_WIRE, 255, bench_fill_rgb},
+    {"translate", LED_STRIP_PIXEL_FORMAT_WIRE, 255, bench_translate},
+    {"translate_leveled", LED_STRIP_PIXEL_FORMAT_WIRE, 128, bench_translate},
+    {"translate_canonical", LED_STRIP_PIXEL_FORMAT_RGBA32, 255, bench_translate},
+};
+
+static uint8_t *rgb_frame = NULL;
+
+int main(int argc, char **argv)
+{
+    bench_options_t options = {
+        .filter = NULL,
+        .min_time_s = BENCH_DEFAULT_MIN_TIME_S,
+        .csv = false,
+    };
+    for (int i = 1; i < argc; i++)
+    {
+        if (strncmp(argv[i], "--filter=", 9) == 0)
+        {
+            options.filter = argv[i] + 9;
+        }
+        else if (strncmp(argv[i], "--min_time=", 11) == 0)
+        {
+            options.min_time_s = atof(argv[i] + 11);
+        }
+        else if (strcmp(argv[i], "--csv") == 0)
+        {
+            options.csv = true;
+        }
+        else
+        {
+            print_usage(argv[0]);
+            return 2;
+        }
+    }
+
+    led_strip_init();
+    // Only the translator is measured, not copying its output into the recording of the simulator.
+    led_strip_sim_set_recording(false);
+    rgb_frame = (uint8_t *)malloc((size_t)bench_led_counts[sizeof(bench_led_counts) / sizeof(bench_led_counts[0]) - 1] * 3);
+    if (rgb_frame == NULL)
+    {
+        return 1;
+    }
+    if (options.csv)
+    {
+        printf("BENCH_BEGIN,host\n");
+        printf("BENCH,metric,timing,format,led_count,value,unit\n");
+    }
+    else
+    {
+        printf("%-48s %14s %14s %12s\n", "Benchmark", "Time", "Per pixel", "Iterations");
+    }
+    for (size_t c = 0; c < sizeof(bench_cases) / sizeof(bench_cases[0]); c++)
+    {
+        for (size_t t = 0; t < sizeof(bench_types) / sizeof(bench_types[0]); t++)
+        {
+            for (int rgbw = 0; rgbw < 2; rgbw++)
+            {
+                for (size_t n = 0; n < sizeof(bench_led_counts) / sizeof(bench_led_counts[0]); n++)
+                {
+                    run_case(&bench_cases[c], bench_types[t], rgbw == 1, bench_led_counts[n], &options);
+                }
+            }
+        }
+    }
+    if (options.csv)
+    {
+        printf("BENCH_END\n");
+    }
+    free(rgb_frame);
+    return 0;
+}
+
+static void bench_set_pixel_rgb(led_strip_handle_t handle, led_strip_pixel_index_t led_count, uint64_t iterations)
+{
+    for (uint64_t i = 0; i < iterations; i++)
+    {
+        for (led_strip_pixel_index_t p = 0; p < led_count; p++)
+        {
+            led_strip_set_pixel_rgb(handle, p, (uint8_t)p, (uint8_t)(p + i), (uint8_t)i);
+        }
+    }
+}
+
+static void bench_set_pixel_rgb_unchecked(led_strip_handle_t handle, led_strip_pixel_index_t led_count, uint64_t iterations)
+{
+    for (uint64_t i = 0; i < iterations; i++)
+    {
+        for (led_strip_pixel_index_t p = 0; p < led_count; p++)
+        {
+            led_strip_set_pixel_rgb_unchecked(handle, p, (uint8_t)p, (uint8_t)(p + i), (uint8_t)i);
+        }
+    }
+}
+
+static void bench_set_pixels_rgb(led_strip_handle_t handle, led_strip_pixel_index_t led_count, uint64_t iterations)
+{
+    for (size_t b = 0; b < (size_t)led_count * 3; b++)
+    {
+        rgb_frame[b] = (uint8_t)(b * 7);
+    }
+    for (uint64_t i = 0; i < iterations; i++)
+    {
+        led_strip_set_pixels_rgb(handle, 0, led_count, rgb_frame);
+    }
+}
+
+static void bench_fill_rgb(led_strip_handle_t handle, led_strip_pixel_index_t led_count, uint64_t iterations)
+{
+    (void)led_count; // The fill always covers the whole strip.
+    for (uint64_t i = 0; i < iterations; i++)
+    {
+        led_strip_fill_rgb(handle, (uint8_t)i, 0x55, 0xAA);
+    }
+}
+
+static void bench_translate(led_strip_handle_t handle, led_strip_pixel_index_t led_count, uint64_t iterations)
+{
+    for (led_strip_pixel_index_t p = 0; p < led_count; p++)
+    {
+        led_strip_set_pixel_rgb(handle, p, (uint8_t)p, (uint8_t)(p * 3), (uint8_t)(p * 5));
+    }
+    for (uint64_t i = 0; i < iterations; i++)
+    {
+        // Touch a pixel so the frame counts as changed, the rest of the frame is translated again as well.
+        led_strip_set_pixel_rgb(handle, 0, (uint8_t)i, 0x55, 0xAA);
+        ESP_ERROR_CHECK(led_strip_flush(handle));
+    }
+}
+
+static void run_case(const bench_case_t *bench, led_strip_type type, bool rgbw, led_strip_pixel_index_t led_count, const bench_options_t *options)
+{
+    char name[128];
+    snprintf(name, sizeof(name), "%s/%s/%s/%u", bench->metric, type_name(type), rgbw ? "RGBW" : "RGB", (unsigned)led_count);
+    if (options->filter != NULL && strstr(name, options->filter) == NULL)
+    {
+        return;
+    }
+
+    led_strip_config_t config;
+    led_strip_init_config(&config);
+    config.timing_config.timing.type = type;
+    config.timing_config.use_manual_timing = false;
+    config.gpio_output_num = BENCH_GPIO_OUTPUT_NUM;
+    config.led_count = led_count;
+    config.enable_w_channel = rgbw;
+    config.pixel_format = bench->pixel_format;
+    led_strip_handle_t handle = NULL;
+    esp_err_t err = led_strip_install(&handle, &config);
+    if (err == ESP_OK && bench->brightness != 255)
+    {
+        err = led_strip_set_brightness(handle, bench->brightness);
+    }
+    if (err != ESP_OK)
+    {
+        if (options->csv)
+        {
+            printf("BENCH_SKIP,%s,%s,%u,%s\n", type_name(type), rgbw ? "RGBW" : "RGB", (unsigned)led_count, esp_err_to_name(err));
+        }
+        else
+        {
+            printf("%-48s skipped: %s\n", name, esp_err_to_name(err));
+        }
+        if (handle != NULL)
+        {
+            led_strip_free(handle);
+        }
+        return;
+    }
+
+    // Like Google Benchmark, the iterations grow until a run takes at least the minimum time.
+    // The wall clock is used, esp_timer_get_time skips over the latch time between the frames.
+    const uint64_t min_time_ns = (uint64_t)(options->min_time_s * 1e9);
+    uint64_t iterations = 1;
+    uint64_t elapsed_ns = 0;
+    while (true)
+    {
+        const uint64_t start = monotonic_ns();
+        bench->run(handle, led_count, iterations);
+        elapsed_ns = monotonic_ns() - start;
+        if (elapsed_ns >= min_time_ns || iterations >= BENCH_MAX_ITERATIONS)
+        {
+            break;
+        }
+        // Aim a bit past the minimum time, based on the run that just ended.
+        const double scale = elapsed_ns > 0 ? (double)min_time_ns * 1.4 / (double)elapsed_ns : 10.0;
+        const uint64_t next = (uint64_t)((double)iterations * (scale < 10.0 ? scale : 10.0));
+        iterations = next > iterations ? next : iterations + 1;
+    }
+    ESP_ERROR_CHECK(led_strip_free(handle));
+
+    const double ns_per_iteration = (double)elapsed_ns / (double)iterations;
+    const double ns_per_pixel = ns_per_iteration / (double)led_count;
+    if (options->csv)
+    {
+        printf("BENCH,%s,%s,%s,%u,%.2f,ns\n", bench->metric, type_name(type), rgbw ? "RGBW" : "RGB", (unsigned)led_count, ns_per_iteration);
+        printf("BENCH,%s_per_pixel,%s,%s,%u,%.3f,ns\n", bench->metric, type_name(type), rgbw ? "RGBW" : "RGB", (unsigned)led_count, ns_per_pixel);
+    }
+    else
+    {
+        printf("%-48s %11.1f ns %11.3f ns %12" PRIu64 "\n", name, ns_per_iteration, ns_per_pixel, iterations);
+    }
+}
+
+static uint64_t monotonic_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+static const char *type_name(led_strip_type type)
+{
+    switch (type)
+    {
+    case LED_STRIP_TYPE_SK6822:
+        return "SK6822";
+    case LED_STRIP_TYPE_WS281x:
+        return "WS281x";
+    default:
+        return "unknown";
+    }
+}
+
+static void print_usage(const char *program)
+{
+    fprintf(stderr, "Usage: %s [--filter=<substring>] [--min_time=<seconds>] [--csv]\n", program);
+    fprintf(stderr, "  --filter=<substring> Only run the benchmarks with the substring in their name, like set_pixel or /RGBW/300.\n");
+    fprintf(stderr, "  --min_time=<seconds> The minimum run time per benchmark, %.1f s by default.\n", BENCH_DEFAULT_MIN_TIME_S);
+    fprintf(stderr, "  --csv                Print BENCH lines like the on-target benchmark project, in nanoseconds.\n");
+}
@@ -0,0 +1,800 @@
+/**
+ * @file led_strip_host_golden.c
+ * @author Giel Willemsen
+ * @brief Checks the RMT items that the led strip generates in the simulator against recorded golden waveforms.
+ * @version 0.1 2022-09-07 Initial version
+ * @date 2022-09-07
+ *
+ * @copyright
+ * MIT License
+ *
+ * Copyright (c) 2022 Giel Willemsen
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <inttypes.h>
+#include <esp_err.h>
+#include <led_strip.h>
+#include <led_strip_effect.h>
+#include <led_strip_sim.h>
+
+#define GOLDEN_GPIO_OUTPUT_NUM 18
+#define GOLDEN_LINE_SIZE 256
+#define FNV_OFFSET_BASIS 0xCBF29CE484222325ULL
+#define FNV_PRIME 0x100000001B3ULL
+#define GOLDEN_BRIGHTNESS 100
+#define GOLDEN_GAMMA_BRIGHTNESS 200
+#define GOLDEN_PARTIAL_PIXEL 10
+#define GOLDEN_CHASE_LENGTH 4
+#define GOLDEN_CHASE_SPEED 3 ///< In pixels per frame, above half the length the segments of two frames ago and now don't overlap.
+#define GOLDEN_CHASE_FRAMES 9
+#define GOLDEN_MANUAL_LOW_ON 3
+#define GOLDEN_MANUAL_LOW_OFF 8
+#define GOLDEN_MANUAL_HIGH_ON 7
+#define GOLDEN_MANUAL_HIGH_OFF 5
+#define GOLDEN_MANUAL_RESET_TIME 600
+#define GOLDEN_NS_PER_SECOND 1000000000ULL
+
+typedef struct golden_scenario golden_scenario_t;
+
+typedef struct golden_scenario
+{
+    const char *name;
+    led_strip_type type;
+    bool use_manual_timing;
+    led_strip_color_order_t color_order;
+    bool enable_w_channel;
+    led_strip_pixel_index_t led_count;
+    led_strip_pixel_format_t pixel_format;
+    led_strip_memory_policy_t memory_policy;
+    bool enable_double_buffer;
+    bool enable_partial_flush;
+    uint8_t baked_frame_count;
+    led_strip_pixel_index_t sent_count; ///< The LEDs that the last transmission sends, 0 for all of them.
+    esp_err_t (*render)(led_strip_handle_t handle, const golden_scenario_t *scenario); ///< Sets the pixels and flushes, the last transmission is the waveform.
+    led_strip_color_t (*expect)(led_strip_pixel_index_t index); ///< The color that the LED at an index has to get, computed without the led strip.
+} golden_scenario_t;
+
+typedef struct golden_waveform
+{
+    size_t item_count;
+    uint64_t hash;
+} golden_waveform_t;
+
+typedef struct golden_bit_timing
+{
+    uint32_t low_on;
+    uint32_t low_off;
+    uint32_t high_on;
+    uint32_t high_off;
+} golden_bit_timing_t;
+
+typedef enum golden_mode {
+    GOLDEN_MODE_CHECK,
+    GOLDEN_MODE_UPDATE,
+    GOLDEN_MODE_DUMP,
+} golden_mode_t;
+
+static led_strip_color_t pattern_color(led_strip_pixel_index_t index);
+static esp_err_t set_pattern(led_strip_handle_t handle, const golden_scenario_t *scenario);
+static esp_err_t render_pattern(led_strip_handle_t handle, const golden_scenario_t *scenario);
+static esp_err_t render_brightness(led_strip_handle_t handle, const golden_scenario_t *scenario);
+static esp_err_t render_gamma(led_strip_handle_t handle, const golden_scenario_t *scenario);
+static esp_err_t render_white_point(led_strip_handle_t handle, const golden_scenario_t *scenario);
+static esp_err_t render_rgb_frame(led_strip_handle_t handle, const golden_scenario_t *scenario);
+static esp_err_t render_matrix(led_strip_handle_t handle, const golden_scenario_t *scenario);
+static esp_err_t render_partial(led_strip_handle_t handle, const golden_scenario_t *scenario);
+static esp_err_t render_baked(led_strip_handle_t handle, const golden_scenario_t *scenario);
+static esp_err_t render_chase(led_strip_handle_t handle, const golden_scenario_t *scenario);
+static led_strip_color_t expect_pattern(led_strip_pixel_index_t index);
+static led_strip_color_t expect_brightness(led_strip_pixel_index_t index);
+static led_strip_color_t expect_gamma(led_strip_pixel_index_t index);
+static led_strip_color_t expect_white_point(led_strip_pixel_index_t index);
+static led_strip_color_t expect_matrix(led_strip_pixel_index_t index);
+static led_strip_color_t expect_partial(led_strip_pixel_index_t index);
+static led_strip_color_t expect_chase(led_strip_pixel_index_t index);
+static uint8_t scale_level(uint8_t level, uint8_t brightness);
+static golden_bit_timing_t map_bit_timing(const golden_scenario_t *scenario, uint8_t clk_div);
+static void map_wire_bytes(const golden_scenario_t *scenario, led_strip_color_t color, uint8_t *bytes);
+static bool decode_byte(const golden_bit_timing_t *timing, const rmt_item32_t *items, uint8_t *byte);
+static esp_err_t check_bytes(const golden_scenario_t *scenario, const led_strip_sim_transmission_t *transmission);
+static esp_err_t run_scenario(const golden_scenario_t *scenario, uint8_t mem_block_num, golden_waveform_t *waveform, bool dump);
+static bool find_golden(FILE *file, const char *name, golden_waveform_t *waveform);
+static void print_usage(const char *program);
+
+static uint8_t gamma_table[LED_STRIP_GAMMA_TABLE_SIZE];
+static const led_strip_color_t white_point = {
+    .r = 255,
+    .g = 200,
+    .b = 150,
+    .w = 0,
+};
+static const led_strip_color_t chase_color = {
+    .r = 0x40,
+    .g = 0x20,
+    .b = 0x10,
+    .w = 0x00,
+};
+static const led_strip_color_t chase_background = {
+    .r = 0x01,
+    .g = 0x02,
+    .b = 0x03,
+    .w = 0x00,
+};
+
+static const golden_scenario_t scenarios[] = {
+    {"ws281x_grb_30", LED_STRIP_TYPE_WS281x, false, LED_STRIP_COLOR_ORDER_GRBW, false, 30, LED_STRIP_PIXEL_FORMAT_WIRE, LED_STRIP_MEMORY_INTERNAL, false, false, 0, 0, render_pattern, expect_pattern},
+    {"ws281x_rgb_30", LED_STRIP_TYPE_WS281x, false, LED_STRIP_COLOR_ORDER_RGBW, false, 30, LED_STRIP_PIXEL_FORMAT_WIRE, LED_STRIP_MEMORY_INTERNAL, false, false, 0, 0, render_pattern, expect_pattern},
+    {"ws281x_grbw_30", LED_STRIP_TYPE_WS281x, false, LED_STRIP_COLOR_ORDER_GRBW, true, 30, LED_STRIP_PIXEL_FORMAT_WIRE, LED_STRIP_MEMORY_INTERNAL, false, false, 0, 0, render_pattern, expect_pattern},
+    {"ws281x_rgbw_30", LED_STRIP_TYPE_WS281x, false, LED_STRIP_COLOR_ORDER_RGBW, true, 30, LED_STRIP_PIXEL_FORMAT_WIRE, LED_STRIP_MEMORY_INTERNAL, false, false, 0, 0, render_pattern, expect_pattern},
+    {"sk6822_grb_30", LED_STRIP_TYPE_SK6822, false, LED_STRIP_COLOR_ORDER_GRBW, false, 30, LED_STRIP_PIXEL_FORMAT_WIRE, LED_STRIP_MEMORY_INTERNAL, false, false, 0, 0, render_pattern, expect_pattern},
+    {"manual_grb_30", LED_STRIP_TYPE_WS281x, true, LED_STRIP_COLOR_ORDER_GRBW, false, 30, LED_STRIP_PIXEL_FORMAT_WIRE, LED_STRIP_MEMORY_INTERNAL, false, false, 0, 0, render_pattern, expect_pattern},
+    {"ws281x_grb_1000", LED_STRIP_TYPE_WS281x, false, LED_STRIP_COLOR_ORDER_GRBW, false, 1000, LED_STRIP_PIXEL_FORMAT_WIRE, LED_STRIP_MEMORY_INTERNAL, false, false, 0, 0, render_pattern, expect_pattern},
+    {"ws281x_grb_300_brightness", LED_STRIP_TYPE_WS281x, false, LED_STRIP_COLOR_ORDER_GRBW, false, 300, LED_STRIP_PIXEL_FORMAT_WIRE, LED_STRIP_MEMORY_INTERNAL, false, false, 0, 0, render_brightness, expect_brightness},
+    {"ws281x_grb_300_gamma", LED_STRIP_TYPE_WS281x, false, LED_STRIP_COLOR_ORDER_GRBW, false, 300, LED_STRIP_PIXEL_FORMAT_WIRE, LED_STRIP_MEMORY_INTERNAL, false, false, 0, 0, render_gamma, expect_gamma},
+    {"ws281x_grbw_300_white_point", LED_STRIP_TYPE_WS281x, false, LED_STRIP_COLOR_ORDER_GRBW, true, 300, LED_STRIP_PIXEL_FORMAT_WIRE, LED_STRIP_MEMORY_INTERNAL, false, false, 0, 0, render_white_point, expect_white_point},
+    {"ws281x_grb_300_rgb24", LED_STRIP_TYPE_WS281x, false, LED_STRIP_COLOR_ORDER_GRBW, false, 300, LED_STRIP_PIXEL_FORMAT_RGB24, LED_STRIP_MEMORY_INTERNAL, false, false, 0, 0, render_rgb_frame, expect_pattern},
+    {"ws281x_grbw_300_rgba32", LED_STRIP_TYPE_WS281x, false, LED_STRIP_COLOR_ORDER_GRBW, true, 300, LED_STRIP_PIXEL_FORMAT_RGBA32, LED_STRIP_MEMORY_INTERNAL, false, false, 0, 0, render_pattern, expect_pattern},
+    {"ws281x_grb_300_rgba32_brightness", LED_STRIP_TYPE_WS281x, false, LED_STRIP_COLOR_ORDER_GRBW, false, 300, LED_STRIP_PIXEL_FORMAT_RGBA32, LED_STRIP_MEMORY_INTERNAL, false, false, 0, 0, render_brightness, expect_brightness},
+    {"ws281x_grb_300_psram", LED_STRIP_TYPE_WS281x, false, LED_STRIP_COLOR_ORDER_GRBW, false, 300, LED_STRIP_PIXEL_FORMAT_WIRE, LED_STRIP_MEMORY_SPIRAM_FRAMEBUFFER, false, false, 0, 0, render_pattern, expect_pattern},
+    {"ws281x_grb_128_serpentine", LED_STRIP_TYPE_WS281x, false, LED_STRIP_COLOR_ORDER_GRBW, false, 128, LED_STRIP_PIXEL_FORMAT_WIRE, LED_STRIP_MEMORY_INTERNAL, false, false, 0, 0, render_matrix, expect_matrix},
+    {"ws281x_grb_300_partial", LED_STRIP_TYPE_WS281x, false, LED_STRIP_COLOR_ORDER_GRBW, false, 300, LED_STRIP_PIXEL_FORMAT_WIRE, LED_STRIP_MEMORY_INTERNAL, false, true, 0, GOLDEN_PARTIAL_PIXEL + 1, render_partial, expect_partial},
+    {"ws281x_grb_300_baked", LED_STRIP_TYPE_WS281x, false, LED_STRIP_COLOR_ORDER_GRBW, false, 300, LED_STRIP_PIXEL_FORMAT_WIRE, LED_STRIP_MEMORY_INTERNAL, false, false, 1, 0, render_baked, expect_pattern},
+    {"ws281x_grb_60_chase_double_partial", LED_STRIP_TYPE_WS281x, false, LED_STRIP_COLOR_ORDER_GRBW, false, 60, LED_STRIP_PIXEL_FORMAT_WIRE, LED_STRIP_MEMORY_INTERNAL, true, true, 0, 0, render_chase, expect_chase},
+};
+
+/// The translator has to give the same waveform however the driver splits the refills.
+static const uint8_t mem_block_nums[] = {1, 2, 3};
+
+int main(int argc, char **argv)
+{
+    golden_mode_t mode = GOLDEN_MODE_CHECK;
+    const char *path = LED_STRIP_GOLDEN_FILE;
+    const char *dump_name = NULL;
+    char update_path[GOLDEN_LINE_SIZE];
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--update") == 0)
+        {
+            mode = GOLDEN_MODE_UPDATE;
+        }
+        else if (strcmp(argv[i], "--dump") == 0 && i + 1 < argc)
+        {
+            mode = GOLDEN_MODE_DUMP;
+            dump_name = argv[++i];
+        }
+        else if (argv[i][0] != '-')
+        {
+            path = argv[i];
+        }
+        else
+        {
+            print_usage(argv[0]);
+            return 2;
+        }
+    }
+
+    // An update goes to a temporary file that only replaces the golden file when every scenario passed, so a failing
+    // scenario doesn't lose its entry.
+    if (mode == GOLDEN_MODE_UPDATE && snprintf(update_path, sizeof(update_path), "%s.tmp", path) >= (int)sizeof(update_path))
+    {
+        fprintf(stderr, "The path %s is too long\n", path);
+        return 2;
+    }
+    const char *open_path = mode == GOLDEN_MODE_UPDATE ? update_path : path;
+    FILE *file = fopen(open_path, mode == GOLDEN_MODE_UPDATE ? "w" : "r");
+    if (file == NULL && mode != GOLDEN_MODE_DUMP)
+    {
+        fprintf(stderr, "Can't open %s\n", open_path);
+        return 2;
+    }
+    if (mode == GOLDEN_MODE_UPDATE)
+    {
+        fprintf(file, "# The golden waveforms of led_strip_host_golden: <scenario> <items> <FNV-1a 64 of the items>\n");
+        fprintf(file, "# Regenerate with led_strip_host_golden --update, only when the change of the waveform is intended.\n");
+    }
+
+    led_strip_init();
+    int failures = 0;
+    int skipped = 0;
+    for (size_t s = 0; s < sizeof(scenarios) / sizeof(scenarios[0]); s++)
+    {
+        const golden_scenario_t *scenario = &scenarios[s];
+        if (mode == GOLDEN_MODE_DUMP)
+        {
+            if (strcmp(scenario->name, dump_name) == 0)
+            {
+                golden_waveform_t waveform;
+                esp_err_t err = run_scenario(scenario, 1, &waveform, true);
+                if (file != NULL)
+                {
+                    fclose(file);
+                }
+                return err == ESP_OK ? 0 : 1;
+            }
+            continue;
+        }
+
+        golden_waveform_t waveform;
+        esp_err_t err = run_scenario(scenario, mem_block_nums[0], &waveform, false);
+        if (err == ESP_ERR_NOT_SUPPORTED || err == ESP_ERR_INVALID_ARG)
+        {
+            // The options that fix the color order or the timing at build time refuse the other scenarios.
+            printf("SKIP %s (%s)\n", scenario->name, esp_err_to_name(err));
+            skipped++;
+            continue;
+        }
+        bool passed = err == ESP_OK;
+        for (size_t m = 1; m < sizeof(mem_block_nums) / sizeof(mem_block_nums[0]) && passed; m++)
+        {
+            golden_waveform_t split;
+            err = run_scenario(scenario, mem_block_nums[m], &split, false);
+            if (err == ESP_OK && (split.item_count != waveform.item_count || split.hash != waveform.hash))
+            {
+                printf("FAIL %s: %" PRIu32 " memory blocks give %zu items %016" PRIx64 ", 1 block gives %zu items %016" PRIx64 "\n", scenario->name,
+                       (uint32_t)mem_block_nums[m], split.item_count, split.hash, waveform.item_count, waveform.hash);
+                passed = false;
+            }
+            passed = passed && err == ESP_OK;
+        }
+        if (err != ESP_OK)
+        {
+            printf("FAIL %s: %s\n", scenario->name, esp_err_to_name(err));
+        }
+
+        if (passed && mode == GOLDEN_MODE_UPDATE)
+        {
+            fprintf(file, "%s %zu %016" PRIx64 "\n", scenario->name, waveform.item_count, waveform.hash);
+            printf("UPDATE %s %zu %016" PRIx64 "\n", scenario->name, waveform.item_count, waveform.hash);
+        }
+        else if (passed)
+        {
+            golden_waveform_t golden;
+            if (find_golden(file, scenario->name, &golden) == false)
+            {
+                printf("FAIL %s: not in %s\n", scenario->name, path);
+                passed = false;
+            }
+            else if (golden.item_count != waveform.item_count || golden.hash != waveform.hash)
+            {
+                printf("FAIL %s: %zu items %016" PRIx64 ", expected %zu items %016" PRIx64 "\n", scenario->name,
+                       waveform.item_count, waveform.hash, golden.item_count, golden.hash);
+                passed = false;
+            }
+            else
+            {
+                printf("PASS %s\n", scenario->name);
+            }
+        }
+        failures += passed ? 0 : 1;
+    }
+    if (file != NULL)
+    {
+        fclose(file);
+    }
+    if (mode == GOLDEN_MODE_DUMP)
+    {
+        fprintf(stderr, "Unknown scenario %s\n", dump_name);
+        return 2;
+    }
+    if (mode == GOLDEN_MODE_UPDATE && failures != 0)
+    {
+        remove(update_path);
+        printf("%s is not updated\n", path);
+    }
+    else if (mode == GOLDEN_MODE_UPDATE && rename(update_path, path) != 0)
+    {
+        fprintf(stderr, "Can't replace %s with %s\n", path, update_path);
+        remove(update_path);
+        return 2;
+    }
+    printf("%d failed, %d skipped\n", failures, skipped);
+    return failures == 0 ? 0 : 1;
+}
+
+static led_strip_color_t pattern_color(led_strip_pixel_index_t index)
+{
+    // Every component takes every value over 256 pixels, in a different order per component.
+    led_strip_color_t color = {
+        .r = (uint8_t)(index * 37 + 11),
+        .g = (uint8_t)(index * 73 + 5),
+        .b = (uint8_t)(index * 151 + 3),
+        .w = (uint8_t)(index * 29 + 7),
+    };
+    return color;
+}
+
+static esp_err_t set_pattern(led_strip_handle_t handle, const golden_scenario_t *scenario)
+{
+    for (led_strip_pixel_index_t i = 0; i < scenario->led_count; i++)
+    {
+        const led_strip_color_t color = pattern_color(i);
+        esp_err_t err = led_strip_set_pixel_rgbw(handle, i, color.r, color.g, color.b, color.w);
+        if (err != ESP_OK)
+        {
+            return err;
+        }
+    }
+    return ESP_OK;
+}
+
+static esp_err_t render_pattern(led_strip_handle_t handle, const golden_scenario_t *scenario)
+{
+    esp_err_t err = set_pattern(handle, scenario);
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+    return led_strip_flush(handle);
+}
+
+static esp_err_t render_brightness(led_strip_handle_t handle, const golden_scenario_t *scenario)
+{
+    esp_err_t err = led_strip_set_brightness(handle, GOLDEN_BRIGHTNESS);
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+    return render_pattern(handle, scenario);
+}
+
+static esp_err_t render_gamma(led_strip_handle_t handle, const golden_scenario_t *scenario)
+{
+    esp_err_t err = led_strip_build_gamma_table(gamma_table, 2.2f);
+    if (err == ESP_OK)
+    {
+        err = led_strip_set_gamma_table(handle, gamma_table);
+    }
+    if (err == ESP_OK)
+    {
+        err = led_strip_set_brightness(handle, GOLDEN_GAMMA_BRIGHTNESS);
+    }
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+    return render_pattern(handle, scenario);
+}
+
+static esp_err_t render_white_point(led_strip_handle_t handle, const golden_scenario_t *scenario)
+{
+    esp_err_t err = led_strip_set_white_point(handle, white_point);
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+    for (led_strip_pixel_index_t i = 0; i < scenario->led_count; i++)
+    {
+        const led_strip_color_t color = pattern_color(i);
+        err = led_strip_set_pixel_rgb(handle, i, color.r, color.g, color.b);
+        if (err != ESP_OK)
+        {
+            return err;
+        }
+    }
+    return led_strip_flush(handle);
+}
+
+static esp_err_t render_rgb_frame(led_strip_handle_t handle, const golden_scenario_t *scenario)
+{
+    uint8_t *rgb = (uint8_t *)malloc((size_t)scenario->led_count * 3);
+    if (rgb == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    for (led_strip_pixel_index_t i = 0; i < scenario->led_count; i++)
+    {
+        const led_strip_color_t color = pattern_color(i);
+        rgb[i * 3 + 0] = color.r;
+        rgb[i * 3 + 1] = color.g;
+        rgb[i * 3 + 2] = color.b;
+    }
+    esp_err_t err = led_strip_set_pixels_rgb(handle, 0, scenario->led_count, rgb);
+    free(rgb);
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+    return led_strip_flush(handle);
+}
+
+static esp_err_t render_matrix(led_strip_handle_t handle, const golden_scenario_t *scenario)
+{
+    esp_err_t err = led_strip_set_matrix_layout(handle, 16, scenario->led_count / 16, LED_STRIP_MATRIX_LAYOUT_SERPENTINE);
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+    return render_pattern(handle, scenario);
+}
+
+static esp_err_t render_partial(led_strip_handle_t handle, const golden_scenario_t *scenario)
+{
+    esp_err_t err = render_pattern(handle, scenario);
+    if (err == ESP_OK)
+    {
+        err = led_strip_set_pixel_rgb(handle, GOLDEN_PARTIAL_PIXEL, 0x12, 0x34, 0x56);
+    }
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+    return led_strip_flush(handle);
+}
+
+static esp_err_t render_baked(led_strip_handle_t handle, const golden_scenario_t *scenario)
+{
+    esp_err_t err = set_pattern(handle, scenario);
+    if (err == ESP_OK)
+    {
+        err = led_strip_bake_frame(handle, 0);
+    }
+    if (err == ESP_OK)
+    {
+        // The baked frame is sent as it was when it was baked.
+        err = led_strip_fill_rgb(handle, 0, 0, 0);
+    }
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+    return led_strip_flush_baked(handle, 0);
+}
+
+static esp_err_t render_chase(led_strip_handle_t handle, const golden_scenario_t *scenario)
+{
+    led_strip_effect_handle_t effect = NULL;
+    esp_err_t err = led_strip_effect_create(handle, 0, scenario->led_count, &effect);
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+    err = led_strip_effect_chase(effect, chase_color, chase_background, GOLDEN_CHASE_LENGTH, GOLDEN_CHASE_SPEED * 256);
+    // Every frame renders into the back buffer that the flush before brought up to date with a partial copy.
+    for (int frame = 0; frame < GOLDEN_CHASE_FRAMES && err == ESP_OK; frame++)
+    {
+        err = led_strip_effect_render(effect, NULL);
+        if (err == ESP_OK && frame == GOLDEN_CHASE_FRAMES - 1)
+        {
+            // The last pixel makes the last flush send the whole frame, with every pixel an old segment could have left.
+            err = led_strip_set_pixel_rgb(handle, scenario->led_count - 1, chase_background.r, chase_background.g, chase_background.b);
+        }
+        if (err == ESP_OK)
+        {
+            err = led_strip_flush(handle);
+        }
+    }
+    esp_err_t delete_err = led_strip_effect_delete(effect);
+    return err != ESP_OK ? err : delete_err;
+}
+
+static led_strip_color_t expect_pattern(led_strip_pixel_index_t index)
+{
+    return pattern_color(index);
+}
+
+static led_strip_color_t expect_brightness(led_strip_pixel_index_t index)
+{
+    const led_strip_color_t color = pattern_color(index);
+    led_strip_color_t scaled = {
+        .r = scale_level(color.r, GOLDEN_BRIGHTNESS),
+        .g = scale_level(color.g, GOLDEN_BRIGHTNESS),
+        .b = scale_level(color.b, GOLDEN_BRIGHTNESS),
+        .w = scale_level(color.w, GOLDEN_BRIGHTNESS),
+    };
+    return scaled;
+}
+
+static led_strip_color_t expect_gamma(led_strip_pixel_index_t index)
+{
+    // The gamma correction comes before the brightness.
+    const led_strip_color_t color = pattern_color(index);
+    led_strip_color_t corrected = {
+        .r = scale_level(gamma_table[color.r], GOLDEN_GAMMA_BRIGHTNESS),
+        .g = scale_level(gamma_table[color.g], GOLDEN_GAMMA_BRIGHTNESS),
+        .b = scale_level(gamma_table[color.b], GOLDEN_GAMMA_BRIGHTNESS),
+        .w = scale_level(gamma_table[color.w], GOLDEN_GAMMA_BRIGHTNESS),
+    };
+    return corrected;
+}
+
+static led_strip_color_t expect_white_point(led_strip_pixel_index_t index)
+{
+    // The W LED takes the level at which it emits the nearest amount of the component that runs out first, a tie goes
+    // to the lower level.
+    const led_strip_color_t color = pattern_color(index);
+    const double components[3] = {color.r, color.g, color.b};
+    const double point[3] = {white_point.r, white_point.g, white_point.b};
+    double w = 255.0;
+    for (int i = 0; i < 3; i++)
+    {
+        if (point[i] != 0.0)
+        {
+            w = fmin(w, ceil((components[i] * 255.0 / point[i]) - 0.5));
+        }
+    }
+    double left[3];
+    for (int i = 0; i < 3; i++)
+    {
+        left[i] = fmax(0.0, components[i] - round(w * point[i] / 255.0));
+    }
+    led_strip_color_t extracted = {
+        .r = (uint8_t)left[0],
+        .g = (uint8_t)left[1],
+        .b = (uint8_t)left[2],
+        .w = (uint8_t)w,
+    };
+    return extracted;
+}
+
+static led_strip_color_t expect_matrix(led_strip_pixel_index_t index)
+{
+    // Every odd row of the serpentine runs backwards.
+    const led_strip_pixel_index_t width = 16;
+    const led_strip_pixel_index_t y = index / width;
+    const led_strip_pixel_index_t x = (y % 2) == 0 ? index % width : (width - 1) - (index % width);
+    return pattern_color((y * width) + x);
+}
+
+static led_strip_color_t expect_partial(led_strip_pixel_index_t index)
+{
+    if (index == GOLDEN_PARTIAL_PIXEL)
+    {
+        const led_strip_color_t color = {
+            .r = 0x12,
+            .g = 0x34,
+            .b = 0x56,
+            .w = 0x00,
+        };
+        return color;
+    }
+    return pattern_color(index);
+}
+
+static led_strip_color_t expect_chase(led_strip_pixel_index_t index)
+{
+    // The first render already moves the segment.
+    const led_strip_pixel_index_t first = GOLDEN_CHASE_FRAMES * GOLDEN_CHASE_SPEED;
+    return index >= first && index < first + GOLDEN_CHASE_LENGTH ? chase_color : chase_background;
+}
+
+static uint8_t scale_level(uint8_t level, uint8_t brightness)
+{
+    return (uint8_t)lround(level * (double)brightness / 255.0);
+}
+
+static golden_bit_timing_t map_bit_timing(const golden_scenario_t *scenario, uint8_t clk_div)
+{
+    golden_bit_timing_t timing;
+    if (scenario->use_manual_timing)
+    {
+        timing.low_on = GOLDEN_MANUAL_LOW_ON;
+        timing.low_off = GOLDEN_MANUAL_LOW_OFF;
+        timing.high_on = GOLDEN_MANUAL_HIGH_ON;
+        timing.high_off = GOLDEN_MANUAL_HIGH_OFF;
+        return timing;
+    }
+    // The datasheet timings in nanoseconds, rounded to the nearest tick of the channel.
+    const uint64_t ticks_per_second = APB_CLK_FREQ / clk_div;
+    const uint64_t ns[4] = {
+        scenario->type == LED_STRIP_TYPE_SK6822 ? 300 : 350,
+        900,
+        scenario->type == LED_STRIP_TYPE_SK6822 ? 600 : 900,
+        scenario->type == LED_STRIP_TYPE_SK6822 ? 600 : 350,
+    };
+    uint32_t ticks[4];
+    for (int i = 0; i < 4; i++)
+    {
+        ticks[i] = (uint32_t)(((ns[i] * ticks_per_second) + (GOLDEN_NS_PER_SECOND / 2)) / GOLDEN_NS_PER_SECOND);
+    }
+    timing.low_on = ticks[0];
+    timing.low_off = ticks[1];
+    timing.high_on = ticks[2];
+    timing.high_off = ticks[3];
+    return timing;
+}
+
+static void map_wire_bytes(const golden_scenario_t *scenario, led_strip_color_t color, uint8_t *bytes)
+{
+    // The order in which the led strip sends the components, the second and third byte are switched for the RMT.
+    switch (scenario->color_order)
+    {
+    case LED_STRIP_COLOR_ORDER_GRBW:
+        bytes[0] = color.g;
+        bytes[1] = color.b;
+        bytes[2] = color.r;
+        break;
+    case LED_STRIP_COLOR_ORDER_RGBW:
+    default:
+        bytes[0] = color.r;
+        bytes[1] = color.b;
+        bytes[2] = color.g;
+        break;
+    }
+    bytes[3] = color.w;
+}
+
+static bool decode_byte(const golden_bit_timing_t *timing, const rmt_item32_t *items, uint8_t *byte)
+{
+    // The most significant bit is sent first, every bit is a high and a low period.
+    uint8_t value = 0;
+    for (int bit = 0; bit < 8; bit++)
+    {
+        const rmt_item32_t item = items[bit];
+        if (item.level0 != 1 || item.level1 != 0)
+        {
+            return false;
+        }
+        if (item.duration0 == timing->high_on && item.duration1 == timing->high_off)
+        {
+            value = (uint8_t)((value << 1) | 1);
+        }
+        else if (item.duration0 == timing->low_on && item.duration1 == timing->low_off)
+        {
+            value = (uint8_t)(value << 1);
+        }
+        else
+        {
+            return false;
+        }
+    }
+    *byte = value;
+    return true;
+}
+
+static esp_err_t check_bytes(const golden_scenario_t *scenario, const led_strip_sim_transmission_t *transmission)
+{
+    const golden_bit_timing_t timing = map_bit_timing(scenario, transmission->clk_div);
+    const size_t color_size = scenario->enable_w_channel ? 4 : 3;
+    const led_strip_pixel_index_t sent_count = scenario->sent_count != 0 ? scenario->sent_count : scenario->led_count;
+    if (transmission->item_count != sent_count * color_size * 8)
+    {
+        printf("FAIL %s: %zu items, %" PRIu32 " LEDs need %zu\n", scenario->name, transmission->item_count, (uint32_t)sent_count,
+               sent_count * color_size * 8);
+        return ESP_FAIL;
+    }
+    for (led_strip_pixel_index_t i = 0; i < sent_count; i++)
+    {
+        uint8_t expected[4];
+        map_wire_bytes(scenario, scenario->expect(i), expected);
+        for (size_t c = 0; c < color_size; c++)
+        {
+            const size_t item_index = ((i * color_size) + c) * 8;
+            uint8_t byte = 0;
+            if (decode_byte(&timing, transmission->items + item_index, &byte) == false)
+            {
+                printf("FAIL %s: the items from %zu aren't bits of the timing\n", scenario->name, item_index);
+                return ESP_FAIL;
+            }
+            if (byte != expected[c])
+            {
+                printf("FAIL %s: byte %zu of LED %" PRIu32 " is %02x, expected %02x\n", scenario->name, c, (uint32_t)i, byte, expected[c]);
+                return ESP_FAIL;
+            }
+        }
+    }
+    return ESP_OK;
+}
+
+static esp_err_t run_scenario(const golden_scenario_t *scenario, uint8_t mem_block_num, golden_waveform_t *waveform, bool dump)
+{
+    led_strip_config_t config;
+    led_strip_init_config(&config);
+    config.timing_config.timing.type = scenario->type;
+    config.timing_config.use_manual_timing = scenario->use_manual_timing;
+    if (scenario->use_manual_timing)
+    {
+        config.timing_config.timing.manual.low_on = GOLDEN_MANUAL_LOW_ON;
+        config.timing_config.timing.manual.low_off = GOLDEN_MANUAL_LOW_OFF;
+        config.timing_config.timing.manual.high_on = GOLDEN_MANUAL_HIGH_ON;
+        config.timing_config.timing.manual.high_off = GOLDEN_MANUAL_HIGH_OFF;
+        config.timing_config.timing.manual.reset_time = GOLDEN_MANUAL_RESET_TIME;
+    }
+    config.color_order = scenario->color_order;
+    config.gpio_output_num = GOLDEN_GPIO_OUTPUT_NUM;
+    config.led_count = scenario->led_count;
+    config.enable_w_channel = scenario->enable_w_channel;
+    config.mem_block_num = mem_block_num;
+    config.pixel_format = scenario->pixel_format;
+    config.memory_policy = scenario->memory_policy;
+    config.enable_double_buffer = scenario->enable_double_buffer;
+    config.enable_partial_flush = scenario->enable_partial_flush;
+    config.baked_frame_count = scenario->baked_frame_count;
+
+    led_strip_handle_t handle = NULL;
+    esp_err_t err = led_strip_install(&handle, &config);
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+    err = scenario->render(handle, scenario);
+    rmt_channel_t channel = RMT_CHANNEL_MAX;
+    led_strip_sim_transmission_t transmission;
+    if (err == ESP_OK)
+    {
+        err = led_strip_sim_find_channel(GOLDEN_GPIO_OUTPUT_NUM, &channel);
+    }
+    if (err == ESP_OK)
+    {
+        err = led_strip_sim_get_transmission(channel, &transmission);
+    }
+    if (err == ESP_OK && transmission.bytes_left != 0)
+    {
+        printf("FAIL %s: the transmission ended with %zu bytes left\n", scenario->name, transmission.bytes_left);
+        err = ESP_FAIL;
+    }
+    if (err == ESP_OK)
+    {
+        uint64_t hash = FNV_OFFSET_BASIS;
+        for (size_t i = 0; i < transmission.item_count; i++)
+        {
+            const uint32_t value = transmission.items[i].val;
+            for (int b = 0; b < 4; b++)
+            {
+                hash = (hash ^ ((value >> (b * 8)) & 0xFF)) * FNV_PRIME;
+            }
+            if (dump)
+            {
+                const rmt_item32_t item = transmission.items[i];
+                printf("%zu %u %u %u %u\n", i, (unsigned)item.level0, (unsigned)item.duration0, (unsigned)item.level1, (unsigned)item.duration1);
+            }
+        }
+        waveform->item_count = transmission.item_count;
+        waveform->hash = hash;
+        // The hash only tells that the waveform changed, the decoded bytes tell that it is right.
+        err = check_bytes(scenario, &transmission);
+    }
+    esp_err_t free_err = led_strip_free(handle);
+    return err != ESP_OK ? err : free_err;
+}
+
+static bool find_golden(FILE *file, const char *name, golden_waveform_t *waveform)
+{
+    char line[GOLDEN_LINE_SIZE];
+    char line_name[GOLDEN_LINE_SIZE];
+    rewind(file);
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        uint64_t hash = 0;
+        size_t item_count = 0;
+        if (line[0] != '#' && sscanf(line, "%255s %zu %" SCNx64, line_name, &item_count, &hash) == 3 && strcmp(line_name, name) == 0)
+        {
+            waveform->item_count = item_count;
+            waveform->hash = hash;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void print_usage(const char *program)
+{
+    fprintf(stderr, "Usage: %s [--update | --dump <scenario>] [golden file]\n", program);
+    fprintf(stderr, "  Without options every scenario is checked against the golden file.\n");
+    fprintf(stderr, "  --update          Write the current waveforms to the golden file.\n");
+    fprintf(stderr, "  --dump <scenario> Print the items of a scenario: index level0 duration0 level1 duration1.\n");
+}
@@ -0,0 +1,153 @@
+/**
+ * @file rmt.h
+ * @author Giel Willemsen
+ * @brief The legacy ESP-IDF RMT driver for the host build, implemented by the simulator (see led_strip_sim.h).
+ * @version 0.1 2022-09-07 Initial version
+ * @date 2022-09-07
+ *
+ * @copyright
+ * MIT License
+ *
+ * Copyright (c) 2022 Giel Willemsen
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+
+
+#pragma once
+#ifndef LED_STRIP_HOST_DRIVER_RMT_H_
+#define LED_STRIP_HOST_DRIVER_RMT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "soc/soc_caps.h"
+#include "freertos/FreeRTOS.h"
+
+// Macros
+#define RMT_DEFAULT_CONFIG_TX(gpio, channel_id) \
+    {                                           \
+        .rmt_mode = RMT_MODE_TX,                \
+        .channel = (channel_id),                \
+        .gpio_num = (gpio),                     \
+        .clk_div = 80,                          \
+        .mem_block_num = 1,                     \
+        .flags = 0,                             \
+        .tx_config = {                          \
+            .carrier_freq_hz = 38000,           \
+            .carrier_level = 1,                 \
+            .idle_level = 0,                    \
+            .carrier_duty_percent = 33,         \
+            .carrier_en = false,                \
+            .loop_en = false,                   \
+            .idle_output_en = true,             \
+        }                                       \
+    }
+
+// Structs
+typedef enum {
+    RMT_CHANNEL_0,
+    RMT_CHANNEL_1,
+    RMT_CHANNEL_2,
+    RMT_CHANNEL_3,
+    RMT_CHANNEL_4,
+    RMT_CHANNEL_5,
+    RMT_CHANNEL_6,
+    RMT_CHANNEL_7,
+    RMT_CHANNEL_MAX,
+} rmt_channel_t;
+
+typedef enum {
+    RMT_MODE_TX = 0,
+    RMT_MODE_RX,
+    RMT_MODE_MAX,
+} rmt_mode_t;
+
+typedef struct {
+    union {
+        struct {
+            uint32_t duration0 : 15;
+            uint32_t level0 : 1;
+            uint32_t duration1 : 15;
+            uint32_t level1 : 1;
+        };
+        uint32_t val;
+    };
+} rmt_item32_t;
+
+typedef struct {
+    uint32_t carrier_freq_hz;
+    uint32_t carrier_level;
+    uint32_t idle_level;
+    uint8_t carrier_duty_percent;
+    bool carrier_en;
+    bool loop_en;
+    bool idle_output_en;
+} rmt_tx_config_t;
+
+typedef struct {
+    rmt_mode_t rmt_mode;
+    rmt_channel_t channel;
+    int gpio_num;
+    uint8_t clk_div;
+    uint8_t mem_block_num;
+    uint32_t flags;
+    rmt_tx_config_t tx_config;
+} rmt_config_t;
+
+typedef void (*sample_to_rmt_t)(const void *src, rmt_item32_t *dest, size_t src_size, size_t wanted_num, size_t *translated_size, size_t *item_num);
+typedef void (*rmt_tx_end_fn_t)(rmt_channel_t channel, void *arg);
+
+typedef struct {
+    rmt_tx_end_fn_t function;
+    void *arg;
+} rmt_tx_end_callback_t;
+
+// Functions
+extern esp_err_t rmt_config(const rmt_config_t *rmt_param);
+extern esp_err_t rmt_driver_install(rmt_channel_t channel, size_t rx_buf_size, int intr_alloc_flags);
+extern esp_err_t rmt_driver_uninstall(rmt_channel_t channel);
+extern esp_err_t rmt_translator_init(rmt_channel_t channel, sample_to_rmt_t fn);
+extern esp_err_t rmt_translator_set_context(rmt_channel_t channel, void *context);
+extern esp_err_t rmt_translator_get_context(const size_t *item_num, void **context);
+extern esp_err_t rmt_set_tx_loop_mode(rmt_channel_t channel, bool loop_en);
+extern esp_err_t rmt_set_tx_intr_en(rmt_channel_t channel, bool en);
+extern esp_err_t rmt_add_channel_to_group(rmt_channel_t channel);
+extern esp_err_t rmt_remove_channel_from_group(rmt_channel_t channel);
+extern rmt_tx_end_callback_t rmt_register_tx_end_callback(rmt_tx_end_fn_t function, void *arg);
+
+/**
+ * @brief Translate and "send" a sample. The translator is called like the driver does on the target, a first time for
+ *        all memory blocks of the channel and then for half of them per refill, and the whole transmission completes
+ *        before this returns.
+ * 
+ * @param channel The channel to send on.
+ * @param src The sample to translate.
+ * @param src_size The size of the sample in bytes.
+ * @param wait_tx_done Ignored, the transmission is already done.
+ * @return esp_err_t ESP_OK, ESP_FAIL if the driver or the translator isn't installed.
+ */
+extern esp_err_t rmt_write_sample(rmt_channel_t channel, const uint8_t *src, size_t src_size, bool wait_tx_done);
+extern esp_err_t rmt_write_items(rmt_channel_t channel, const rmt_item32_t *rmt_item, int item_num, bool wait_tx_done);
+extern esp_err_t rmt_wait_tx_done(rmt_channel_t channel, TickType_t wait_time);
+
+#endif // LED_STRIP_HOST_DRIVER_RMT_H_
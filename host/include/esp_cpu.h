@@ -0,0 +1,59 @@
+/**
+ * @file esp_cpu.h
+ * @author Giel Willemsen
+ * @brief The ESP-IDF cycle counter for the host build.
+ * @version 0.1 2022-09-07 Initial version
+ * @date 2022-09-07
+ *
+ * @copyright
+ * MIT License
+ *
+ * Copyright (c) 2022 Giel Willemsen
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+
+
+#pragma once
+#ifndef LED_STRIP_HOST_ESP_CPU_H_
+#define LED_STRIP_HOST_ESP_CPU_H_
+
+#include <stdint.h>
+
+// Structs
+typedef uint32_t esp_cpu_cycle_count_t;
+
+// Functions
+/**
+ * @brief Get the cycle count, on the host a cycle is a nanosecond of the monotonic clock.
+ * 
+ * @return esp_cpu_cycle_count_t The cycle count, it wraps like the 32 bit counter of the target.
+ */
+extern esp_cpu_cycle_count_t esp_cpu_get_cycle_count(void);
+
+/**
+ * @brief Get the cycle count, the name of ESP-IDF 4.x.
+ * 
+ * @return uint32_t The cycle count, see esp_cpu_get_cycle_count.
+ */
+extern uint32_t esp_cpu_get_ccount(void);
+
+#endif // LED_STRIP_HOST_ESP_CPU_H_
@@ -0,0 +1,92 @@
+/**
+ * @file esp_err.h
+ * @author Giel Willemsen
+ * @brief The ESP-IDF error codes for the host build.
+ * @version 0.1 2022-09-07 Initial version
+ * @date 2022-09-07
+ *
+ * @copyright
+ * MIT License
+ *
+ * Copyright (c) 2022 Giel Willemsen
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+
+
+#pragma once
+#ifndef LED_STRIP_HOST_ESP_ERR_H_
+#define LED_STRIP_HOST_ESP_ERR_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+// Macros
+#define ESP_OK 0
+#define ESP_FAIL -1
+#define ESP_ERR_NO_MEM 0x101
+#define ESP_ERR_INVALID_ARG 0x102
+#define ESP_ERR_INVALID_STATE 0x103
+#define ESP_ERR_INVALID_SIZE 0x104
+#define ESP_ERR_NOT_FOUND 0x105
+#define ESP_ERR_NOT_SUPPORTED 0x106
+#define ESP_ERR_TIMEOUT 0x107
+#define ESP_ERR_INVALID_RESPONSE 0x108
+#define ESP_ERR_INVALID_CRC 0x109
+#define ESP_ERR_INVALID_VERSION 0x10A
+#define ESP_ERR_INVALID_MAC 0x10B
+#define ESP_ERR_NOT_FINISHED 0x10C
+
+/// Like on the target, the failed check is printed and the error code is the value of the expression.
+#define ESP_ERROR_CHECK_WITHOUT_ABORT(x) ({                                         \
+        esp_err_t err_rc_ = (x);                                                    \
+        if (err_rc_ != ESP_OK)                                                      \
+        {                                                                           \
+            fprintf(stderr, "ESP_ERROR_CHECK_WITHOUT_ABORT failed: esp_err_t 0x%x (%s) at %s:%d\n", \
+                    (unsigned)err_rc_, esp_err_to_name(err_rc_), __FILE__, __LINE__); \
+        }                                                                           \
+        err_rc_;                                                                    \
+    })
+
+#define ESP_ERROR_CHECK(x) do {                                                     \
+        esp_err_t err_rc_ = (x);                                                    \
+        if (err_rc_ != ESP_OK)                                                      \
+        {                                                                           \
+            fprintf(stderr, "ESP_ERROR_CHECK failed: esp_err_t 0x%x (%s) at %s:%d\n", \
+                    (unsigned)err_rc_, esp_err_to_name(err_rc_), __FILE__, __LINE__); \
+            abort();                                                                \
+        }                                                                           \
+    } while (0)
+
+// Structs
+typedef int esp_err_t;
+
+// Functions
+/**
+ * @brief Get the name of an error code.
+ * 
+ * @param code The error code.
+ * @return const char* The name, or "UNKNOWN ERROR" for a code the host build doesn't know.
+ */
+extern const char *esp_err_to_name(esp_err_t code);
+
+#endif // LED_STRIP_HOST_ESP_ERR_H_
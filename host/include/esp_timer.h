@@ -0,0 +1,75 @@
+/**
+ * @file esp_timer.h
+ * @author Giel Willemsen
+ * @brief The ESP-IDF high resolution timer for the host build, timers can be created but never fire.
+ * @version 0.1 2022-09-07 Initial version
+ * @date 2022-09-07
+ *
+ * @copyright
+ * MIT License
+ *
+ * Copyright (c) 2022 Giel Willemsen
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+
+
+#pragma once
+#ifndef LED_STRIP_HOST_ESP_TIMER_H_
+#define LED_STRIP_HOST_ESP_TIMER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+// Forward declares
+typedef struct esp_timer *esp_timer_handle_t;
+
+// Structs
+typedef void (*esp_timer_cb_t)(void *arg);
+
+typedef enum {
+    ESP_TIMER_TASK,
+    ESP_TIMER_ISR,
+} esp_timer_dispatch_t;
+
+typedef struct {
+    esp_timer_cb_t callback;
+    void *arg;
+    esp_timer_dispatch_t dispatch_method;
+    const char *name;
+    bool skip_unhandled_events;
+} esp_timer_create_args_t;
+
+// Functions
+/**
+ * @brief Get the time of the monotonic clock.
+ * 
+ * @return int64_t The time in microseconds.
+ */
+extern int64_t esp_timer_get_time(void);
+extern esp_err_t esp_timer_create(const esp_timer_create_args_t *create_args, esp_timer_handle_t *out_handle);
+extern esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us);
+extern esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period);
+extern esp_err_t esp_timer_stop(esp_timer_handle_t timer);
+extern esp_err_t esp_timer_delete(esp_timer_handle_t timer);
+
+#endif // LED_STRIP_HOST_ESP_TIMER_H_
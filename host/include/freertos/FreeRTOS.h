@@ -0,0 +1,93 @@
+/**
+ * @file FreeRTOS.h
+ * @author Giel Willemsen
+ * @brief The FreeRTOS types for the host build.
+ * @version 0.1 2022-09-07 Initial version
+ * @date 2022-09-07
+ *
+ * @copyright
+ * MIT License
+ *
+ * Copyright (c) 2022 Giel Willemsen
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+
+
+#pragma once
+#ifndef LED_STRIP_HOST_FREERTOS_H_
+#define LED_STRIP_HOST_FREERTOS_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include "sdkconfig.h"
+
+// Macros
+#define pdFALSE ((BaseType_t)0)
+#define pdTRUE ((BaseType_t)1)
+#define pdFAIL pdFALSE
+#define pdPASS pdTRUE
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+#define portTICK_PERIOD_MS ((TickType_t)1000 / CONFIG_FREERTOS_HZ)
+#define pdMS_TO_TICKS(ms) ((TickType_t)(((uint64_t)(ms) * CONFIG_FREERTOS_HZ) / 1000))
+#define pdTICKS_TO_MS(ticks) ((uint32_t)(((uint64_t)(ticks) * 1000) / CONFIG_FREERTOS_HZ))
+#define tskNO_AFFINITY ((BaseType_t)0x7FFFFFFF)
+#define portNUM_PROCESSORS 1
+
+/// There is one thread and the simulated interrupts run on it, so the critical sections don't have to lock anything.
+#define portMUX_INITIALIZER_UNLOCKED {.owner = 0xB33FFFFF, .count = 0}
+#define portMUX_INITIALIZE(mux) do { (mux)->owner = 0xB33FFFFF; (mux)->count = 0; } while (0)
+#define portENTER_CRITICAL(mux) do { (void)(mux); } while (0)
+#define portEXIT_CRITICAL(mux) do { (void)(mux); } while (0)
+#define portENTER_CRITICAL_ISR(mux) do { (void)(mux); } while (0)
+#define portEXIT_CRITICAL_ISR(mux) do { (void)(mux); } while (0)
+#define portENTER_CRITICAL_SAFE(mux) do { (void)(mux); } while (0)
+#define portEXIT_CRITICAL_SAFE(mux) do { (void)(mux); } while (0)
+#define portYIELD_FROM_ISR(...) do { } while (0)
+
+#define __containerof(ptr, type, member) ((type *)((char *)(ptr) - offsetof(type, member)))
+
+// Structs
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+typedef struct {
+    uint32_t owner;
+    uint32_t count;
+} portMUX_TYPE;
+
+// Functions
+/**
+ * @brief Check if the caller runs in a simulated interrupt, like the refills and the TX end callback of the simulated RMT driver.
+ * 
+ * @return BaseType_t pdTRUE in a simulated interrupt.
+ */
+extern BaseType_t xPortInIsrContext(void);
+
+/**
+ * @brief Get the core of the caller.
+ * 
+ * @return BaseType_t Always 0, the host simulates a single core.
+ */
+extern BaseType_t xPortGetCoreID(void);
+
+#endif // LED_STRIP_HOST_FREERTOS_H_
@@ -0,0 +1,56 @@
+/**
+ * @file event_groups.h
+ * @author Giel Willemsen
+ * @brief The FreeRTOS event groups for the host build. A wait that isn't satisfied times out immediately.
+ * @version 0.1 2022-09-07 Initial version
+ * @date 2022-09-07
+ *
+ * @copyright
+ * MIT License
+ *
+ * Copyright (c) 2022 Giel Willemsen
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+
+
+#pragma once
+#ifndef LED_STRIP_HOST_FREERTOS_EVENT_GROUPS_H_
+#define LED_STRIP_HOST_FREERTOS_EVENT_GROUPS_H_
+
+#include "freertos/FreeRTOS.h"
+
+// Forward declares
+typedef struct sim_event_group *EventGroupHandle_t;
+
+// Structs
+typedef uint32_t EventBits_t;
+
+// Functions
+extern EventGroupHandle_t xEventGroupCreate(void);
+extern void vEventGroupDelete(EventGroupHandle_t event_group);
+extern EventBits_t xEventGroupSetBits(EventGroupHandle_t event_group, EventBits_t bits);
+extern BaseType_t xEventGroupSetBitsFromISR(EventGroupHandle_t event_group, EventBits_t bits, BaseType_t *higher_priority_task_woken);
+extern EventBits_t xEventGroupClearBits(EventGroupHandle_t event_group, EventBits_t bits);
+extern EventBits_t xEventGroupGetBits(EventGroupHandle_t event_group);
+extern EventBits_t xEventGroupWaitBits(EventGroupHandle_t event_group, EventBits_t bits, BaseType_t clear_on_exit, BaseType_t wait_for_all, TickType_t ticks_to_wait);
+
+#endif // LED_STRIP_HOST_FREERTOS_EVENT_GROUPS_H_
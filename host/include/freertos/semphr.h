@@ -0,0 +1,53 @@
+/**
+ * @file semphr.h
+ * @author Giel Willemsen
+ * @brief The FreeRTOS semaphores for the host build. A take that would block times out immediately, nothing else could give it.
+ * @version 0.1 2022-09-07 Initial version
+ * @date 2022-09-07
+ *
+ * @copyright
+ * MIT License
+ *
+ * Copyright (c) 2022 Giel Willemsen
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+
+
+#pragma once
+#ifndef LED_STRIP_HOST_FREERTOS_SEMPHR_H_
+#define LED_STRIP_HOST_FREERTOS_SEMPHR_H_
+
+#include "freertos/FreeRTOS.h"
+
+// Forward declares
+typedef struct sim_semaphore *SemaphoreHandle_t;
+
+// Functions
+extern SemaphoreHandle_t xSemaphoreCreateBinary(void);
+extern SemaphoreHandle_t xSemaphoreCreateMutex(void);
+extern SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max_count, UBaseType_t initial_count);
+extern BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks_to_wait);
+extern BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore);
+extern BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t semaphore, BaseType_t *higher_priority_task_woken);
+extern void vSemaphoreDelete(SemaphoreHandle_t semaphore);
+
+#endif // LED_STRIP_HOST_FREERTOS_SEMPHR_H_
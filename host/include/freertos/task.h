@@ -0,0 +1,90 @@
+/**
+ * @file task.h
+ * @author Giel Willemsen
+ * @brief The FreeRTOS tasks for the host build. Task notifications work, but tasks can't be created.
+ * @version 0.1 2022-09-07 Initial version
+ * @date 2022-09-07
+ *
+ * @copyright
+ * MIT License
+ *
+ * Copyright (c) 2022 Giel Willemsen
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+
+
+#pragma once
+#ifndef LED_STRIP_HOST_FREERTOS_TASK_H_
+#define LED_STRIP_HOST_FREERTOS_TASK_H_
+
+#include "freertos/FreeRTOS.h"
+
+// Forward declares
+typedef struct sim_task *TaskHandle_t;
+
+// Structs
+typedef void (*TaskFunction_t)(void *arg);
+
+typedef enum {
+    eNoAction = 0,
+    eSetBits,
+    eIncrement,
+    eSetValueWithOverwrite,
+    eSetValueWithoutOverwrite,
+} eNotifyAction;
+
+// Functions
+/**
+ * @brief Tasks aren't simulated, so the refresh, scheduler and output tasks of the led strip can't be started.
+ * 
+ * @return BaseType_t Always pdFAIL.
+ */
+extern BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char *name, uint32_t stack_depth, void *arg, UBaseType_t priority, TaskHandle_t *created_task, BaseType_t core_id);
+extern BaseType_t xTaskCreate(TaskFunction_t function, const char *name, uint32_t stack_depth, void *arg, UBaseType_t priority, TaskHandle_t *created_task);
+extern void vTaskDelete(TaskHandle_t task);
+extern void vTaskDelay(TickType_t ticks);
+extern void taskYIELD(void);
+
+/**
+ * @brief Get the handle of the one task of the host, it can be used as target of task notifications.
+ * 
+ * @return TaskHandle_t The handle of the calling thread.
+ */
+extern TaskHandle_t xTaskGetCurrentTaskHandle(void);
+extern BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value, eNotifyAction action);
+extern BaseType_t xTaskNotifyFromISR(TaskHandle_t task, uint32_t value, eNotifyAction action, BaseType_t *higher_priority_task_woken);
+extern BaseType_t xTaskNotifyGive(TaskHandle_t task);
+extern void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *higher_priority_task_woken);
+
+/**
+ * @brief Wait for a notification of the calling task, nothing can notify it while it waits so a missing notification times out immediately.
+ * 
+ * @param bits_to_clear_on_entry The bits to clear before checking.
+ * @param bits_to_clear_on_exit The bits to clear after a notification was received.
+ * @param notification_value Set to the notification value if not NULL.
+ * @param ticks_to_wait Ignored.
+ * @return BaseType_t pdTRUE if a notification was pending.
+ */
+extern BaseType_t xTaskNotifyWait(uint32_t bits_to_clear_on_entry, uint32_t bits_to_clear_on_exit, uint32_t *notification_value, TickType_t ticks_to_wait);
+extern uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks_to_wait);
+
+#endif // LED_STRIP_HOST_FREERTOS_TASK_H_
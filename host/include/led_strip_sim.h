@@ -0,0 +1,83 @@
+/**
+ * @file led_strip_sim.h
+ * @author Giel Willemsen
+ * @brief Inspection of the simulated RMT driver of the host build.
+ * @version 0.1 2022-09-07 Initial version
+ * @date 2022-09-07
+ *
+ * @copyright
+ * MIT License
+ *
+ * Copyright (c) 2022 Giel Willemsen
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+
+
+#pragma once
+#ifndef LED_STRIP_SIM_H_
+#define LED_STRIP_SIM_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <esp_err.h>
+#include <driver/rmt.h>
+
+// Structs
+typedef struct led_strip_sim_transmission {
+    const rmt_item32_t *items;  ///< The items of the last transmission in the order they were sent, without the end marker. Valid until the next transmission on the channel.
+    size_t item_count;
+    size_t bytes_left;          ///< The bytes of the sample that weren't sent because a refill came back short, 0 for a complete transmission.
+    uint32_t translator_calls;  ///< The translator invocations of the last transmission, 0 for rmt_write_items.
+    uint32_t transmissions;     ///< The transmissions since the channel was installed.
+    uint8_t clk_div;            ///< The clock divider of the channel, the durations of the items are in ticks of APB_CLK_FREQ / clk_div.
+    int gpio_num;
+} led_strip_sim_transmission_t;
+
+// Functions
+/**
+ * @brief Find the channel that drives a GPIO, the led strip handles don't tell which channel they got.
+ * 
+ * @param gpio_num The gpio_output_num of the led strip.
+ * @param channel Set to the installed channel with that GPIO.
+ * @return esp_err_t ESP_OK if found, ESP_ERR_NOT_FOUND if no installed channel has that GPIO.
+ */
+extern esp_err_t led_strip_sim_find_channel(int gpio_num, rmt_channel_t *channel);
+
+/**
+ * @brief Get the items of the last transmission on a channel.
+ * 
+ * @param channel The channel to get the transmission of.
+ * @param transmission Filled with the last transmission.
+ * @return esp_err_t ESP_OK, ESP_ERR_INVALID_ARG for an invalid channel and ESP_ERR_INVALID_STATE if it isn't installed.
+ */
+extern esp_err_t led_strip_sim_get_transmission(rmt_channel_t channel, led_strip_sim_transmission_t *transmission);
+
+/**
+ * @brief Enable or disable recording the items, recording is enabled by default. Benchmarks disable it so only the
+ *        translator is measured, the translator still runs for every item.
+ * 
+ * @param enabled true to record the items of the transmissions.
+ */
+extern void led_strip_sim_set_recording(bool enabled);
+
+#endif // LED_STRIP_SIM_H_
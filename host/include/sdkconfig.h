@@ -0,0 +1,82 @@
+/**
+ * @file sdkconfig.h
+ * @author Giel Willemsen
+ * @brief The configuration of the host build, the defaults of the Kconfig of the component.
+ * @version 0.1 2022-09-07 Initial version
+ * @date 2022-09-07
+ *
+ * @copyright
+ * MIT License
+ *
+ * Copyright (c) 2022 Giel Willemsen
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+
+
+#pragma once
+#ifndef LED_STRIP_HOST_SDKCONFIG_H_
+#define LED_STRIP_HOST_SDKCONFIG_H_
+
+// Every option can be overridden from the command line, see the LED_STRIP_HOST_CONFIG cache variable in CMakeLists.txt.
+
+// Macros
+#define CONFIG_FREERTOS_UNICORE 1 ///< The host simulates a single core.
+#define CONFIG_FREERTOS_HZ 1000
+
+#if CONFIG_LED_STRIP_RMT_DRIVER_ENCODER
+#error "The host build only simulates the legacy RMT driver."
+#endif
+#define CONFIG_LED_STRIP_RMT_DRIVER_LEGACY 1
+
+#if !CONFIG_LED_STRIP_SYMBOL_LUT_FULL
+#define CONFIG_LED_STRIP_SYMBOL_LUT_NIBBLE 1
+#endif
+
+#if !CONFIG_LED_STRIP_FIXED_COLOR_ORDER_RGB && !CONFIG_LED_STRIP_FIXED_COLOR_ORDER_GRB && !CONFIG_LED_STRIP_FIXED_COLOR_ORDER_RGBW && !CONFIG_LED_STRIP_FIXED_COLOR_ORDER_GRBW
+#define CONFIG_LED_STRIP_FIXED_COLOR_ORDER_RUNTIME 1
+#endif
+
+#if !CONFIG_LED_STRIP_FIXED_TIMING_SK6822 && !CONFIG_LED_STRIP_FIXED_TIMING_WS281X
+#define CONFIG_LED_STRIP_FIXED_TIMING_RUNTIME 1
+#endif
+
+#ifndef CONFIG_LED_STRIP_BOUNCE_BUFFER_SIZE
+#define CONFIG_LED_STRIP_BOUNCE_BUFFER_SIZE 512
+#endif
+
+#ifndef CONFIG_LED_STRIP_REFRESH_TASK_STACK_SIZE
+#define CONFIG_LED_STRIP_REFRESH_TASK_STACK_SIZE 2560
+#endif
+
+#ifndef CONFIG_LED_STRIP_SCHEDULER_TASK_STACK_SIZE
+#define CONFIG_LED_STRIP_SCHEDULER_TASK_STACK_SIZE 3072
+#endif
+
+#ifndef CONFIG_LED_STRIP_OUTPUT_TASK_STACK_SIZE
+#define CONFIG_LED_STRIP_OUTPUT_TASK_STACK_SIZE 3072
+#endif
+
+#ifndef CONFIG_LED_STRIP_HOT_PATH_ERROR_LOG
+#define CONFIG_LED_STRIP_HOT_PATH_ERROR_LOG 1
+#endif
+
+#endif // LED_STRIP_HOST_SDKCONFIG_H_
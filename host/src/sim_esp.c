@@ -0,0 +1,179 @@
+/**
+ * @file sim_esp.c
+ * @author Giel Willemsen
+ * @brief The ESP-IDF system functions of the host build: error names, heap, clocks and timers.
+ * @version 0.1 2022-09-07 Initial version
+ * @date 2022-09-07
+ *
+ * @copyright
+ * MIT License
+ *
+ * Copyright (c) 2022 Giel Willemsen
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <esp_err.h>
+#include <esp_cpu.h>
+#include <esp_heap_caps.h>
+#include <esp_memory_utils.h>
+#include <esp_rom_sys.h>
+#include <esp_timer.h>
+
+#define ERR_NAME(code) { code, #code }
+
+typedef struct err_name
+{
+    esp_err_t code;
+    const char *name;
+} err_name_t;
+
+struct esp_timer
+{
+    esp_timer_create_args_t args;
+};
+
+static uint64_t monotonic_ns(void);
+
+static uint64_t delayed_ns = 0; ///< The busy waits that were skipped, nothing is on a wire so there's nothing to wait for.
+
+static const err_name_t err_names[] = {
+    ERR_NAME(ESP_OK),
+    ERR_NAME(ESP_FAIL),
+    ERR_NAME(ESP_ERR_NO_MEM),
+    ERR_NAME(ESP_ERR_INVALID_ARG),
+    ERR_NAME(ESP_ERR_INVALID_STATE),
+    ERR_NAME(ESP_ERR_INVALID_SIZE),
+    ERR_NAME(ESP_ERR_NOT_FOUND),
+    ERR_NAME(ESP_ERR_NOT_SUPPORTED),
+    ERR_NAME(ESP_ERR_TIMEOUT),
+    ERR_NAME(ESP_ERR_INVALID_RESPONSE),
+    ERR_NAME(ESP_ERR_INVALID_CRC),
+    ERR_NAME(ESP_ERR_INVALID_VERSION),
+    ERR_NAME(ESP_ERR_INVALID_MAC),
+    ERR_NAME(ESP_ERR_NOT_FINISHED),
+};
+
+extern const char *esp_err_to_name(esp_err_t code)
+{
+    for (size_t i = 0; i < sizeof(err_names) / sizeof(err_names[0]); i++)
+    {
+        if (err_names[i].code == code)
+        {
+            return err_names[i].name;
+        }
+    }
+    return "UNKNOWN ERROR";
+}
+
+extern esp_cpu_cycle_count_t esp_cpu_get_cycle_count(void)
+{
+    return (esp_cpu_cycle_count_t)monotonic_ns();
+}
+
+extern uint32_t esp_cpu_get_ccount(void)
+{
+    return (uint32_t)monotonic_ns();
+}
+
+extern void *heap_caps_malloc(size_t size, uint32_t caps)
+{
+    return malloc(size);
+}
+
+extern void *heap_caps_calloc(size_t n, size_t size, uint32_t caps)
+{
+    return calloc(n, size);
+}
+
+extern void heap_caps_free(void *ptr)
+{
+    free(ptr);
+}
+
+extern bool esp_ptr_internal(const void *ptr)
+{
+    return true;
+}
+
+extern void esp_rom_delay_us(uint32_t us)
+{
+    delayed_ns += (uint64_t)us * 1000;
+}
+
+extern int64_t esp_timer_get_time(void)
+{
+    return (int64_t)(monotonic_ns() / 1000);
+}
+
+extern esp_err_t esp_timer_create(const esp_timer_create_args_t *create_args, esp_timer_handle_t *out_handle)
+{
+    if (create_args == NULL || create_args->callback == NULL || out_handle == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_timer_handle_t timer = (esp_timer_handle_t)calloc(1, sizeof(struct esp_timer));
+    if (timer == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    timer->args = *create_args;
+    *out_handle = timer;
+    return ESP_OK;
+}
+
+extern esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us)
+{
+    return timer == NULL ? ESP_ERR_INVALID_ARG : ESP_OK;
+}
+
+extern esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period)
+{
+    return timer == NULL ? ESP_ERR_INVALID_ARG : ESP_OK;
+}
+
+extern esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+    return timer == NULL ? ESP_ERR_INVALID_ARG : ESP_OK;
+}
+
+extern esp_err_t esp_timer_delete(esp_timer_handle_t timer)
+{
+    if (timer == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    free(timer);
+    return ESP_OK;
+}
+
+// Private functions
+
+static uint64_t monotonic_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec + delayed_ns;
+}
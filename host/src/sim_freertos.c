@@ -0,0 +1,291 @@
+/**
+ * @file sim_freertos.c
+ * @author Giel Willemsen
+ * @brief The FreeRTOS primitives of the host build, for a single thread.
+ * @version 0.1 2022-09-07 Initial version
+ * @date 2022-09-07
+ *
+ * @copyright
+ * MIT License
+ *
+ * Copyright (c) 2022 Giel Willemsen
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#include <freertos/event_groups.h>
+#include "sim_private.h"
+
+struct sim_semaphore
+{
+    UBaseType_t count;
+    UBaseType_t max_count;
+};
+
+struct sim_event_group
+{
+    EventBits_t bits;
+};
+
+struct sim_task
+{
+    uint32_t notification_value;
+    bool notification_pending;
+};
+
+static SemaphoreHandle_t create_semaphore(UBaseType_t max_count, UBaseType_t initial_count);
+static BaseType_t notify(TaskHandle_t task, uint32_t value, eNotifyAction action);
+
+static struct sim_task main_task;
+static int isr_nesting = 0;
+
+extern BaseType_t xPortInIsrContext(void)
+{
+    return isr_nesting > 0 ? pdTRUE : pdFALSE;
+}
+
+extern BaseType_t xPortGetCoreID(void)
+{
+    return 0;
+}
+
+extern BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char *name, uint32_t stack_depth, void *arg, UBaseType_t priority, TaskHandle_t *created_task, BaseType_t core_id)
+{
+    return pdFAIL;
+}
+
+extern BaseType_t xTaskCreate(TaskFunction_t function, const char *name, uint32_t stack_depth, void *arg, UBaseType_t priority, TaskHandle_t *created_task)
+{
+    return pdFAIL;
+}
+
+extern void vTaskDelete(TaskHandle_t task)
+{
+}
+
+extern void vTaskDelay(TickType_t ticks)
+{
+}
+
+extern void taskYIELD(void)
+{
+}
+
+extern TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return &main_task;
+}
+
+extern BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value, eNotifyAction action)
+{
+    return notify(task, value, action);
+}
+
+extern BaseType_t xTaskNotifyFromISR(TaskHandle_t task, uint32_t value, eNotifyAction action, BaseType_t *higher_priority_task_woken)
+{
+    return notify(task, value, action);
+}
+
+extern BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    return notify(task, 0, eIncrement);
+}
+
+extern void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *higher_priority_task_woken)
+{
+    notify(task, 0, eIncrement);
+}
+
+extern BaseType_t xTaskNotifyWait(uint32_t bits_to_clear_on_entry, uint32_t bits_to_clear_on_exit, uint32_t *notification_value, TickType_t ticks_to_wait)
+{
+    main_task.notification_value &= ~bits_to_clear_on_entry;
+    if (main_task.notification_pending == false)
+    {
+        return pdFALSE;
+    }
+    if (notification_value != NULL)
+    {
+        *notification_value = main_task.notification_value;
+    }
+    main_task.notification_value &= ~bits_to_clear_on_exit;
+    main_task.notification_pending = false;
+    return pdTRUE;
+}
+
+extern uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks_to_wait)
+{
+    const uint32_t value = main_task.notification_value;
+    if (value != 0)
+    {
+        main_task.notification_value = clear_on_exit == pdTRUE ? 0 : value - 1;
+    }
+    main_task.notification_pending = false;
+    return value;
+}
+
+extern SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+    return create_semaphore(1, 0);
+}
+
+extern SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    return create_semaphore(1, 1);
+}
+
+extern SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max_count, UBaseType_t initial_count)
+{
+    return create_semaphore(max_count, initial_count);
+}
+
+extern BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks_to_wait)
+{
+    if (semaphore->count == 0)
+    {
+        return pdFALSE;
+    }
+    semaphore->count--;
+    return pdTRUE;
+}
+
+extern BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore)
+{
+    if (semaphore->count == semaphore->max_count)
+    {
+        return pdFALSE;
+    }
+    semaphore->count++;
+    return pdTRUE;
+}
+
+extern BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t semaphore, BaseType_t *higher_priority_task_woken)
+{
+    return xSemaphoreGive(semaphore);
+}
+
+extern void vSemaphoreDelete(SemaphoreHandle_t semaphore)
+{
+    free(semaphore);
+}
+
+extern EventGroupHandle_t xEventGroupCreate(void)
+{
+    return (EventGroupHandle_t)calloc(1, sizeof(struct sim_event_group));
+}
+
+extern void vEventGroupDelete(EventGroupHandle_t event_group)
+{
+    free(event_group);
+}
+
+extern EventBits_t xEventGroupSetBits(EventGroupHandle_t event_group, EventBits_t bits)
+{
+    event_group->bits |= bits;
+    return event_group->bits;
+}
+
+extern BaseType_t xEventGroupSetBitsFromISR(EventGroupHandle_t event_group, EventBits_t bits, BaseType_t *higher_priority_task_woken)
+{
+    xEventGroupSetBits(event_group, bits);
+    return pdPASS;
+}
+
+extern EventBits_t xEventGroupClearBits(EventGroupHandle_t event_group, EventBits_t bits)
+{
+    const EventBits_t previous = event_group->bits;
+    event_group->bits &= ~bits;
+    return previous;
+}
+
+extern EventBits_t xEventGroupGetBits(EventGroupHandle_t event_group)
+{
+    return event_group->bits;
+}
+
+extern EventBits_t xEventGroupWaitBits(EventGroupHandle_t event_group, EventBits_t bits, BaseType_t clear_on_exit, BaseType_t wait_for_all, TickType_t ticks_to_wait)
+{
+    const EventBits_t current = event_group->bits;
+    const bool satisfied = wait_for_all == pdTRUE ? (current & bits) == bits : (current & bits) != 0;
+    if (satisfied && clear_on_exit == pdTRUE)
+    {
+        event_group->bits &= ~bits;
+    }
+    return current;
+}
+
+// Shared functions
+
+extern void sim_isr_enter(void)
+{
+    isr_nesting++;
+}
+
+extern void sim_isr_exit(void)
+{
+    isr_nesting--;
+}
+
+// Private functions
+
+static SemaphoreHandle_t create_semaphore(UBaseType_t max_count, UBaseType_t initial_count)
+{
+    SemaphoreHandle_t semaphore = (SemaphoreHandle_t)calloc(1, sizeof(struct sim_semaphore));
+    if (semaphore != NULL)
+    {
+        semaphore->max_count = max_count;
+        semaphore->count = initial_count;
+    }
+    return semaphore;
+}
+
+static BaseType_t notify(TaskHandle_t task, uint32_t value, eNotifyAction action)
+{
+    switch (action)
+    {
+    case eSetBits:
+        task->notification_value |= value;
+        break;
+    case eIncrement:
+        task->notification_value++;
+        break;
+    case eSetValueWithOverwrite:
+        task->notification_value = value;
+        break;
+    case eSetValueWithoutOverwrite:
+        if (task->notification_pending)
+        {
+            return pdFAIL;
+        }
+        task->notification_value = value;
+        break;
+    case eNoAction:
+    default:
+        break;
+    }
+    task->notification_pending = true;
+    return pdPASS;
+}
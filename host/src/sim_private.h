@@ -0,0 +1,54 @@
+/**
+ * @file sim_private.h
+ * @author Giel Willemsen
+ * @brief The state that the simulated drivers of the host build share.
+ * @version 0.1 2022-09-07 Initial version
+ * @date 2022-09-07
+ *
+ * @copyright
+ * MIT License
+ *
+ * Copyright (c) 2022 Giel Willemsen
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+
+
+#pragma once
+#ifndef LED_STRIP_SIM_PRIVATE_H_
+#define LED_STRIP_SIM_PRIVATE_H_
+
+#include <stdbool.h>
+
+// Functions
+/**
+ * @brief Mark the start of a simulated interrupt, xPortInIsrContext returns pdTRUE until sim_isr_exit.
+ * 
+ */
+extern void sim_isr_enter(void);
+
+/**
+ * @brief Mark the end of a simulated interrupt.
+ * 
+ */
+extern void sim_isr_exit(void);
+
+#endif // LED_STRIP_SIM_PRIVATE_H_
@@ -0,0 +1,363 @@
+/**
+ * @file sim_rmt.c
+ * @author Giel Willemsen
+ * @brief The simulated legacy RMT driver of the host build, it records the items that the translator generates.
+ * @version 0.1 2022-09-07 Initial version
+ * @date 2022-09-07
+ *
+ * @copyright
+ * MIT License
+ *
+ * Copyright (c) 2022 Giel Willemsen
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <driver/rmt.h>
+#include "led_strip_sim.h"
+#include "sim_private.h"
+
+#define CHANNEL_IS_VALID(channel) ((int)(channel) >= 0 && (channel) < RMT_CHANNEL_MAX)
+
+typedef struct sim_channel
+{
+    bool configured;
+    bool installed;
+    rmt_config_t config;
+    sample_to_rmt_t translator;
+    void *translator_context;
+    size_t item_num; ///< The translator reports the items it wrote here, rmt_translator_get_context finds the channel from its address.
+    rmt_item32_t *memory; ///< The RMT memory blocks of the channel, the translator writes into them.
+    rmt_item32_t *items; ///< The recorded items of the last transmission.
+    size_t item_count;
+    size_t item_capacity;
+    size_t bytes_left;
+    uint32_t translator_calls;
+    uint32_t transmissions;
+} sim_channel_t;
+
+static void finish_transmission(rmt_channel_t channel);
+static void record_items(sim_channel_t *sim, const rmt_item32_t *items, size_t count);
+
+static sim_channel_t channels[RMT_CHANNEL_MAX];
+static rmt_tx_end_callback_t tx_end_callback = {
+    .function = NULL,
+    .arg = NULL,
+};
+static bool recording = true;
+
+extern esp_err_t rmt_config(const rmt_config_t *rmt_param)
+{
+    if (rmt_param == NULL || CHANNEL_IS_VALID(rmt_param->channel) == false || rmt_param->rmt_mode != RMT_MODE_TX)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (rmt_param->clk_div == 0 || rmt_param->mem_block_num == 0 || (int)rmt_param->channel + rmt_param->mem_block_num > (int)RMT_CHANNEL_MAX)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    sim_channel_t *sim = &channels[rmt_param->channel];
+    if (sim->installed)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    sim->config = *rmt_param;
+    sim->configured = true;
+    return ESP_OK;
+}
+
+extern esp_err_t rmt_driver_install(rmt_channel_t channel, size_t rx_buf_size, int intr_alloc_flags)
+{
+    if (CHANNEL_IS_VALID(channel) == false)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    sim_channel_t *sim = &channels[channel];
+    if (sim->configured == false || sim->installed)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    sim->memory = (rmt_item32_t *)calloc((size_t)sim->config.mem_block_num * SOC_RMT_MEM_WORDS_PER_CHANNEL, sizeof(rmt_item32_t));
+    if (sim->memory == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    sim->installed = true;
+    sim->translator = NULL;
+    sim->translator_context = NULL;
+    sim->item_count = 0;
+    sim->bytes_left = 0;
+    sim->translator_calls = 0;
+    sim->transmissions = 0;
+    return ESP_OK;
+}
+
+extern esp_err_t rmt_driver_uninstall(rmt_channel_t channel)
+{
+    if (CHANNEL_IS_VALID(channel) == false)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    sim_channel_t *sim = &channels[channel];
+    if (sim->installed == false)
+    {
+        return ESP_OK; // Like the driver, uninstalling twice isn't an error.
+    }
+    free(sim->memory);
+    free(sim->items);
+    memset(sim, 0, sizeof(sim_channel_t));
+    return ESP_OK;
+}
+
+extern esp_err_t rmt_translator_init(rmt_channel_t channel, sample_to_rmt_t fn)
+{
+    if (CHANNEL_IS_VALID(channel) == false || fn == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (channels[channel].installed == false)
+    {
+        return ESP_FAIL;
+    }
+    channels[channel].translator = fn;
+    return ESP_OK;
+}
+
+extern esp_err_t rmt_translator_set_context(rmt_channel_t channel, void *context)
+{
+    if (CHANNEL_IS_VALID(channel) == false)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (channels[channel].installed == false)
+    {
+        return ESP_FAIL;
+    }
+    channels[channel].translator_context = context;
+    return ESP_OK;
+}
+
+extern esp_err_t rmt_translator_get_context(const size_t *item_num, void **context)
+{
+    if (item_num == NULL || context == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    const sim_channel_t *sim = __containerof(item_num, sim_channel_t, item_num);
+    *context = sim->translator_context;
+    return ESP_OK;
+}
+
+extern esp_err_t rmt_set_tx_loop_mode(rmt_channel_t channel, bool loop_en)
+{
+    if (CHANNEL_IS_VALID(channel) == false)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    channels[channel].config.tx_config.loop_en = loop_en;
+    return ESP_OK;
+}
+
+extern esp_err_t rmt_set_tx_intr_en(rmt_channel_t channel, bool en)
+{
+    return CHANNEL_IS_VALID(channel) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+extern esp_err_t rmt_add_channel_to_group(rmt_channel_t channel)
+{
+    // Every transmission completes before the next one starts, so the channels of a group are always in sync.
+    return CHANNEL_IS_VALID(channel) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+extern esp_err_t rmt_remove_channel_from_group(rmt_channel_t channel)
+{
+    return CHANNEL_IS_VALID(channel) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+extern rmt_tx_end_callback_t rmt_register_tx_end_callback(rmt_tx_end_fn_t function, void *arg)
+{
+    const rmt_tx_end_callback_t previous = tx_end_callback;
+    tx_end_callback.function = function;
+    tx_end_callback.arg = arg;
+    return previous;
+}
+
+extern esp_err_t rmt_write_sample(rmt_channel_t channel, const uint8_t *src, size_t src_size, bool wait_tx_done)
+{
+    if (CHANNEL_IS_VALID(channel) == false || src == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    sim_channel_t *sim = &channels[channel];
+    if (sim->installed == false || sim->translator == NULL)
+    {
+        return ESP_FAIL;
+    }
+    sim->item_count = 0;
+    sim->translator_calls = 0;
+
+    // The driver fills all memory blocks of the channel from rmt_write_sample, after that the threshold interrupt
+    // refills half of them at a time. A refill with fewer items than asked for ends the transmission.
+    const size_t block_items = (size_t)sim->config.mem_block_num * SOC_RMT_MEM_WORDS_PER_CHANNEL;
+    size_t wanted = block_items;
+    size_t remaining = src_size;
+    const uint8_t *current = src;
+    bool in_isr = false;
+    while (true)
+    {
+        size_t translated = 0;
+        sim->item_num = 0;
+        if (in_isr)
+        {
+            sim_isr_enter();
+        }
+        sim->translator(current, sim->memory, remaining, wanted, &translated, &sim->item_num);
+        if (in_isr)
+        {
+            sim_isr_exit();
+        }
+        sim->translator_calls++;
+        record_items(sim, sim->memory, sim->item_num);
+        current += translated;
+        remaining -= translated;
+        if (sim->item_num < wanted || remaining == 0)
+        {
+            break;
+        }
+        wanted = block_items / 2;
+        in_isr = true;
+    }
+    sim->bytes_left = remaining;
+    finish_transmission(channel);
+    return ESP_OK;
+}
+
+extern esp_err_t rmt_write_items(rmt_channel_t channel, const rmt_item32_t *rmt_item, int item_num, bool wait_tx_done)
+{
+    if (CHANNEL_IS_VALID(channel) == false || rmt_item == NULL || item_num <= 0)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    sim_channel_t *sim = &channels[channel];
+    if (sim->installed == false)
+    {
+        return ESP_FAIL;
+    }
+    sim->item_count = 0;
+    sim->translator_calls = 0;
+    sim->bytes_left = 0;
+    record_items(sim, rmt_item, (size_t)item_num);
+    finish_transmission(channel);
+    return ESP_OK;
+}
+
+extern esp_err_t rmt_wait_tx_done(rmt_channel_t channel, TickType_t wait_time)
+{
+    if (CHANNEL_IS_VALID(channel) == false)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return channels[channel].installed ? ESP_OK : ESP_FAIL;
+}
+
+extern esp_err_t led_strip_sim_find_channel(int gpio_num, rmt_channel_t *channel)
+{
+    if (channel == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (int i = 0; i < (int)RMT_CHANNEL_MAX; i++)
+    {
+        if (channels[i].installed && channels[i].config.gpio_num == gpio_num)
+        {
+            *channel = (rmt_channel_t)i;
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+extern esp_err_t led_strip_sim_get_transmission(rmt_channel_t channel, led_strip_sim_transmission_t *transmission)
+{
+    if (CHANNEL_IS_VALID(channel) == false || transmission == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    const sim_channel_t *sim = &channels[channel];
+    if (sim->installed == false)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    transmission->items = sim->items;
+    transmission->item_count = sim->item_count;
+    transmission->bytes_left = sim->bytes_left;
+    transmission->translator_calls = sim->translator_calls;
+    transmission->transmissions = sim->transmissions;
+    transmission->clk_div = sim->config.clk_div;
+    transmission->gpio_num = sim->config.gpio_num;
+    return ESP_OK;
+}
+
+extern void led_strip_sim_set_recording(bool enabled)
+{
+    recording = enabled;
+}
+
+// Private functions
+
+static void finish_transmission(rmt_channel_t channel)
+{
+    channels[channel].transmissions++;
+    if (tx_end_callback.function != NULL)
+    {
+        sim_isr_enter();
+        tx_end_callback.function(channel, tx_end_callback.arg);
+        sim_isr_exit();
+    }
+}
+
+static void record_items(sim_channel_t *sim, const rmt_item32_t *items, size_t count)
+{
+    if (recording == false || count == 0)
+    {
+        return;
+    }
+    if (sim->item_count + count > sim->item_capacity)
+    {
+        size_t capacity = sim->item_capacity == 0 ? 1024 : sim->item_capacity;
+        while (capacity < sim->item_count + count)
+        {
+            capacity *= 2;
+        }
+        rmt_item32_t *grown = (rmt_item32_t *)realloc(sim->items, capacity * sizeof(rmt_item32_t));
+        if (grown == NULL)
+        {
+            abort(); // A recording with holes would pass as a short waveform.
+        }
+        sim->items = grown;
+        sim->item_capacity = capacity;
+    }
+    memcpy(&sim->items[sim->item_count], items, count * sizeof(rmt_item32_t));
+    sim->item_count += count;
+}
@@ -34,6 +34,14 @@
 #ifndef LED_STRIP_H_
 #define LED_STRIP_H_
 
+#include <stdint.h>
+#include <stdbool.h>
+#include <esp_err.h>
+#include <soc/soc.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "sdkconfig.h"
+
 // Macros
 #define LED_STRIP_CLOCK_DIVIDER 8
 #define LED_STRIP_NS_PER_SECOND 1e9
@@ -42,14 +50,26 @@
 #define LED_STRIP_ROUND_UP(x, align) ((((x) + (align) - 1) / (align)) * (align))
 #define LED_STRIP_NS_AS_TICKS(x) (LED_STRIP_ROUND_UP(x, LED_STRIP_NS_PER_TICK) / LED_STRIP_NS_PER_TICK)
 #define LED_STRIP_US_AS_TICKS(x) (LED_STRIP_NS_AS_TICKS((x) * 1000))
+#define LED_STRIP_TICKS_AS_US(x) (LED_STRIP_ROUND_UP((x) * LED_STRIP_NS_PER_TICK, 1000) / 1000)
+
+#define LED_STRIP_GROUP_MAX_STRIPS 24 ///< Every strip of a group needs a bit in a FreeRTOS event group.
+#define LED_STRIP_GAMMA_TABLE_SIZE 256 ///< A gamma table has an output level for every 8 bit input level.
 
 // Forward declares
 typedef struct led_strip led_strip_t;
+typedef struct led_strip_group led_strip_group_t;
+typedef struct led_strip_parallel_bus led_strip_parallel_bus_t;
 
 // Helper typedefs
 typedef led_strip_t* led_strip_handle_t;
+typedef led_strip_group_t* led_strip_group_handle_t;
+typedef led_strip_parallel_bus_t* led_strip_parallel_bus_handle_t;
 typedef uint8_t led_strip_color_component_t;
+#if CONFIG_LED_STRIP_PIXEL_INDEX_32BIT
+typedef uint32_t led_strip_pixel_index_t;
+#else
 typedef uint16_t led_strip_pixel_index_t;
+#endif
 
 // Enums
 typedef enum led_strip_type {
@@ -62,6 +82,46 @@ typedef enum led_strip_color_order {
     LED_STRIP_COLOR_ORDER_GRBW,
 } led_strip_color_order_t;
 
+// Callbacks
+
+/**
+ * @brief Called from the ISR of the backend every time a transmission of the led strip is done. Must be placed in IRAM
+ * and may only use ISR safe functions.
+ * 
+ * @param handle The led strip that finished transmitting.
+ * @param user_ctx The user context given when registering the callback.
+ * @return true if a higher priority task was woken by the callback, false otherwise.
+ */
+typedef bool (*led_strip_flush_done_cb_t)(led_strip_handle_t handle, void *user_ctx);
+
+/**
+ * @brief Called from the scheduler task at the start of every frame period, to render the next frame.
+ * 
+ * @param handle The led strip the frame is for.
+ * @param user_ctx The user context given when starting the scheduler.
+ * @return true to flush the led strip, false if nothing changed and the period can be skipped.
+ */
+typedef bool (*led_strip_frame_cb_t)(led_strip_handle_t handle, void *user_ctx);
+
+typedef enum led_strip_matrix_layout {
+    LED_STRIP_MATRIX_LAYOUT_ROW_MAJOR,          ///< Every row is wired left to right, row after row.
+    LED_STRIP_MATRIX_LAYOUT_SERPENTINE,         ///< The even rows are wired left to right and the odd rows right to left.
+    LED_STRIP_MATRIX_LAYOUT_COLUMN_MAJOR,       ///< Every column is wired top to bottom, column after column.
+    LED_STRIP_MATRIX_LAYOUT_COLUMN_SERPENTINE,  ///< The even columns are wired top to bottom and the odd columns bottom to top.
+} led_strip_matrix_layout_t;
+
+typedef enum led_strip_memory_policy {
+    LED_STRIP_MEMORY_INTERNAL,                  ///< All buffers in internal RAM.
+    LED_STRIP_MEMORY_SPIRAM_FRAMEBUFFER,        ///< The framebuffers in PSRAM, the baked frames in internal RAM.
+    LED_STRIP_MEMORY_SPIRAM_ALL,                ///< The framebuffers and the baked frames in PSRAM.
+} led_strip_memory_policy_t;
+
+typedef enum led_strip_pixel_format {
+    LED_STRIP_PIXEL_FORMAT_WIRE,                ///< The components in the order they are sent, 3 bytes per pixel or 4 with the W channel.
+    LED_STRIP_PIXEL_FORMAT_RGB24,               ///< R, G, B for every pixel whatever the color order, only for led strips without a W channel.
+    LED_STRIP_PIXEL_FORMAT_RGBA32,              ///< R, G, B, W for every pixel whatever the color order, the W byte isn't sent to led strips without a W channel.
+} led_strip_pixel_format_t;
+
 // Structs
 typedef struct led_strip_color {
     led_strip_color_component_t r;
@@ -70,6 +130,13 @@ typedef struct led_strip_color {
     led_strip_color_component_t w;
 } led_strip_color_t;
 
+typedef struct led_strip_color16 {
+    uint16_t r;
+    uint16_t g;
+    uint16_t b;
+    uint16_t w;
+} led_strip_color16_t;
+
 typedef struct led_strip_manual_timing {
     uint16_t low_on : 15;       ///< The time that 0 bit time is ON, unit is in 100 nanoseconds.
     uint16_t low_off : 15;      ///< The time that 0 bit time is OFF, unit is in 100 nanoseconds.
@@ -92,8 +159,50 @@ typedef struct led_strip_config {
     int gpio_output_num;
     led_strip_pixel_index_t led_count;
     bool enable_w_channel;
+    bool enable_double_buffer;  ///< Render into a back buffer while the front buffer is transmitted, the buffers are swapped when a flush starts.
+    uint8_t baked_frame_count;  ///< The number of baked frame slots (see led_strip_bake_frame), 0 disables baking.
+    uint8_t mem_block_num;      ///< The number of RMT memory blocks for the channel, more blocks means fewer refill interrupts. Every extra block occupies the next channel.
+    bool with_dma;              ///< Stream the frame to the RMT peripheral with DMA, only with the RMT encoder driver on chips with RMT DMA support.
+    bool enable_partial_flush;  ///< Only send the pixels up to the highest pixel that changed since the previous flush, the LEDs after it keep their color.
+    led_strip_color_t white_point;  ///< The color of the W LED, white is extracted from RGB colors relative to it. All zero disables the extraction, the w member is ignored.
+    bool enable_dithering;      ///< Keep a 16 bit per component framebuffer (see led_strip_set_pixel_rgb16) that is temporally dithered into the sent 8 bit frame on every flush.
+    led_strip_memory_policy_t memory_policy; ///< Where the framebuffers are allocated. With a PSRAM framebuffer and the legacy RMT driver a flush returns once the last part of the frame is staged in internal RAM, the other backends copy the frame to an internal staging buffer before they send it.
+    led_strip_color_component_t *external_buffer; ///< Transmit from this caller owned buffer instead of allocating a framebuffer, see led_strip_attach_buffer. NULL allocates one.
+    int intr_flags;             ///< ESP_INTR_FLAG_* for the RMT interrupt. ESP_INTR_FLAG_IRAM keeps the led strip refilling while the flash cache is disabled, it requires internal RAM buffers. The legacy RMT driver shares one interrupt between all channels, there only the flags of the first installed led strip count.
+    BaseType_t intr_core;       ///< The core to allocate the RMT interrupt on, tskNO_AFFINITY for the core that calls led_strip_install. Shared like intr_flags with the legacy RMT driver.
+    led_strip_pixel_format_t pixel_format; ///< The layout of the framebuffer. With RGB24 or RGBA32 frames can be copied in without knowing the color order, the legacy RMT translator reorders the components while sending. A build with a fixed color order only supports LED_STRIP_PIXEL_FORMAT_WIRE.
+    led_strip_parallel_bus_handle_t parallel_bus; ///< Send on the lane of this bus with gpio_output_num as GPIO instead of on an RMT channel, see led_strip_parallel_bus_create. NULL for RMT.
+    int spi_host;               ///< The SPI host (SPI2_HOST, ...) of a clocked APA102 or SK9822 led strip, gpio_output_num is its data line. -1 for a one-wire led strip. The bus is initialized unless the application did it already.
+    int spi_clock_gpio_num;     ///< The clock line of a clocked led strip.
+    uint32_t spi_clock_hz;      ///< The clock of a clocked led strip, 10 MHz by default. APA102 and SK9822 take up to about 20 MHz, depending on the wiring.
 } led_strip_config_t;
 
+typedef struct led_strip_stats {
+    uint32_t frames_started;                ///< Transmissions that the backend accepted, including baked frames.
+    uint32_t frames_completed;              ///< Transmissions that reached TX done.
+    uint32_t frames_dropped;                ///< Flushes that were refused with ESP_ERR_NOT_FINISHED because the previous transmission, or another one on a shared bus, wasn't done yet.
+    uint32_t translator_calls;              ///< Total number of translator invocations.
+    uint64_t translator_cycles;             ///< Total number of CPU cycles spent in the translator.
+    uint64_t bytes_translated;              ///< Total number of pixel bytes translated into RMT symbols.
+    uint32_t max_translator_call_cycles;    ///< The longest single translator invocation in CPU cycles, this bounds the time spent in the RMT ISR.
+    uint32_t last_frame_translator_calls;   ///< Translator invocations of the last completed frame.
+    uint32_t last_frame_translator_cycles;  ///< CPU cycles spent in the translator for the last completed frame.
+    uint32_t last_frame_time_us;            ///< Time from starting the flush until TX done of the last completed frame, unit is in microseconds.
+    uint32_t max_frame_time_us;             ///< The longest time from starting a flush until TX done, unit is in microseconds.
+} led_strip_stats_t;
+
+typedef struct led_strip_scheduler_stats {
+    uint32_t frame_period_us;   ///< The period the scheduler runs at.
+    uint32_t periods;           ///< Frame periods since the scheduler started.
+    uint32_t frames_flushed;    ///< Periods in which a flush was started.
+    uint32_t frames_skipped;    ///< Periods in which the frame callback returned false.
+    uint32_t periods_missed;    ///< Periods that passed while the scheduler task was still busy with an earlier one.
+    uint32_t frames_late;       ///< Periods in which the previous transmission hadn't finished yet, so nothing was flushed.
+    uint32_t last_jitter_us;    ///< How late the scheduler task woke up in the last period.
+    uint32_t max_jitter_us;
+    uint64_t total_jitter_us;   ///< Divide by periods minus periods_missed for the average.
+} led_strip_scheduler_stats_t;
+
 // Public functions
 
 /**
@@ -111,7 +220,6 @@ extern void led_strip_init_config(led_strip_config_t *config);
 
 /**
  * @brief Create a new instance of a ledstrip with the given configuration.
- * A led strip size of 2 is NOT supported and will result in ESP_ERR_NOT_SUPPORTED.
  * 
  * @param handle The resulting handle of the instance.
  * @param config The configuration to initialize the led strip with..
@@ -146,6 +254,9 @@ extern esp_err_t led_strip_flush_done(led_strip_handle_t handle, bool *done);
 
 /**
  * @brief Starts with sending the new frame to LEDs but doesn't wait for the transmission to finish (use led_strip_flush_done for that).
+ * When the led strip is double buffered, the back buffer becomes the transmitted front buffer and the previous front buffer becomes
+ * the new back buffer, so it holds the frame before the one that is being sent. The next frame can be rendered into it right away.
+ * With enable_partial_flush the new back buffer is updated with the sent pixels instead, so it holds the frame that is being sent.
  * 
  * @param handle The led strip to send the update for.
  * @return esp_err_t The success code for starting the new transmission.
@@ -160,6 +271,154 @@ extern esp_err_t led_strip_start_flush(led_strip_handle_t handle);
  */
 extern esp_err_t led_strip_wait_for_flush_finish(led_strip_handle_t handle);
 
+/**
+ * @brief led_strip_flush without the argument checks, for the frame loop of a led strip that was installed successfully.
+ * 
+ * @param handle The led strip to send the update for, must be a valid handle.
+ * @return esp_err_t The success code for sending the new frame.
+ */
+extern esp_err_t led_strip_flush_unchecked(led_strip_handle_t handle);
+
+/**
+ * @brief led_strip_start_flush without the argument checks, for the frame loop of a led strip that was installed successfully.
+ * 
+ * @param handle The led strip to send the update for, must be a valid handle.
+ * @return esp_err_t The success code for starting the new transmission, ESP_ERR_NOT_FINISHED if the previous one is still ongoing.
+ */
+extern esp_err_t led_strip_start_flush_unchecked(led_strip_handle_t handle);
+
+/**
+ * @brief led_strip_flush_done without the argument checks, for polling a led strip that was installed successfully.
+ * 
+ * @param handle The led strip to check, must be a valid handle.
+ * @return true if the led strip isn't transmitting, or if the driver failed to tell.
+ */
+extern bool led_strip_flush_done_unchecked(led_strip_handle_t handle);
+
+/**
+ * @brief Registers a callback that is called from ISR context every time a transmission of the led strip is done.
+ * Can only be changed while the led strip isn't transmitting.
+ * 
+ * @param handle The led strip to register the callback for.
+ * @param callback The callback to call, NULL to unregister.
+ * @param user_ctx The context that is passed to the callback.
+ * @return esp_err_t The success code for registering the callback, ESP_ERR_INVALID_STATE if the led strip is transmitting.
+ */
+extern esp_err_t led_strip_register_flush_done_callback(led_strip_handle_t handle, led_strip_flush_done_cb_t callback, void *user_ctx);
+
+/**
+ * @brief Sets a task that is notified every time a transmission of the led strip is done. The notify bits are OR-ed into the
+ * notification value of the task (eSetBits), so one task can wait for multiple led strips with xTaskNotifyWait.
+ * Can only be changed while the led strip isn't transmitting.
+ * 
+ * @param handle The led strip to set the notification target for.
+ * @param task The task to notify, NULL to stop notifying.
+ * @param notify_bits The bits to set in the notification value of the task.
+ * @return esp_err_t The success code for setting the notification target, ESP_ERR_INVALID_STATE if the led strip is transmitting.
+ */
+extern esp_err_t led_strip_set_flush_done_notify(led_strip_handle_t handle, TaskHandle_t task, uint32_t notify_bits);
+
+/**
+ * @brief Retrieves a snapshot of the timing statistics of the led strip. Only available when CONFIG_LED_STRIP_ENABLE_STATS is enabled.
+ * 
+ * @param handle The led strip to get the statistics for.
+ * @param stats The destination for the statistics.
+ * @return esp_err_t The success code for retrieving the statistics, ESP_ERR_NOT_SUPPORTED if the statistics are disabled.
+ */
+extern esp_err_t led_strip_get_stats(led_strip_handle_t handle, led_strip_stats_t *stats);
+
+/**
+ * @brief Sets all the timing statistics of the led strip back to zero.
+ * 
+ * @param handle The led strip to reset the statistics for.
+ * @return esp_err_t The success code for resetting the statistics, ESP_ERR_NOT_SUPPORTED if the statistics are disabled.
+ */
+extern esp_err_t led_strip_reset_stats(led_strip_handle_t handle);
+
+/**
+ * @brief Sets a table that maps the pixel indices given to the pixel functions to the position of the LED on the strip.
+ * The mapping is applied when a pixel is set, so pixels that were set before keep their position. The table is copied.
+ * 
+ * @param handle The led strip to set the table for.
+ * @param table The position on the strip for every index, must hold led_count entries smaller than led_count. NULL disables the mapping.
+ * @return esp_err_t The success code for setting the table, ESP_ERR_INVALID_ARG if an entry is out of range.
+ */
+extern esp_err_t led_strip_set_remap_table(led_strip_handle_t handle, const led_strip_pixel_index_t *table);
+
+/**
+ * @brief Maps the pixel indices to a LED matrix, so index (y * width) + x addresses the LED at column x and row y, no matter how the
+ * matrix is wired. The LEDs after the matrix keep their index. Replaces the table set with led_strip_set_remap_table.
+ * 
+ * @param handle The led strip that forms the matrix.
+ * @param width The number of columns.
+ * @param height The number of rows, width * height may not exceed the led count.
+ * @param layout How the LEDs of the matrix are wired.
+ * @return esp_err_t The success code for setting the layout.
+ */
+extern esp_err_t led_strip_set_matrix_layout(led_strip_handle_t handle, led_strip_pixel_index_t width, led_strip_pixel_index_t height, led_strip_matrix_layout_t layout);
+
+/**
+ * @brief Sets the color of the W LED that is used to convert RGB colors for a led strip with the W channel. The white level is the
+ * largest amount of the white point that fits in the color and that amount is taken out of the r, g and b components.
+ * Only affects colors that are set after the call.
+ * 
+ * @param handle The led strip to set the white point for.
+ * @param white_point The color of the W LED, for example {255, 255, 255} for neutral white. All zero disables the extraction.
+ * @return esp_err_t The success code for setting the white point.
+ */
+extern esp_err_t led_strip_set_white_point(led_strip_handle_t handle, led_strip_color_t white_point);
+
+/**
+ * @brief Converts the whole pixel buffer from RGB to RGBW in one pass, the extracted white is added to the W components.
+ * Useful after filling the buffer with led_strip_set_pixels, which copies the given colors as they are.
+ * 
+ * @param handle The led strip to convert the pixels of.
+ * @return esp_err_t The success code for converting, ESP_ERR_NOT_SUPPORTED if the led strip has no W channel.
+ */
+extern esp_err_t led_strip_extract_white(led_strip_handle_t handle);
+
+/**
+ * @brief Sets the global brightness of the led strip. The brightness is applied while the pixel data is translated for the RMT
+ * peripheral, so the pixel buffer keeps the full precision colors and changing the brightness doesn't cost anything per pixel.
+ * Takes effect with the next flush, frames that were baked before keep the brightness they were baked with.
+ * 
+ * @param handle The led strip to set the brightness for.
+ * @param brightness The brightness, 255 is full brightness (the default) and 0 turns every LED off.
+ * @return esp_err_t The success code for setting the brightness.
+ */
+extern esp_err_t led_strip_set_brightness(led_strip_handle_t handle, uint8_t brightness);
+
+/**
+ * @brief Sets the gamma table that every color component is mapped through before the brightness is applied.
+ * Like the brightness it is applied while translating and takes effect with the next flush. The table is copied.
+ * 
+ * @param handle The led strip to set the gamma table for.
+ * @param table LED_STRIP_GAMMA_TABLE_SIZE output levels, indexed by the input level. NULL disables gamma correction.
+ * @return esp_err_t The success code for setting the gamma table.
+ */
+extern esp_err_t led_strip_set_gamma_table(led_strip_handle_t handle, const uint8_t *table);
+
+/**
+ * @brief Fills a gamma table for the given gamma value (output = input ^ gamma), for use with led_strip_set_gamma_table.
+ * 
+ * @param table The destination for the LED_STRIP_GAMMA_TABLE_SIZE output levels.
+ * @param gamma The gamma value, 2.2 to 2.8 is typical for LEDs.
+ * @return esp_err_t The success code for filling the table.
+ */
+extern esp_err_t led_strip_build_gamma_table(uint8_t *table, float gamma);
+
+/**
+ * @brief Sets the 5 bit global brightness of a pixel of a clocked (APA102 or SK9822) led strip, which dims the LED by its current
+ * instead of its PWM. Dimming this way keeps the full 8 bit color resolution at low brightness. They start at 31, full brightness.
+ * The color order of a clocked led strip is ignored, the components are always sent in the B, G, R order these LEDs use.
+ * 
+ * @param handle The led strip to set the global brightness in.
+ * @param index The index of the pixel (0-based).
+ * @param level The global brightness, 0 to 31.
+ * @return esp_err_t The success code for setting the global brightness, ESP_ERR_NOT_SUPPORTED for a one-wire led strip.
+ */
+extern esp_err_t led_strip_set_pixel_global_brightness(led_strip_handle_t handle, led_strip_pixel_index_t index, uint8_t level);
+
 /**
  * @brief Sets the pixel to the given color. If the led strip uses the W channel as well a conversion calculation will be done.
  * 
@@ -185,6 +444,29 @@ extern esp_err_t led_strip_set_pixel_rgb(led_strip_handle_t handle, led_strip_pi
  */
 extern esp_err_t led_strip_set_pixel_rgbw(led_strip_handle_t handle, led_strip_pixel_index_t index, led_strip_color_component_t r, led_strip_color_component_t g, led_strip_color_component_t b, led_strip_color_component_t w);
 
+/**
+ * @brief led_strip_set_pixel_rgb without the argument checks, for loops over the pixels of a led strip that was installed successfully.
+ * 
+ * @param handle The led strip to set the pixel in, must be a valid handle.
+ * @param index The index of the pixel to set the color for (0-based), must be smaller than the led count.
+ * @param r The red component of the color.
+ * @param g The green component of the color.
+ * @param b The blue component of the color.
+ */
+extern void led_strip_set_pixel_rgb_unchecked(led_strip_handle_t handle, led_strip_pixel_index_t index, led_strip_color_component_t r, led_strip_color_component_t g, led_strip_color_component_t b);
+
+/**
+ * @brief led_strip_set_pixel_rgbw without the argument checks, for loops over the pixels of a led strip that was installed successfully.
+ * 
+ * @param handle The led strip to set the pixel in, must be a valid handle.
+ * @param index The index of the pixel to set the color for (0-based), must be smaller than the led count.
+ * @param r The red component of the color.
+ * @param g The green component of the color.
+ * @param b The blue component of the color.
+ * @param w The white component of the color.
+ */
+extern void led_strip_set_pixel_rgbw_unchecked(led_strip_handle_t handle, led_strip_pixel_index_t index, led_strip_color_component_t r, led_strip_color_component_t g, led_strip_color_component_t b, led_strip_color_component_t w);
+
 /**
  * @brief Sets all the pixels in the led strip to the given color. If the led strip uses the W channel as well a conversion calculation will be done.
  * 
@@ -208,4 +490,229 @@ extern esp_err_t led_strip_fill_rgb(led_strip_handle_t handle, led_strip_color_c
  */
 extern esp_err_t led_strip_fill_rgbw(led_strip_handle_t handle, led_strip_color_component_t r, led_strip_color_component_t g, led_strip_color_component_t b, led_strip_color_component_t w);
 
+/**
+ * @brief Sets a range of pixels to the given colors in one call. If the led strip only uses RGB the W components will be dropped.
+ * The arguments are validated once for the whole range, which makes this a lot cheaper than setting the pixels one by one.
+ * 
+ * @param handle The led strip to set the pixels in.
+ * @param start The index of the first pixel to set (0-based).
+ * @param count The number of pixels to set, colors must hold at least this many entries.
+ * @param colors The colors for the pixels start up to start + count.
+ * @return esp_err_t The success code for setting the colors.
+ */
+extern esp_err_t led_strip_set_pixels(led_strip_handle_t handle, led_strip_pixel_index_t start, led_strip_pixel_index_t count, const led_strip_color_t *colors);
+
+/**
+ * @brief Sets a range of pixels from packed RGB data (r, g, b, r, g, b, ...) in one call.
+ * If the led strip uses the W channel as well a conversion calculation will be done.
+ * 
+ * @param handle The led strip to set the pixels in.
+ * @param start The index of the first pixel to set (0-based).
+ * @param count The number of pixels to set, rgb must hold at least 3 * count components.
+ * @param rgb The packed color components for the pixels start up to start + count.
+ * @return esp_err_t The success code for setting the colors.
+ */
+extern esp_err_t led_strip_set_pixels_rgb(led_strip_handle_t handle, led_strip_pixel_index_t start, led_strip_pixel_index_t count, const led_strip_color_component_t *rgb);
+
+/**
+ * @brief Makes the led strip transmit from a caller owned buffer from the next flush on, without copying it.
+ * The buffer holds led_count pixels in the configured pixel_format. The pixel functions
+ * write to it as well. Because the buffer can change without the led strip knowing, every flush sends the whole buffer and
+ * never a baked frame. The buffer that is being transmitted may not be changed until the flush is done.
+ * 
+ * @param handle The led strip to attach the buffer to, must be installed with an external_buffer.
+ * @param buffer The buffer to transmit from, must stay valid until it is replaced and its transmission is done.
+ * @return esp_err_t The success code for attaching the buffer, ESP_ERR_INVALID_STATE if the led strip owns its framebuffer,
+ * ESP_ERR_INVALID_ARG for a buffer outside internal RAM with ESP_INTR_FLAG_IRAM.
+ */
+extern esp_err_t led_strip_attach_buffer(led_strip_handle_t handle, led_strip_color_component_t *buffer);
+
+/**
+ * @brief Encodes the current pixel buffer into RMT items and stores them in the given baked frame slot.
+ * Sending a baked frame doesn't need the translator. Until the pixel buffer is modified again led_strip_flush and
+ * led_strip_start_flush send the baked frame as well. The slot memory (32 bytes per color component) is allocated on first use.
+ * 
+ * @param handle The led strip to bake the frame for.
+ * @param slot The slot to store the frame in, must be smaller than the configured baked_frame_count.
+ * @return esp_err_t The success code for baking the frame.
+ */
+extern esp_err_t led_strip_bake_frame(led_strip_handle_t handle, uint8_t slot);
+
+/**
+ * @brief Sends a baked frame to the LEDs and wait for the transmission to complete. The pixel buffer is left untouched.
+ * 
+ * @param handle The led strip to send the update for.
+ * @param slot The slot of the baked frame to send.
+ * @return esp_err_t The success code for sending the frame, ESP_ERR_INVALID_STATE if the slot was never baked.
+ */
+extern esp_err_t led_strip_flush_baked(led_strip_handle_t handle, uint8_t slot);
+
+/**
+ * @brief Starts with sending a baked frame to the LEDs but doesn't wait for the transmission to finish. The pixel buffer is left untouched.
+ * 
+ * @param handle The led strip to send the update for.
+ * @param slot The slot of the baked frame to send.
+ * @return esp_err_t The success code for starting the transmission, ESP_ERR_INVALID_STATE if the slot was never baked.
+ */
+extern esp_err_t led_strip_start_flush_baked(led_strip_handle_t handle, uint8_t slot);
+
+/**
+ * @brief Frees the memory of a baked frame slot.
+ * 
+ * @param handle The led strip that owns the slot.
+ * @param slot The slot to free.
+ * @return esp_err_t The success code for freeing the slot, ESP_ERR_INVALID_STATE if the frame is being transmitted.
+ */
+extern esp_err_t led_strip_discard_baked_frame(led_strip_handle_t handle, uint8_t slot);
+
+/**
+ * @brief Sets the pixel to the given 16 bit color in the dithering framebuffer. Only available with enable_dithering.
+ * Every flush sends the next dithered 8 bit sub-frame of the framebuffer, flush faster than the content changes (see
+ * led_strip_start_refresh) to get the in-between levels. If the led strip uses the W channel as well a conversion calculation will be done.
+ * With dithering enabled the 8 bit pixel functions write the sent frame directly, so their changes are lost on the next flush.
+ * 
+ * @param handle The led strip to set the pixel in.
+ * @param index The index of the pixel to set the color for (0-based).
+ * @param r The red component of the color.
+ * @param g The green component of the color.
+ * @param b The blue component of the color.
+ * @return esp_err_t The success code for setting the color, ESP_ERR_INVALID_STATE if dithering isn't enabled.
+ */
+extern esp_err_t led_strip_set_pixel_rgb16(led_strip_handle_t handle, led_strip_pixel_index_t index, uint16_t r, uint16_t g, uint16_t b);
+
+/**
+ * @brief Sets the pixel to the given 16 bit color in the dithering framebuffer. Only available with enable_dithering.
+ * If the led strip only uses RGB the W component will be dropped.
+ * 
+ * @param handle The led strip to set the pixel in.
+ * @param index The index of the pixel to set the color for (0-based).
+ * @param r The red component of the color.
+ * @param g The green component of the color.
+ * @param b The blue component of the color.
+ * @param w The white component of the color.
+ * @return esp_err_t The success code for setting the color, ESP_ERR_INVALID_STATE if dithering isn't enabled.
+ */
+extern esp_err_t led_strip_set_pixel_rgbw16(led_strip_handle_t handle, led_strip_pixel_index_t index, uint16_t r, uint16_t g, uint16_t b, uint16_t w);
+
+/**
+ * @brief Sets all the pixels in the dithering framebuffer to the given 16 bit color. Only available with enable_dithering.
+ * If the led strip only uses RGB the W component will be dropped.
+ * 
+ * @param handle The led strip to set the pixels in.
+ * @param color The color to set.
+ * @return esp_err_t The success code for setting the colors, ESP_ERR_INVALID_STATE if dithering isn't enabled.
+ */
+extern esp_err_t led_strip_fill16(led_strip_handle_t handle, led_strip_color16_t color);
+
+/**
+ * @brief Sets a range of pixels in the dithering framebuffer to the given 16 bit colors in one call. Only available with enable_dithering.
+ * If the led strip only uses RGB the W components will be dropped.
+ * 
+ * @param handle The led strip to set the pixels in.
+ * @param start The index of the first pixel to set (0-based).
+ * @param count The number of pixels to set, colors must hold at least this many entries.
+ * @param colors The colors for the pixels start up to start + count.
+ * @return esp_err_t The success code for setting the colors, ESP_ERR_INVALID_STATE if dithering isn't enabled.
+ */
+extern esp_err_t led_strip_set_pixels16(led_strip_handle_t handle, led_strip_pixel_index_t start, led_strip_pixel_index_t count, const led_strip_color16_t *colors);
+
+/**
+ * @brief Starts a task that flushes the led strip over and over again, as fast as the transmissions allow.
+ * Meant for dithering, where every flush sends the next sub-frame. Don't flush the led strip yourself while the task runs.
+ * 
+ * @param handle The led strip to refresh.
+ * @param priority The FreeRTOS priority of the refresh task.
+ * @param core_id The core to pin the task to, or tskNO_AFFINITY.
+ * @return esp_err_t The success code for starting the task, ESP_ERR_INVALID_STATE if the task or the scheduler already runs.
+ */
+extern esp_err_t led_strip_start_refresh(led_strip_handle_t handle, UBaseType_t priority, BaseType_t core_id);
+
+/**
+ * @brief Stops the refresh task and waits until it has exited. Also done by led_strip_free.
+ * 
+ * @param handle The led strip to stop refreshing.
+ * @return esp_err_t The success code for stopping the task, ESP_ERR_INVALID_STATE if the task doesn't run.
+ */
+extern esp_err_t led_strip_stop_refresh(led_strip_handle_t handle);
+
+/**
+ * @brief Calculates the shortest possible frame period of the led strip: a whole frame of the slowest bit plus the reset (latch) time,
+ * or the whole SPI transfer for a clocked led strip.
+ * 
+ * @param handle The led strip to calculate it for.
+ * @param period_us The resulting period in microseconds.
+ * @return esp_err_t The success code for calculating the period.
+ */
+extern esp_err_t led_strip_get_min_frame_period(led_strip_handle_t handle, uint32_t *period_us);
+
+/**
+ * @brief Starts a task that calls the frame callback and flushes the led strip at a fixed frame rate, timed by esp_timer.
+ * Don't flush the led strip yourself while the scheduler runs.
+ * 
+ * @param handle The led strip to schedule.
+ * @param fps The frame rate, 0 for the highest rate the led strip allows (see led_strip_get_min_frame_period).
+ * @param priority The FreeRTOS priority of the scheduler task.
+ * @param core_id The core to pin the task to, or tskNO_AFFINITY.
+ * @param callback Renders the next frame, may be NULL to flush the framebuffer as it is.
+ * @param user_ctx Passed to the callback.
+ * @return esp_err_t The success code for starting the scheduler, ESP_ERR_INVALID_SIZE if the frame rate is higher than the led strip allows,
+ * ESP_ERR_INVALID_STATE if the scheduler or the refresh task already runs.
+ */
+extern esp_err_t led_strip_start_scheduler(led_strip_handle_t handle, uint32_t fps, UBaseType_t priority, BaseType_t core_id, led_strip_frame_cb_t callback, void *user_ctx);
+
+/**
+ * @brief Stops the scheduler and waits until its task has exited. Also done by led_strip_free.
+ * 
+ * @param handle The led strip to stop scheduling.
+ * @return esp_err_t The success code for stopping the scheduler, ESP_ERR_INVALID_STATE if it doesn't run.
+ */
+extern esp_err_t led_strip_stop_scheduler(led_strip_handle_t handle);
+
+/**
+ * @brief Gets the timing statistics of the scheduler of the led strip.
+ * 
+ * @param handle The led strip to get the statistics for.
+ * @param stats The resulting statistics.
+ * @return esp_err_t The success code for getting the statistics, ESP_ERR_INVALID_STATE if the scheduler doesn't run.
+ */
+extern esp_err_t led_strip_get_scheduler_stats(led_strip_handle_t handle, led_strip_scheduler_stats_t *stats);
+
+/**
+ * @brief Creates a group of led strips that are flushed together. On chips with RMT TX synchronization the channels of the group start
+ * transmitting at exactly the same moment, on other chips they are started right after each other.
+ * A led strip can be part of one group at a time and all strips need to stay installed while the group exists. With the legacy RMT
+ * driver a led strip with a PSRAM framebuffer can't be grouped, ESP_ERR_NOT_SUPPORTED is returned for it.
+ * 
+ * @param strips The led strips to put in the group.
+ * @param strip_count The number of led strips, at most LED_STRIP_GROUP_MAX_STRIPS.
+ * @param group The resulting handle of the group.
+ * @return esp_err_t The success code for creating the group.
+ */
+extern esp_err_t led_strip_group_create(const led_strip_handle_t *strips, size_t strip_count, led_strip_group_handle_t *group);
+
+/**
+ * @brief Deletes the group, the led strips themselves stay installed.
+ * 
+ * @param group The group to delete.
+ * @return esp_err_t The success code for deleting the group.
+ */
+extern esp_err_t led_strip_group_delete(led_strip_group_handle_t group);
+
+/**
+ * @brief Starts sending the new frame of every led strip in the group but doesn't wait for the transmissions to finish (use led_strip_group_wait for that).
+ * 
+ * @param group The group to send the update for.
+ * @return esp_err_t The success code for starting the transmissions, ESP_ERR_NOT_FINISHED if a strip is still transmitting.
+ */
+extern esp_err_t led_strip_group_flush(led_strip_group_handle_t group);
+
+/**
+ * @brief Blocks until every led strip of the group finished the transmission started by led_strip_group_flush.
+ * 
+ * @param group The group to wait for.
+ * @param timeout The maximum number of ticks to wait.
+ * @return esp_err_t The success code for waiting, ESP_ERR_TIMEOUT if not all transmissions finished in time.
+ */
+extern esp_err_t led_strip_group_wait(led_strip_group_handle_t group, TickType_t timeout);
+
 #endif // LED_STRIP_H_
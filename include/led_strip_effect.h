@@ -0,0 +1,140 @@
+/**
+ * @file led_strip_effect.h
+ * @author Giel Willemsen
+ * @brief Effects that render incrementally into a range of a led strip, one frame per call.
+ * @version 0.1 2022-09-07 Initial version
+ * @date 2022-09-07
+ *
+ * @copyright
+ * MIT License
+ *
+ * Copyright (c) 2022 Giel Willemsen
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+
+
+#pragma once
+#ifndef LED_STRIP_EFFECT_H_
+#define LED_STRIP_EFFECT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <esp_err.h>
+#include "led_strip.h"
+
+// Macros
+#define LED_STRIP_EFFECT_MAX_PALETTE_SIZE 16
+
+// Forward declares
+typedef struct led_strip_effect led_strip_effect_t;
+typedef led_strip_effect_t* led_strip_effect_handle_t;
+
+// Functions
+
+/**
+ * @brief Creates an effect for a range of pixels of a led strip. The effect draws nothing until one of the effect functions is
+ * called. Every led_strip_effect_render call then advances it one frame and writes only the pixels that changed since that
+ * framebuffer was rendered last, with double buffering each buffer is tracked separately. Effects on ranges that don't overlap
+ * can run on the same led strip.
+ * 
+ * @param strip The led strip to render into, may not dither or use an external framebuffer.
+ * @param start The first logical pixel of the range.
+ * @param count The number of pixels of the range.
+ * @param effect The resulting handle of the effect.
+ * @return esp_err_t The success code for creating the effect, ESP_ERR_INVALID_SIZE for a range outside the led strip.
+ */
+extern esp_err_t led_strip_effect_create(led_strip_handle_t strip, led_strip_pixel_index_t start, led_strip_pixel_index_t count, led_strip_effect_handle_t *effect);
+
+/**
+ * @brief Frees the effect, the pixels keep the colors it rendered last.
+ * 
+ * @param effect The effect to delete.
+ * @return esp_err_t The success code for deleting the effect.
+ */
+extern esp_err_t led_strip_effect_delete(led_strip_effect_handle_t effect);
+
+/**
+ * @brief Shows a static linear gradient over the range, from the first to the last pixel.
+ * 
+ * @param effect The effect to configure.
+ * @param from The color of the first pixel.
+ * @param to The color of the last pixel.
+ * @return esp_err_t The success code for configuring the effect.
+ */
+extern esp_err_t led_strip_effect_gradient(led_strip_effect_handle_t effect, led_strip_color_t from, led_strip_color_t to);
+
+/**
+ * @brief Fades the range linearly from its current content to a single color. The pixels are read from the framebuffer that the
+ * set functions write to when the crossfade is started.
+ * 
+ * @param effect The effect to configure.
+ * @param target The color the range ends at.
+ * @param frames The number of frames the fade takes, at least 1.
+ * @return esp_err_t The success code for configuring the effect.
+ */
+extern esp_err_t led_strip_effect_crossfade(led_strip_effect_handle_t effect, led_strip_color_t target, uint16_t frames);
+
+/**
+ * @brief Moves a segment of pixels over a background, wrapping around at the ends of the range. Only the pixels that the
+ * segment leaves and enters are rendered.
+ * 
+ * @param effect The effect to configure.
+ * @param color The color of the segment.
+ * @param background The color of the rest of the range.
+ * @param length The length of the segment in pixels, at least 1 and less than the length of the range.
+ * @param speed The distance the segment moves per frame in 1/256 pixel, negative moves towards the start of the range.
+ * @return esp_err_t The success code for configuring the effect.
+ */
+extern esp_err_t led_strip_effect_chase(led_strip_effect_handle_t effect, led_strip_color_t color, led_strip_color_t background, led_strip_pixel_index_t length, int16_t speed);
+
+/**
+ * @brief Spreads a palette once over the range, interpolating between its entries and between the last and the first entry,
+ * and rotates it.
+ * 
+ * @param effect The effect to configure.
+ * @param palette The colors, they are copied.
+ * @param palette_size The number of colors, 2 up to LED_STRIP_EFFECT_MAX_PALETTE_SIZE.
+ * @param speed The distance the palette rotates per frame in 1/65536 palette entries, 0 shows a static palette.
+ * @return esp_err_t The success code for configuring the effect.
+ */
+extern esp_err_t led_strip_effect_palette(led_strip_effect_handle_t effect, const led_strip_color_t *palette, uint8_t palette_size, int32_t speed);
+
+/**
+ * @brief Advances the effect one frame and renders it into the framebuffer that the set functions write to.
+ * 
+ * @param effect The effect to render.
+ * @param changed Set to true if any pixel was written, may be NULL.
+ * @return esp_err_t The success code for rendering the effect.
+ */
+extern esp_err_t led_strip_effect_render(led_strip_effect_handle_t effect, bool *changed);
+
+/**
+ * @brief A led_strip_frame_cb_t for led_strip_start_scheduler that renders the effect given as user context. With more than
+ * one effect on a led strip call led_strip_effect_render for each of them from an own frame callback instead.
+ * 
+ * @param handle The led strip of the effect.
+ * @param user_ctx The led_strip_effect_handle_t.
+ * @return true if the led strip has to be flushed, false if the LEDs already show the frame.
+ */
+extern bool led_strip_effect_frame_cb(led_strip_handle_t handle, void *user_ctx);
+
+#endif // LED_STRIP_EFFECT_H_
@@ -0,0 +1,158 @@
+/**
+ * @file led_strip_network.h
+ * @author Giel Willemsen
+ * @brief Receives DDP, E1.31 and Art-Net pixel data straight into the framebuffers of led strips.
+ * @version 0.1 2022-09-07 Initial version
+ * @date 2022-09-07
+ *
+ * @copyright
+ * MIT License
+ *
+ * Copyright (c) 2022 Giel Willemsen
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+
+
+#pragma once
+#ifndef LED_STRIP_NETWORK_H_
+#define LED_STRIP_NETWORK_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <esp_err.h>
+#include <freertos/FreeRTOS.h>
+#include "led_strip.h"
+
+// Macros
+#define LED_STRIP_NETWORK_DDP_PORT 4048
+#define LED_STRIP_NETWORK_E131_PORT 5568
+#define LED_STRIP_NETWORK_ARTNET_PORT 6454
+
+// Forward declares
+typedef struct led_strip_network led_strip_network_t;
+typedef led_strip_network_t* led_strip_network_handle_t;
+
+// Enums
+typedef enum led_strip_network_protocol {
+    LED_STRIP_NETWORK_PROTOCOL_DDP,     ///< Distributed Display Protocol, one byte addressed stream per device.
+    LED_STRIP_NETWORK_PROTOCOL_E131,    ///< E1.31 (sACN) universes, the universes are joined as multicast groups.
+    LED_STRIP_NETWORK_PROTOCOL_ARTNET,  ///< Art-Net ArtDmx universes, the 15 bit port address is the universe.
+} led_strip_network_protocol_t;
+
+// Structs
+typedef struct led_strip_network_mapping {
+    led_strip_handle_t strip;
+    led_strip_pixel_index_t start;  ///< The first logical pixel of the led strip the data goes to.
+    led_strip_pixel_index_t count;  ///< The number of pixels, data beyond them is ignored.
+    uint32_t address;               ///< The universe for E1.31 and Art-Net, the byte offset of the first pixel in the stream for DDP.
+} led_strip_network_mapping_t;
+
+typedef struct led_strip_network_config {
+    led_strip_network_protocol_t protocol;
+    const led_strip_network_mapping_t *mappings;    ///< Copied, a led strip may appear in more than one mapping.
+    size_t mapping_count;
+    uint16_t port;              ///< The UDP port for led_strip_network_start, 0 for the default port of the protocol.
+    UBaseType_t task_priority;  ///< The priority of the receive task.
+    BaseType_t core_id;         ///< The core the receive task is pinned to, or tskNO_AFFINITY.
+} led_strip_network_config_t;
+
+typedef struct led_strip_network_stats {
+    uint32_t packets;           ///< Packets given to led_strip_network_handle_packet.
+    uint32_t packets_ignored;   ///< Valid packets without pixel data for the mappings, like polls, previews and unmapped universes.
+    uint32_t packets_malformed; ///< Packets that are truncated or not of the protocol.
+    uint32_t packets_late;      ///< E1.31 packets that arrived after a newer packet of their universe and were dropped.
+    uint32_t syncs;             ///< Sync packets, DDP packets with the push flag and data packets that take effect right away.
+    uint32_t flushes;           ///< Flushes that were started.
+} led_strip_network_stats_t;
+
+// Functions
+
+/**
+ * @brief Initializes the given config with the default values, DDP on its default port without mappings, priority 5 without
+ * core affinity.
+ * 
+ * @param config The config to initialize.
+ */
+extern void led_strip_network_init_config(led_strip_network_config_t *config);
+
+/**
+ * @brief Creates a receiver that copies the pixel data of the packets into the framebuffers of the mapped led strips, as is and
+ * with one memcpy per mapping for a led strip without remapping. The sender has to send the pixels in the layout of the
+ * framebuffer, so in wire order with LED_STRIP_PIXEL_FORMAT_WIRE and R, G, B with LED_STRIP_PIXEL_FORMAT_RGB24. The led strips
+ * are flushed on a sync: an E1.31 synchronization packet, an ArtSync or a DDP packet with the push flag. Data without a sync
+ * address, or Art-Net data while no ArtSync was received for 4 seconds, is flushed right away. Enable double buffering on the led
+ * strips so packets can be received while the previous frame is sent. Only available with CONFIG_LED_STRIP_ENABLE_NETWORK.
+ * 
+ * @param config The configuration of the receiver.
+ * @param network The resulting handle of the receiver.
+ * @return esp_err_t The success code for creating the receiver, ESP_ERR_INVALID_ARG for a dithered led strip, ESP_ERR_INVALID_SIZE
+ * for a mapping outside its led strip.
+ */
+extern esp_err_t led_strip_network_create(const led_strip_network_config_t *config, led_strip_network_handle_t *network);
+
+/**
+ * @brief Stops the receive task if it was started and frees the receiver. The led strips keep their last frame.
+ * 
+ * @param network The receiver to delete.
+ * @return esp_err_t The success code for deleting the receiver.
+ */
+extern esp_err_t led_strip_network_delete(led_strip_network_handle_t network);
+
+/**
+ * @brief Processes one UDP payload, for applications that receive the packets themselves. May not be called while the receive
+ * task runs, or concurrently with other functions that use the mapped led strips.
+ * 
+ * @param network The receiver.
+ * @param data The UDP payload.
+ * @param size The size of the payload.
+ * @return esp_err_t The success code for processing the packet, ESP_ERR_INVALID_SIZE for a truncated packet, ESP_ERR_NOT_SUPPORTED
+ * for a packet of another protocol or type.
+ */
+extern esp_err_t led_strip_network_handle_packet(led_strip_network_handle_t network, const uint8_t *data, size_t size);
+
+/**
+ * @brief Opens a UDP socket on the configured port and starts a task that processes every received packet.
+ * 
+ * @param network The receiver to start.
+ * @return esp_err_t The success code for starting, ESP_ERR_INVALID_STATE if it is started already, ESP_FAIL if the socket couldn't
+ * be opened.
+ */
+extern esp_err_t led_strip_network_start(led_strip_network_handle_t network);
+
+/**
+ * @brief Stops the receive task and closes the socket. Takes up to 100 ms, the task checks for it between packets.
+ * 
+ * @param network The receiver to stop.
+ * @return esp_err_t The success code for stopping, ESP_ERR_INVALID_STATE if it isn't started.
+ */
+extern esp_err_t led_strip_network_stop(led_strip_network_handle_t network);
+
+/**
+ * @brief Gets the packet counters of the receiver.
+ * 
+ * @param network The receiver.
+ * @param stats The resulting counters.
+ * @return esp_err_t The success code for getting the counters.
+ */
+extern esp_err_t led_strip_network_get_stats(led_strip_network_handle_t network, led_strip_network_stats_t *stats);
+
+#endif // LED_STRIP_NETWORK_H_
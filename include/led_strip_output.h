@@ -0,0 +1,125 @@
+/**
+ * @file led_strip_output.h
+ * @author Giel Willemsen
+ * @brief An output service that flushes led strips from its own task, fed through a frame queue per led strip.
+ * @version 0.1 2022-09-07 Initial version
+ * @date 2022-09-07
+ *
+ * @copyright
+ * MIT License
+ *
+ * Copyright (c) 2022 Giel Willemsen
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+
+#pragma once
+#ifndef LED_STRIP_OUTPUT_H_
+#define LED_STRIP_OUTPUT_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <esp_err.h>
+#include <freertos/FreeRTOS.h>
+#include "led_strip.h"
+
+// Forward declares
+typedef struct led_strip_output led_strip_output_t;
+typedef led_strip_output_t* led_strip_output_handle_t;
+
+// Structs
+typedef struct led_strip_output_config {
+    UBaseType_t task_priority;  ///< The priority of the output task.
+    BaseType_t core_id;         ///< The core the output task is pinned to, or tskNO_AFFINITY.
+    uint8_t slot_count;         ///< The number of frame slots per led strip, at least 2 so a frame can be filled while another is sent.
+} led_strip_output_config_t;
+
+typedef struct led_strip_output_stats {
+    uint32_t frames_submitted;  ///< Frames given to led_strip_output_submit.
+    uint32_t frames_shown;      ///< Frames that were transmitted.
+    uint32_t frames_coalesced;  ///< Submitted frames that were skipped because a newer frame was submitted before they were transmitted.
+    uint32_t frames_dropped;    ///< led_strip_output_acquire calls that failed because every slot was in use.
+    uint32_t frames_failed;     ///< Frames that the output task released without showing them, because they couldn't be loaded into the led strip, its flush didn't start or didn't finish.
+} led_strip_output_stats_t;
+
+// Functions
+
+/**
+ * @brief Initializes the given config with the default values, priority 5 without core affinity and 3 slots.
+ * 
+ * @param config The config to initialize.
+ */
+extern void led_strip_output_init_config(led_strip_output_config_t *config);
+
+/**
+ * @brief Starts an output task that from now on owns the given led strips. Frames are handed to it with led_strip_output_acquire
+ * and led_strip_output_submit, it transmits the newest submitted frame of every led strip back to back. The led strips may not be
+ * used with any other led_strip function until the output is deleted. The translation runs on the core of the output task, the RMT
+ * interrupt on the core the led strip was installed from.
+ * 
+ * @param strips The led strips to output, a led strip without a submitted frame isn't transmitted.
+ * @param strip_count The number of led strips.
+ * @param config The configuration of the output.
+ * @param output The resulting handle of the output.
+ * @return esp_err_t The success code for creating the output, ESP_ERR_INVALID_ARG for a led strip that dithers, has a refresh task or a scheduler.
+ */
+extern esp_err_t led_strip_output_create(const led_strip_handle_t *strips, size_t strip_count, const led_strip_output_config_t *config, led_strip_output_handle_t *output);
+
+/**
+ * @brief Stops the output task after its current transmissions and frees the frame slots. The led strips keep their last frame,
+ * except a led strip with an external framebuffer: it sent the slots in place and gets back the buffer it had before led_strip_output_create.
+ * 
+ * @param output The output to delete.
+ * @return esp_err_t The success code for deleting the output.
+ */
+extern esp_err_t led_strip_output_delete(led_strip_output_handle_t output);
+
+/**
+ * @brief Gets a free frame slot to render the next frame of a led strip into, must be followed by led_strip_output_submit.
+ * Only one task may produce the frames of a led strip.
+ * 
+ * @param output The output the led strip belongs to.
+ * @param strip_index The index of the led strip in the array given to led_strip_output_create.
+ * @param frame The slot, led_count pixels in the pixel_format of the led strip.
+ * @return esp_err_t The success code for getting a slot, ESP_ERR_NOT_FINISHED if every slot is in use and the frame has to be dropped.
+ */
+extern esp_err_t led_strip_output_acquire(led_strip_output_handle_t output, size_t strip_index, led_strip_color_component_t **frame);
+
+/**
+ * @brief Hands the frame obtained with led_strip_output_acquire to the output task.
+ * 
+ * @param output The output the led strip belongs to.
+ * @param strip_index The index of the led strip in the array given to led_strip_output_create.
+ * @return esp_err_t The success code for submitting the frame, ESP_ERR_INVALID_STATE if no slot was acquired.
+ */
+extern esp_err_t led_strip_output_submit(led_strip_output_handle_t output, size_t strip_index);
+
+/**
+ * @brief Gets the frame counters of a led strip of the output.
+ * 
+ * @param output The output the led strip belongs to.
+ * @param strip_index The index of the led strip in the array given to led_strip_output_create.
+ * @param stats The resulting counters.
+ * @return esp_err_t The success code for getting the counters.
+ */
+extern esp_err_t led_strip_output_get_stats(led_strip_output_handle_t output, size_t strip_index, led_strip_output_stats_t *stats);
+
+#endif // LED_STRIP_OUTPUT_H_
@@ -0,0 +1,93 @@
+/**
+ * @file led_strip_parallel.h
+ * @author Giel Willemsen
+ * @brief A parallel bus that sends 8 or 16 led strips at once with the I2S or LCD peripheral and one DMA transfer.
+ * @version 0.1 2022-09-07 Initial version
+ * @date 2022-09-07
+ *
+ * @copyright
+ * MIT License
+ *
+ * Copyright (c) 2022 Giel Willemsen
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+
+
+#pragma once
+#ifndef LED_STRIP_PARALLEL_H_
+#define LED_STRIP_PARALLEL_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <esp_err.h>
+#include "led_strip.h"
+
+// Macros
+#define LED_STRIP_PARALLEL_MAX_LANES 16
+
+// Structs
+typedef struct led_strip_parallel_bus_config {
+    int lane_gpio_nums[LED_STRIP_PARALLEL_MAX_LANES]; ///< The data GPIO of every lane, a led strip is installed on the lane with its gpio_output_num.
+    uint8_t lane_count;         ///< The number of lanes, 8 or 16.
+    int clock_gpio_num;         ///< The pixel clock output, the peripheral needs it but the led strips don't, so it can be left unconnected.
+    int dc_gpio_num;            ///< The data/command output, like clock_gpio_num only needed by the peripheral.
+    led_strip_timing_config_t timing_config; ///< The timing of the bus, every led strip on it has to use the same timing.
+    led_strip_pixel_index_t max_led_count;   ///< The led count of the longest led strip on the bus.
+    bool enable_w_channel;      ///< Size the transfer buffer for 4 components per pixel, needed if any led strip has a W channel.
+} led_strip_parallel_bus_config_t;
+
+// Functions
+
+/**
+ * @brief Initializes the given config with the default values, 8 lanes with unset GPIOs and the default timing.
+ * 
+ * @param config The config to initialize.
+ */
+extern void led_strip_parallel_bus_init_config(led_strip_parallel_bus_config_t *config);
+
+/**
+ * @brief Claims the I2S (ESP32) or LCD_CAM (ESP32-S3) peripheral as a parallel bus and allocates its DMA buffer. Led strips are put on
+ * it by installing them with parallel_bus in their led_strip_config_t, they can use every function of the led strip API except baked
+ * frames. Every bit is sent as three clock cycles: high, the bit and low, so a 0 bit is high for a third of the bit period and a 1 bit
+ * for two thirds. The translation is a bit-transpose of all lanes at once into the DMA buffer (24 bytes per color component with 8 lanes,
+ * 48 with 16) instead of an interrupt that refills the RMT memory. Only available with CONFIG_LED_STRIP_ENABLE_PARALLEL.
+ * 
+ * A flush of a led strip starts a transfer of the whole bus, the other lanes stay low and keep their frame. The bus sends one transfer
+ * at a time, so the other led strips are busy until it is done. Put the led strips in a group (see led_strip_group_create) to send
+ * them all in one transfer: the transfer then starts once every led strip of the group was flushed. Until then the flush of a grouped
+ * led strip isn't done, led_strip_wait_for_flush_finish returns ESP_ERR_TIMEOUT for it.
+ * 
+ * @param config The configuration of the bus.
+ * @param bus The resulting handle of the bus.
+ * @return esp_err_t The success code for creating the bus, ESP_ERR_INVALID_ARG for a lane count other than 8 or 16 or a lane without a GPIO.
+ */
+extern esp_err_t led_strip_parallel_bus_create(const led_strip_parallel_bus_config_t *config, led_strip_parallel_bus_handle_t *bus);
+
+/**
+ * @brief Releases the peripheral and frees the bus.
+ * 
+ * @param bus The bus to delete.
+ * @return esp_err_t The success code for deleting the bus, ESP_ERR_INVALID_STATE while led strips are still installed on it.
+ */
+extern esp_err_t led_strip_parallel_bus_delete(led_strip_parallel_bus_handle_t bus);
+
+#endif // LED_STRIP_PARALLEL_H_
@@ -32,38 +32,87 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
 #include <esp_log.h>
-#include <driver/rmt.h>
-#include "led_strip.h"
-
-#define CALC_COLOR_SIZE(handle) (handle->enable_w_channel ? 4 : 3)
-#define BIT_SET(val, bit) (((val) & (1UL << (bit))) == (1UL << (bit)))
-
-typedef struct led_strip
-{
-    rmt_channel_t channel;
-    led_strip_manual_timing_t led_timing;
-    led_strip_color_order_t color_order;
-    led_strip_color_component_t *pixel_colors;
-    led_strip_pixel_index_t led_count;
-    bool enable_w_channel;
-    bool has_flushed;
-} led_strip_t;
-
-static esp_err_t find_empty_channel(rmt_channel_t *channel);
-static void mark_channel_free(rmt_channel_t channel);
-static void mark_channel_used(rmt_channel_t channel);
-static void IRAM_ATTR rmt_adapter(const void *src, rmt_item32_t *dest, size_t src_size, size_t wanted_num, size_t *translated_size, size_t *item_num);
-static void IRAM_ATTR translate_uint8_to_rmt_samples(rmt_item32_t *items, uint8_t data, led_strip_manual_timing_t timing);
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+#include <esp_intr_alloc.h>
+#include <esp_rom_sys.h>
+#include <esp_idf_version.h>
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+#include <esp_memory_utils.h>
+#else
+#include <soc/soc_memory_layout.h>
+#endif
+#if !CONFIG_FREERTOS_UNICORE
+#include <esp_ipc.h>
+#endif
+#include "led_strip_private.h"
+
+// Bit timings of the predefined led strip types.
+#define SK6822_LOW_ON LED_STRIP_NS_AS_TICKS(300)
+#define SK6822_LOW_OFF LED_STRIP_NS_AS_TICKS(900)
+#define SK6822_HIGH_ON LED_STRIP_NS_AS_TICKS(600)
+#define SK6822_HIGH_OFF LED_STRIP_NS_AS_TICKS(600)
+#define SK6822_RESET_TIME LED_STRIP_US_AS_TICKS(80)
+#define WS281X_LOW_ON LED_STRIP_NS_AS_TICKS(350)
+#define WS281X_LOW_OFF LED_STRIP_NS_AS_TICKS(900)
+#define WS281X_HIGH_ON LED_STRIP_NS_AS_TICKS(900)
+#define WS281X_HIGH_OFF LED_STRIP_NS_AS_TICKS(350)
+#define WS281X_RESET_TIME LED_STRIP_US_AS_TICKS(50)
+
+#if LED_STRIP_FIXED_TIMING
+#if CONFIG_LED_STRIP_FIXED_TIMING_WS281X
+#define FIXED_TIMING(field) ((uint32_t)WS281X_##field)
+#else
+#define FIXED_TIMING(field) ((uint32_t)SK6822_##field)
+#endif
+#define FIXED_HIGH_SYMBOL LED_STRIP_SYMBOL(1, FIXED_TIMING(HIGH_ON), 0, FIXED_TIMING(HIGH_OFF))
+#define FIXED_LOW_SYMBOL LED_STRIP_SYMBOL(1, FIXED_TIMING(LOW_ON), 0, FIXED_TIMING(LOW_OFF))
+#endif
+
+#if !LED_STRIP_CONST_SYMBOL_LUT
+static void build_symbol_lut(uint32_t *symbol_lut, const led_strip_manual_timing_t *timing, const uint8_t *levels);
+#endif
 static led_strip_handle_t alloc_led_strip(const led_strip_config_t *config);
+static esp_err_t alloc_remap(led_strip_handle_t handle);
 static void dealloc_led_strip(led_strip_handle_t);
+static uint32_t framebuffer_caps(led_strip_handle_t handle);
 static led_strip_manual_timing_t map_timing(led_strip_timing_config_t config);
 static led_strip_color_t convert_from_rgbw_to_rgb(led_strip_color_t color);
-static led_strip_color_t convert_from_rgb_to_rgbw(led_strip_color_t color);
+static led_strip_color_t convert_from_rgb_to_rgbw(const white_extraction_t *white, led_strip_color_t color);
+static white_extraction_t map_white_point(led_strip_color_t white_point);
+static color_offsets_t map_color_offsets(led_strip_color_order_t color_order);
+static uint8_t map_pixel_stride(const led_strip_config_t *config);
+static void map_swizzle(led_strip_handle_t handle);
 static void set_color_data(led_strip_handle_t handle, led_strip_pixel_index_t index, led_strip_color_t color);
+static void fill_color_data(led_strip_handle_t handle, led_strip_color_t color);
+static esp_err_t check_pixel_range(led_strip_handle_t handle, led_strip_pixel_index_t start, led_strip_pixel_index_t count);
+static size_t partial_flush_pixel_count(led_strip_handle_t handle);
+static esp_err_t update_levels(led_strip_handle_t handle);
+static esp_err_t stage_frame(led_strip_handle_t handle, const led_strip_color_component_t *pixels, size_t pixel_count);
+static esp_err_t poll_flush_done(led_strip_handle_t handle, bool *done);
+static esp_err_t ensure_flush_done(led_strip_handle_t handle);
+static esp_err_t transmit_frame(led_strip_handle_t handle, bool wait_tx_done);
+static esp_err_t transmit_baked_frame(led_strip_handle_t handle, int slot, bool wait_tx_done);
+static void wait_for_latch(led_strip_handle_t handle);
+static void stats_frame_started(led_strip_handle_t handle);
+static void stats_frame_failed(led_strip_handle_t handle, esp_err_t err);
+static void stats_frame_dropped(led_strip_handle_t handle);
+static void stats_frame_done(led_strip_handle_t handle);
 
 static bool initialized = false;
-static bool rmt_channel_used[RMT_CHANNEL_MAX];
+
+#if LED_STRIP_CONST_SYMBOL_LUT
+#define FIXED_SYMBOL(value, bit) (BIT_SET(value, bit) ? FIXED_HIGH_SYMBOL : FIXED_LOW_SYMBOL)
+#define FIXED_NIBBLE_SYMBOLS(value) FIXED_SYMBOL(value, 3), FIXED_SYMBOL(value, 2), FIXED_SYMBOL(value, 1), FIXED_SYMBOL(value, 0)
+DRAM_ATTR const uint32_t led_strip_fixed_symbol_lut[SYMBOL_LUT_SIZE] = {
+    FIXED_NIBBLE_SYMBOLS(0x0), FIXED_NIBBLE_SYMBOLS(0x1), FIXED_NIBBLE_SYMBOLS(0x2), FIXED_NIBBLE_SYMBOLS(0x3),
+    FIXED_NIBBLE_SYMBOLS(0x4), FIXED_NIBBLE_SYMBOLS(0x5), FIXED_NIBBLE_SYMBOLS(0x6), FIXED_NIBBLE_SYMBOLS(0x7),
+    FIXED_NIBBLE_SYMBOLS(0x8), FIXED_NIBBLE_SYMBOLS(0x9), FIXED_NIBBLE_SYMBOLS(0xA), FIXED_NIBBLE_SYMBOLS(0xB),
+    FIXED_NIBBLE_SYMBOLS(0xC), FIXED_NIBBLE_SYMBOLS(0xD), FIXED_NIBBLE_SYMBOLS(0xE), FIXED_NIBBLE_SYMBOLS(0xF),
+};
+#endif
 
 extern void led_strip_init(void)
 {
@@ -71,9 +120,9 @@ extern void led_strip_init(void)
     {
         return;
     }
-    for (int i = 0; i < (int)RMT_CHANNEL_MAX; i++)
+    if (led_strip_rmt_backend.init != NULL)
     {
-        rmt_channel_used[i] = false;
+        led_strip_rmt_backend.init();
     }
     initialized = true;
 }
@@ -85,11 +134,39 @@ extern void led_strip_init_config(led_strip_config_t *config)
         return;
     }
     config->timing_config.use_manual_timing = false;
+#if LED_STRIP_FIXED_TIMING
+    config->timing_config.timing.type = LED_STRIP_FIXED_TYPE;
+#else
     config->timing_config.timing.type = LED_STRIP_TYPE_SK6822;
+#endif
+#if LED_STRIP_FIXED_COLOR_ORDER
+    config->color_order = LED_STRIP_FIXED_ORDER;
+    config->enable_w_channel = LED_STRIP_FIXED_W_CHANNEL;
+#else
     config->color_order = LED_STRIP_COLOR_ORDER_RGBW;
+    config->enable_w_channel = false;
+#endif
     config->gpio_output_num = -1;
     config->led_count = 0;
-    config->enable_w_channel = false;
+    config->enable_double_buffer = false;
+    config->baked_frame_count = 0;
+    config->mem_block_num = 1;
+    config->with_dma = false;
+    config->enable_partial_flush = false;
+    config->enable_dithering = false;
+    config->memory_policy = LED_STRIP_MEMORY_INTERNAL;
+    config->external_buffer = NULL;
+    config->intr_flags = 0;
+    config->intr_core = tskNO_AFFINITY;
+    config->pixel_format = LED_STRIP_PIXEL_FORMAT_WIRE;
+    config->parallel_bus = NULL;
+    config->spi_host = -1;
+    config->spi_clock_gpio_num = -1;
+    config->spi_clock_hz = 10 * 1000 * 1000;
+    config->white_point.r = 255;
+    config->white_point.g = 255;
+    config->white_point.b = 255;
+    config->white_point.w = 0;
     return;
 }
 
@@ -99,185 +176,413 @@ extern esp_err_t led_strip_install(led_strip_handle_t *new_handle, const led_str
     {
         return ESP_ERR_INVALID_ARG;
     }
-    else if (config->led_count == 2)
+    else if (config->external_buffer != NULL && (config->enable_double_buffer || config->enable_dithering))
+    {
+        return ESP_ERR_INVALID_ARG; // Both write to the framebuffer behind the back of the caller.
+    }
+    else if ((config->intr_flags & ESP_INTR_FLAG_IRAM) && (config->memory_policy != LED_STRIP_MEMORY_INTERNAL ||
+                                                           (config->external_buffer != NULL && esp_ptr_internal(config->external_buffer) == false)))
+    {
+        return ESP_ERR_INVALID_ARG; // PSRAM can't be read while the flash cache is disabled.
+    }
+    else if (config->pixel_format > LED_STRIP_PIXEL_FORMAT_RGBA32 || (config->pixel_format == LED_STRIP_PIXEL_FORMAT_RGB24 && config->enable_w_channel))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    else if (config->spi_host >= 0 && config->parallel_bus != NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+#if !CONFIG_LED_STRIP_ENABLE_PARALLEL
+    else if (config->parallel_bus != NULL)
     {
         return ESP_ERR_NOT_SUPPORTED;
     }
+#endif
+#if LED_STRIP_FIXED_COLOR_ORDER
+    else if (config->enable_w_channel != LED_STRIP_FIXED_W_CHANNEL || config->color_order != LED_STRIP_FIXED_ORDER || config->pixel_format != LED_STRIP_PIXEL_FORMAT_WIRE)
+    {
+        return ESP_ERR_NOT_SUPPORTED; // The pixel layout is compiled in.
+    }
+#endif
+#if LED_STRIP_FIXED_TIMING
+    else if (config->timing_config.use_manual_timing || config->timing_config.timing.type != LED_STRIP_FIXED_TYPE)
+    {
+        return ESP_ERR_NOT_SUPPORTED; // The symbols are compiled in.
+    }
+#endif
     led_strip_handle_t handle = alloc_led_strip(config);
     if (handle == NULL)
     {
         return ESP_ERR_NO_MEM;
     }
-    *new_handle = handle;
     handle->led_timing = map_timing(config->timing_config);
+#if !LED_STRIP_CONST_SYMBOL_LUT
+    build_symbol_lut(handle->symbol_lut, &handle->led_timing, NULL);
+#endif
     handle->enable_w_channel = config->enable_w_channel;
     handle->color_order = config->color_order;
+    handle->pixel_format = config->pixel_format;
+    if (config->pixel_format == LED_STRIP_PIXEL_FORMAT_WIRE)
+    {
+        handle->color_offsets = map_color_offsets(config->color_order);
+    }
+    else
+    {
+        handle->color_offsets = (color_offsets_t)LED_STRIP_CANONICAL_OFFSETS;
+    }
+    map_swizzle(handle);
+    handle->white = map_white_point(config->white_point);
     handle->led_count = config->led_count;
     handle->has_flushed = false;
+    handle->brightness = 255;
+    handle->enable_partial_flush = config->enable_partial_flush;
+    handle->iram_safe = (config->intr_flags & ESP_INTR_FLAG_IRAM) != 0;
+    handle->tx_done_time = 0;
+    handle->dirty_end = config->led_count; // Nothing is known about what the LEDs show before the first flush.
+    handle->live_baked_frame = NO_BAKED_FRAME;
+    handle->transmitting_baked_frame = NO_BAKED_FRAME;
 
-    rmt_channel_t channel = RMT_CHANNEL_MAX;
-    esp_err_t err = find_empty_channel(&channel);
+    handle->backend = &led_strip_rmt_backend;
+    if (config->spi_host >= 0)
+    {
+        handle->backend = &led_strip_spi_backend;
+    }
+#if CONFIG_LED_STRIP_ENABLE_PARALLEL
+    else if (config->parallel_bus != NULL)
+    {
+        handle->backend = &led_strip_parallel_backend;
+    }
+#endif
+    handle->latch_time_us = handle->backend->sends_reset ? 0 : (uint32_t)LED_STRIP_TICKS_AS_US(handle->led_timing.reset_time);
+    esp_err_t err = handle->backend->install(handle, config);
     ESP_ERROR_CHECK_WITHOUT_ABORT(err);
     if (err != ESP_OK)
     {
         dealloc_led_strip(handle);
         return err;
     }
-    mark_channel_used(channel);
+    *new_handle = handle;
+    return ESP_OK;
+}
 
-    rmt_config_t rmt_channel_config = RMT_DEFAULT_CONFIG_TX(config->gpio_output_num, channel);
-    rmt_channel_config.clk_div = LED_STRIP_CLOCK_DIVIDER;
-    err = rmt_config(&rmt_channel_config);
+extern esp_err_t led_strip_free(led_strip_handle_t handle)
+{
+    if (handle == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (handle->refresh_task != NULL)
+    {
+        led_strip_stop_refresh(handle);
+    }
+    if (handle->scheduler != NULL)
+    {
+        led_strip_stop_scheduler(handle);
+    }
+    esp_err_t err = handle->backend->uninstall(handle);
     ESP_ERROR_CHECK_WITHOUT_ABORT(err);
     if (err != ESP_OK)
     {
-        dealloc_led_strip(handle);
-        mark_channel_free(channel);
         return err;
     }
+    dealloc_led_strip(handle);
+    return ESP_OK;
+}
 
-    err = rmt_driver_install(rmt_channel_config.channel, 0, 0);
-    ESP_ERROR_CHECK_WITHOUT_ABORT(err);
-    if (err != ESP_OK)
+extern esp_err_t led_strip_flush(led_strip_handle_t handle)
+{
+    if (handle == NULL)
     {
-        dealloc_led_strip(handle);
-        mark_channel_free(channel);
-        return err;
+        return ESP_ERR_INVALID_ARG;
     }
+    return transmit_frame(handle, true);
+}
 
-    err = rmt_translator_init(rmt_channel_config.channel, rmt_adapter);
-    ESP_ERROR_CHECK_WITHOUT_ABORT(err);
-    if (err != ESP_OK)
+extern esp_err_t led_strip_flush_unchecked(led_strip_handle_t handle)
+{
+    return transmit_frame(handle, true);
+}
+
+extern esp_err_t led_strip_flush_done(led_strip_handle_t handle, bool *done)
+{
+    if (handle == NULL || done == NULL)
     {
-        dealloc_led_strip(handle);
-        mark_channel_free(channel);
-        return err;
+        return ESP_ERR_INVALID_ARG;
     }
+    return poll_flush_done(handle, done);
+}
 
-    err = rmt_translator_set_context(rmt_channel_config.channel, handle);
-    ESP_ERROR_CHECK_WITHOUT_ABORT(err);
+extern bool led_strip_flush_done_unchecked(led_strip_handle_t handle)
+{
+    bool done = false;
+    return poll_flush_done(handle, &done) != ESP_OK || done;
+}
+
+extern esp_err_t led_strip_start_flush(led_strip_handle_t handle)
+{
+    if (handle == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return transmit_frame(handle, false);
+}
+
+extern esp_err_t led_strip_start_flush_unchecked(led_strip_handle_t handle)
+{
+    return transmit_frame(handle, false);
+}
+
+extern esp_err_t led_strip_wait_for_flush_finish(led_strip_handle_t handle)
+{
+    if (handle == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_err_t err = handle->backend->wait_tx_done(handle, portMAX_DELAY);
+    LED_STRIP_HOT_PATH_ERROR_CHECK(err);
     if (err != ESP_OK)
     {
-        dealloc_led_strip(handle);
-        mark_channel_free(channel);
         return err;
     }
+    return ESP_OK;
+}
 
-    err = rmt_set_tx_loop_mode(rmt_channel_config.channel, false);
-    ESP_ERROR_CHECK_WITHOUT_ABORT(err);
+extern esp_err_t led_strip_register_flush_done_callback(led_strip_handle_t handle, led_strip_flush_done_cb_t callback, void *user_ctx)
+{
+    if (handle == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    // The ISR only reads these fields while a transmission is ongoing.
+    esp_err_t err = ensure_flush_done(handle);
     if (err != ESP_OK)
     {
-        dealloc_led_strip(handle);
-        mark_channel_free(channel);
-        return err;
+        return err == ESP_ERR_NOT_FINISHED ? ESP_ERR_INVALID_STATE : err;
     }
-    err = rmt_set_tx_intr_en(RMT_CHANNEL_0, false);
-    ESP_ERROR_CHECK_WITHOUT_ABORT(err);
+    handle->flush_done_callback = callback;
+    handle->flush_done_user_ctx = user_ctx;
+    return ESP_OK;
+}
+
+extern esp_err_t led_strip_set_flush_done_notify(led_strip_handle_t handle, TaskHandle_t task, uint32_t notify_bits)
+{
+    if (handle == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_err_t err = ensure_flush_done(handle);
     if (err != ESP_OK)
     {
-        dealloc_led_strip(handle);
-        mark_channel_free(channel);
-        return err;
+        return err == ESP_ERR_NOT_FINISHED ? ESP_ERR_INVALID_STATE : err;
+    }
+    handle->notify_task = task;
+    handle->notify_bits = notify_bits;
+    return ESP_OK;
+}
+
+extern esp_err_t led_strip_get_stats(led_strip_handle_t handle, led_strip_stats_t *stats)
+{
+#if CONFIG_LED_STRIP_ENABLE_STATS
+    if (handle == NULL || stats == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
     }
+    portENTER_CRITICAL(&handle->stats_lock);
+    *stats = handle->stats;
+    portEXIT_CRITICAL(&handle->stats_lock);
+    return ESP_OK;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
 
+extern esp_err_t led_strip_reset_stats(led_strip_handle_t handle)
+{
+#if CONFIG_LED_STRIP_ENABLE_STATS
+    if (handle == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    portENTER_CRITICAL(&handle->stats_lock);
+    memset(&handle->stats, 0, sizeof(led_strip_stats_t));
+    portEXIT_CRITICAL(&handle->stats_lock);
     return ESP_OK;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
 }
 
-extern esp_err_t led_strip_free(led_strip_handle_t handle)
+extern esp_err_t led_strip_set_remap_table(led_strip_handle_t handle, const led_strip_pixel_index_t *table)
 {
-    esp_err_t err = rmt_driver_uninstall(handle->channel);
-    ESP_ERROR_CHECK_WITHOUT_ABORT(err);
+    if (handle == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (table == NULL)
+    {
+        free(handle->remap);
+        handle->remap = NULL;
+        return ESP_OK;
+    }
+    for (led_strip_pixel_index_t i = 0; i < handle->led_count; i++)
+    {
+        if (table[i] >= handle->led_count)
+        {
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+    esp_err_t err = alloc_remap(handle);
     if (err != ESP_OK)
     {
         return err;
     }
-    mark_channel_free(handle->channel);
-    dealloc_led_strip(handle);
+    memcpy(handle->remap, table, handle->led_count * sizeof(led_strip_pixel_index_t));
     return ESP_OK;
 }
 
-extern esp_err_t led_strip_flush(led_strip_handle_t handle)
+extern esp_err_t led_strip_set_matrix_layout(led_strip_handle_t handle, led_strip_pixel_index_t width, led_strip_pixel_index_t height, led_strip_matrix_layout_t layout)
 {
-    bool ready = false;
-    esp_err_t err = led_strip_flush_done(handle, &ready);
-    ESP_ERROR_CHECK_WITHOUT_ABORT(err);
+    if (handle == NULL || width == 0 || height == 0)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    else if ((size_t)width * height > handle->led_count)
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    esp_err_t err = alloc_remap(handle);
     if (err != ESP_OK)
     {
         return err;
     }
-    if (ready == false)
+
+    for (size_t y = 0; y < height; y++)
     {
-        return ESP_ERR_NOT_FINISHED;
+        for (size_t x = 0; x < width; x++)
+        {
+            size_t pixel;
+            switch (layout)
+            {
+            case LED_STRIP_MATRIX_LAYOUT_SERPENTINE:
+                pixel = (y * width) + ((y % 2) == 0 ? x : (width - 1) - x);
+                break;
+            case LED_STRIP_MATRIX_LAYOUT_COLUMN_MAJOR:
+                pixel = (x * height) + y;
+                break;
+            case LED_STRIP_MATRIX_LAYOUT_COLUMN_SERPENTINE:
+                pixel = (x * height) + ((x % 2) == 0 ? y : (height - 1) - y);
+                break;
+            case LED_STRIP_MATRIX_LAYOUT_ROW_MAJOR:
+            default:
+                pixel = (y * width) + x;
+                break;
+            }
+            handle->remap[(y * width) + x] = (led_strip_pixel_index_t)pixel;
+        }
+    }
+    // The LEDs after the matrix keep their own index.
+    for (size_t i = (size_t)width * height; i < handle->led_count; i++)
+    {
+        handle->remap[i] = (led_strip_pixel_index_t)i;
     }
+    return ESP_OK;
+}
 
-    const size_t data_count = handle->led_count * CALC_COLOR_SIZE(handle);
-    err = rmt_write_sample(handle->channel, handle->pixel_colors, data_count, true);
-    ESP_ERROR_CHECK_WITHOUT_ABORT(err);
-    if (err != ESP_OK)
+extern esp_err_t led_strip_set_white_point(led_strip_handle_t handle, led_strip_color_t white_point)
+{
+    if (handle == NULL)
     {
-        return err;
+        return ESP_ERR_INVALID_ARG;
     }
-    handle->has_flushed = true;
+    handle->white = map_white_point(white_point);
     return ESP_OK;
 }
 
-extern esp_err_t led_strip_flush_done(led_strip_handle_t handle, bool *done)
+extern esp_err_t led_strip_extract_white(led_strip_handle_t handle)
 {
-    if (handle == NULL || done == NULL)
+    if (handle == NULL)
     {
         return ESP_ERR_INVALID_ARG;
     }
-    if (handle->has_flushed == false)
+    else if (LED_STRIP_HAS_W_CHANNEL(handle) == false)
     {
-        *done = true;
-        return ESP_OK;
+        return ESP_ERR_NOT_SUPPORTED;
     }
-    esp_err_t err = rmt_wait_tx_done(handle->channel, 0);
-    ESP_ERROR_CHECK_WITHOUT_ABORT(err);
-    *done = (err == ESP_OK);
-    if (err != ESP_OK && err != ESP_ERR_TIMEOUT)
+
+    const color_offsets_t offsets = LED_STRIP_COLOR_OFFSETS(handle);
+    const white_extraction_t white = handle->white;
+    led_strip_color_component_t *pixel = handle->pixel_colors;
+    for (led_strip_pixel_index_t i = 0; i < handle->led_count; i++, pixel += 4)
     {
-        return err;
+        led_strip_color_t color = {
+            .r = pixel[offsets.r],
+            .g = pixel[offsets.g],
+            .b = pixel[offsets.b],
+            .w = 0x00,
+        };
+        color = convert_from_rgb_to_rgbw(&white, color);
+        const uint32_t w = pixel[offsets.w] + color.w;
+        pixel[offsets.r] = color.r;
+        pixel[offsets.g] = color.g;
+        pixel[offsets.b] = color.b;
+        pixel[offsets.w] = (led_strip_color_component_t)(w < 255 ? w : 255);
     }
+    led_strip_mark_pixels_changed(handle, handle->led_count);
     return ESP_OK;
 }
 
-extern esp_err_t led_strip_start_flush(led_strip_handle_t handle)
+extern esp_err_t led_strip_set_brightness(led_strip_handle_t handle, uint8_t brightness)
 {
     if (handle == NULL)
     {
         return ESP_ERR_INVALID_ARG;
     }
-    bool ready = false;
-    esp_err_t err = led_strip_flush_done(handle, &ready);
-    ESP_ERROR_CHECK_WITHOUT_ABORT(err);
-    if (err != ESP_OK)
+    handle->brightness = brightness;
+    handle->levels_changed = true;
+    // Every LED changes, so the whole strip has to be sent again.
+    led_strip_mark_pixels_changed(handle, handle->led_count);
+    return ESP_OK;
+}
+
+extern esp_err_t led_strip_set_gamma_table(led_strip_handle_t handle, const uint8_t *table)
+{
+    if (handle == NULL)
     {
-        return err;
+        return ESP_ERR_INVALID_ARG;
     }
-    if (ready == false)
+    if (table == NULL)
     {
-        return ESP_ERR_NOT_FINISHED;
+        free(handle->gamma_table);
+        handle->gamma_table = NULL;
     }
-
-    const size_t data_count = handle->led_count * CALC_COLOR_SIZE(handle);
-    err = rmt_write_sample(handle->channel, handle->pixel_colors, data_count, false);
-    ESP_ERROR_CHECK_WITHOUT_ABORT(err);
-    if (err != ESP_OK)
+    else
     {
-        return err;
+        if (handle->gamma_table == NULL)
+        {
+            handle->gamma_table = (uint8_t *)malloc(LED_STRIP_GAMMA_TABLE_SIZE);
+            if (handle->gamma_table == NULL)
+            {
+                return ESP_ERR_NO_MEM;
+            }
+        }
+        memcpy(handle->gamma_table, table, LED_STRIP_GAMMA_TABLE_SIZE);
     }
-    handle->has_flushed = true;
+    handle->levels_changed = true;
+    led_strip_mark_pixels_changed(handle, handle->led_count);
     return ESP_OK;
 }
 
-extern esp_err_t led_strip_wait_for_flush_finish(led_strip_handle_t handle)
+extern esp_err_t led_strip_build_gamma_table(uint8_t *table, float gamma)
 {
-    esp_err_t err = rmt_wait_tx_done(handle->channel, portMAX_DELAY);
-    ESP_ERROR_CHECK_WITHOUT_ABORT(err);
-    if (err != ESP_OK)
+    if (table == NULL || gamma <= 0.0f)
     {
-        return err;
+        return ESP_ERR_INVALID_ARG;
+    }
+    const float max_level = (float)(LED_STRIP_GAMMA_TABLE_SIZE - 1);
+    for (int i = 0; i < LED_STRIP_GAMMA_TABLE_SIZE; i++)
+    {
+        table[i] = (uint8_t)(powf((float)i / max_level, gamma) * max_level + 0.5f);
     }
     return ESP_OK;
 }
@@ -292,18 +597,25 @@ extern esp_err_t led_strip_set_pixel_rgb(led_strip_handle_t handle, led_strip_pi
     {
         return ESP_ERR_INVALID_SIZE;
     }
+    led_strip_set_pixel_rgb_unchecked(handle, index, r, g, b);
+    return ESP_OK;
+}
+
+extern void led_strip_set_pixel_rgb_unchecked(led_strip_handle_t handle, led_strip_pixel_index_t index, led_strip_color_component_t r, led_strip_color_component_t g, led_strip_color_component_t b)
+{
     led_strip_color_t color = {
         .r = r,
         .g = g,
         .b = b,
         .w = 0x00,
     };
-    if (handle->enable_w_channel)
+    if (LED_STRIP_HAS_W_CHANNEL(handle))
     {
-        color = convert_from_rgb_to_rgbw(color);
+        color = convert_from_rgb_to_rgbw(&handle->white, color);
     }
-    set_color_data(handle, index, color);
-    return ESP_OK;
+    const led_strip_pixel_index_t pixel = led_strip_physical_index(handle, index);
+    set_color_data(handle, pixel, color);
+    led_strip_mark_pixels_changed(handle, pixel + 1);
 }
 
 extern esp_err_t led_strip_set_pixel_rgbw(led_strip_handle_t handle, led_strip_pixel_index_t index, led_strip_color_component_t r, led_strip_color_component_t g, led_strip_color_component_t b, led_strip_color_component_t w)
@@ -316,18 +628,25 @@ extern esp_err_t led_strip_set_pixel_rgbw(led_strip_handle_t handle, led_strip_p
     {
         return ESP_ERR_INVALID_SIZE;
     }
+    led_strip_set_pixel_rgbw_unchecked(handle, index, r, g, b, w);
+    return ESP_OK;
+}
+
+extern void led_strip_set_pixel_rgbw_unchecked(led_strip_handle_t handle, led_strip_pixel_index_t index, led_strip_color_component_t r, led_strip_color_component_t g, led_strip_color_component_t b, led_strip_color_component_t w)
+{
     led_strip_color_t color = {
         .r = r,
         .g = g,
         .b = b,
         .w = w,
     };
-    if (handle->enable_w_channel == false)
+    if (LED_STRIP_HAS_W_CHANNEL(handle) == false)
     {
         color = convert_from_rgbw_to_rgb(color);
     }
-    set_color_data(handle, index, color);
-    return ESP_OK;
+    const led_strip_pixel_index_t pixel = led_strip_physical_index(handle, index);
+    set_color_data(handle, pixel, color);
+    led_strip_mark_pixels_changed(handle, pixel + 1);
 }
 
 extern esp_err_t led_strip_fill_rgb(led_strip_handle_t handle, led_strip_color_component_t r, led_strip_color_component_t g, led_strip_color_component_t b)
@@ -343,14 +662,12 @@ extern esp_err_t led_strip_fill_rgb(led_strip_handle_t handle, led_strip_color_c
         .b = b,
         .w = 0x00,
     };
-    if (handle->enable_w_channel)
-    {
-        color = convert_from_rgb_to_rgbw(color);
-    }
-    for (led_strip_pixel_index_t i = 0; i < handle->led_count; i++)
+    if (LED_STRIP_HAS_W_CHANNEL(handle))
     {
-        set_color_data(handle, i, color);
+        color = convert_from_rgb_to_rgbw(&handle->white, color);
     }
+    fill_color_data(handle, color);
+    led_strip_mark_pixels_changed(handle, handle->led_count);
     return ESP_OK;
 }
 
@@ -367,110 +684,354 @@ extern esp_err_t led_strip_fill_rgbw(led_strip_handle_t handle, led_strip_color_
         .b = b,
         .w = w,
     };
-    if (handle->enable_w_channel == false)
+    if (LED_STRIP_HAS_W_CHANNEL(handle) == false)
     {
         color = convert_from_rgbw_to_rgb(color);
     }
-    for (led_strip_pixel_index_t i = 0; i < handle->led_count; i++)
-    {
-        set_color_data(handle, i, color);
-    }
+    fill_color_data(handle, color);
+    led_strip_mark_pixels_changed(handle, handle->led_count);
     return ESP_OK;
 }
 
-// Private functions
-
-static esp_err_t find_empty_channel(rmt_channel_t *channel)
+extern esp_err_t led_strip_set_pixels(led_strip_handle_t handle, led_strip_pixel_index_t start, led_strip_pixel_index_t count, const led_strip_color_t *colors)
 {
-    if (channel == NULL)
+    if (handle == NULL || colors == NULL)
     {
         return ESP_ERR_INVALID_ARG;
     }
-    for (size_t i = 0; i < (size_t)RMT_CHANNEL_MAX; i++)
+    esp_err_t err = check_pixel_range(handle, start, count);
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+
+    if (handle->remap != NULL)
     {
-        if (rmt_channel_used[i] == false)
+        size_t end = 0;
+        for (led_strip_pixel_index_t i = 0; i < count; i++)
         {
-            *channel = (rmt_channel_t)i;
-            return ESP_OK;
+            const led_strip_pixel_index_t pixel = handle->remap[start + i];
+            set_color_data(handle, pixel, colors[i]);
+            end = pixel >= end ? (size_t)pixel + 1 : end;
         }
+        led_strip_mark_pixels_changed(handle, end);
+        return ESP_OK;
     }
-    return ESP_ERR_NOT_FOUND;
-}
 
-static void mark_channel_free(rmt_channel_t channel)
-{
-    if (channel != RMT_CHANNEL_MAX)
+    // Hoist everything that set_color_data looks up per pixel out of the loop.
+    const color_offsets_t offsets = LED_STRIP_COLOR_OFFSETS(handle);
+    led_strip_color_component_t *pixel = handle->pixel_colors + (LED_STRIP_PIXEL_STRIDE(handle) * start);
+    if (LED_STRIP_PIXEL_STRIDE(handle) == 4)
     {
-        rmt_channel_used[(int)channel] = false;
+        for (led_strip_pixel_index_t i = 0; i < count; i++, pixel += 4)
+        {
+            pixel[offsets.r] = colors[i].r;
+            pixel[offsets.g] = colors[i].g;
+            pixel[offsets.b] = colors[i].b;
+            pixel[offsets.w] = colors[i].w;
+        }
     }
-}
-
-static void mark_channel_used(rmt_channel_t channel)
-{
-    if (channel != RMT_CHANNEL_MAX)
+    else
     {
-        rmt_channel_used[(int)channel] = true;
+        for (led_strip_pixel_index_t i = 0; i < count; i++, pixel += 3)
+        {
+            pixel[offsets.r] = colors[i].r;
+            pixel[offsets.g] = colors[i].g;
+            pixel[offsets.b] = colors[i].b;
+        }
     }
+    led_strip_mark_pixels_changed(handle, start + count);
+    return ESP_OK;
 }
 
-static void IRAM_ATTR rmt_adapter(const void *src, rmt_item32_t *dest, size_t src_size, size_t wanted_num, size_t *translated_size, size_t *item_num)
+extern esp_err_t led_strip_set_pixels_rgb(led_strip_handle_t handle, led_strip_pixel_index_t start, led_strip_pixel_index_t count, const led_strip_color_component_t *rgb)
 {
-    *translated_size = 0;
-    *item_num = 0;
-    const uint8_t *raw_data = (const uint8_t *)src;
-    void *user_data = NULL;
-    if (rmt_translator_get_context(item_num, &user_data) != ESP_OK)
+    if (handle == NULL || rgb == NULL)
     {
-        return; // Just bail out and hope that the driver gets it when translated_size and item_num are zero.
+        return ESP_ERR_INVALID_ARG;
     }
-    if (user_data == NULL)
+    esp_err_t err = check_pixel_range(handle, start, count);
+    if (err != ESP_OK)
     {
-        return; // We need a userdata so we have a handle to get info from.
+        return err;
     }
 
-    led_strip_handle_t handle = (led_strip_handle_t)user_data;
-    if (wanted_num < 8)
+    const white_extraction_t white = handle->white;
+    if (handle->remap != NULL)
     {
-        // We need at least 8 samples because otherwise we can't convert a whole byte.
-        return;
+        size_t end = 0;
+        for (led_strip_pixel_index_t i = 0; i < count; i++, rgb += 3)
+        {
+            led_strip_color_t color = {
+                .r = rgb[0],
+                .g = rgb[1],
+                .b = rgb[2],
+                .w = 0x00,
+            };
+            if (LED_STRIP_HAS_W_CHANNEL(handle))
+            {
+                color = convert_from_rgb_to_rgbw(&white, color);
+            }
+            const led_strip_pixel_index_t pixel = handle->remap[start + i];
+            set_color_data(handle, pixel, color);
+            end = pixel >= end ? (size_t)pixel + 1 : end;
+        }
+        led_strip_mark_pixels_changed(handle, end);
+        return ESP_OK;
     }
 
-    size_t convertable_bytes = wanted_num / 8; // 1 bits per num (1 period on, 1 period off) and 8 bits per byte.
-    if (convertable_bytes > src_size)
+    const color_offsets_t offsets = LED_STRIP_COLOR_OFFSETS(handle);
+    led_strip_color_component_t *pixel = handle->pixel_colors + (LED_STRIP_PIXEL_STRIDE(handle) * start);
+    if (LED_STRIP_PIXEL_STRIDE(handle) == 4)
     {
-        convertable_bytes = src_size;
+        const bool extract_white = LED_STRIP_HAS_W_CHANNEL(handle);
+        for (led_strip_pixel_index_t i = 0; i < count; i++, pixel += 4, rgb += 3)
+        {
+            led_strip_color_t color = {
+                .r = rgb[0],
+                .g = rgb[1],
+                .b = rgb[2],
+                .w = 0x00,
+            };
+            if (extract_white)
+            {
+                color = convert_from_rgb_to_rgbw(&white, color);
+            }
+            pixel[offsets.r] = color.r;
+            pixel[offsets.g] = color.g;
+            pixel[offsets.b] = color.b;
+            pixel[offsets.w] = color.w;
+        }
     }
-
-    size_t rmt_item_offset = 0;
-    for (size_t i = 0; i < convertable_bytes; i++)
+    else
     {
-        translate_uint8_to_rmt_samples(dest + rmt_item_offset, raw_data[i], handle->led_timing);
-        rmt_item_offset += 8;
+        for (led_strip_pixel_index_t i = 0; i < count; i++, pixel += 3, rgb += 3)
+        {
+            pixel[offsets.r] = rgb[0];
+            pixel[offsets.g] = rgb[1];
+            pixel[offsets.b] = rgb[2];
+        }
     }
+    led_strip_mark_pixels_changed(handle, start + count);
+    return ESP_OK;
+}
 
-    *translated_size = convertable_bytes;
-    *item_num = rmt_item_offset;
+extern esp_err_t led_strip_attach_buffer(led_strip_handle_t handle, led_strip_color_component_t *buffer)
+{
+    if (handle == NULL || buffer == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    else if (handle->external_framebuffer == false)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    else if (handle->iram_safe && esp_ptr_internal(buffer) == false)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    // The driver keeps its own pointer to the buffer that is being transmitted, so the swap doesn't have to wait for it.
+    handle->pixel_colors = buffer;
+    led_strip_mark_pixels_changed(handle, handle->led_count);
+    return ESP_OK;
 }
 
-static void IRAM_ATTR translate_uint8_to_rmt_samples(rmt_item32_t *items, uint8_t data, led_strip_manual_timing_t timing)
+extern esp_err_t led_strip_bake_frame(led_strip_handle_t handle, uint8_t slot)
 {
-    for (int i = 0; i < 8; i++)
+    if (handle == NULL || slot >= handle->baked_frame_count)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    const size_t data_count = handle->led_count * CALC_COLOR_SIZE(handle);
+    if (handle->baked_frames[slot] == NULL)
     {
-        int b_index = 7 - i; // MSB first
-        if (BIT_SET(data, b_index))
+        const uint32_t caps = handle->baked_frames_in_spiram ? MALLOC_CAP_SPIRAM | MALLOC_CAP_32BIT : MALLOC_CAP_INTERNAL | MALLOC_CAP_32BIT;
+        handle->baked_frames[slot] = (uint32_t *)heap_caps_malloc(data_count * 8 * sizeof(uint32_t), caps);
+        if (handle->baked_frames[slot] == NULL)
         {
-            items[i].duration0 = timing.high_on;
-            items[i].duration1 = timing.high_off;
+            return ESP_ERR_NO_MEM;
         }
-        else
+    }
+    else if (handle->transmitting_baked_frame == slot)
+    {
+        esp_err_t err = ensure_flush_done(handle);
+        if (err != ESP_OK)
+        {
+            return err;
+        }
+    }
+
+    if (handle->levels_changed)
+    {
+        // The symbol table can't be rebuilt while the translator may be reading it.
+        esp_err_t err = ensure_flush_done(handle);
+        if (err == ESP_OK)
+        {
+            err = update_levels(handle);
+        }
+        if (err != ESP_OK)
+        {
+            return err;
+        }
+    }
+
+    const uint8_t *levels = led_strip_translator_levels(handle);
+    const size_t color_size = CALC_COLOR_SIZE(handle);
+    const led_strip_color_component_t *pixel = handle->pixel_colors;
+    uint32_t *symbols = handle->baked_frames[slot];
+    for (size_t i = 0; i < handle->led_count; i++, pixel += LED_STRIP_PIXEL_STRIDE(handle))
+    {
+        for (size_t j = 0; j < color_size; j++, symbols += 8)
+        {
+            const uint8_t raw = pixel[handle->swizzle[j]];
+            const uint8_t value = levels != NULL ? levels[raw] : raw;
+            led_strip_translate_byte(symbols, value, led_strip_symbol_lut(handle));
+        }
+    }
+    handle->live_baked_frame = slot;
+    return ESP_OK;
+}
+
+extern esp_err_t led_strip_flush_baked(led_strip_handle_t handle, uint8_t slot)
+{
+    if (handle == NULL || slot >= handle->baked_frame_count)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return transmit_baked_frame(handle, slot, true);
+}
+
+extern esp_err_t led_strip_start_flush_baked(led_strip_handle_t handle, uint8_t slot)
+{
+    if (handle == NULL || slot >= handle->baked_frame_count)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return transmit_baked_frame(handle, slot, false);
+}
+
+extern esp_err_t led_strip_discard_baked_frame(led_strip_handle_t handle, uint8_t slot)
+{
+    if (handle == NULL || slot >= handle->baked_frame_count)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (handle->transmitting_baked_frame == slot)
+    {
+        esp_err_t err = ensure_flush_done(handle);
+        if (err != ESP_OK)
+        {
+            return err == ESP_ERR_NOT_FINISHED ? ESP_ERR_INVALID_STATE : err;
+        }
+    }
+    if (handle->live_baked_frame == slot)
+    {
+        handle->live_baked_frame = NO_BAKED_FRAME;
+    }
+    free(handle->baked_frames[slot]);
+    handle->baked_frames[slot] = NULL;
+    return ESP_OK;
+}
+
+// Shared functions
+
+extern void IRAM_ATTR led_strip_on_tx_done_from_isr(led_strip_handle_t handle, BaseType_t *higher_priority_task_woken)
+{
+    if (handle->latch_time_us != 0)
+    {
+        handle->tx_done_time = esp_timer_get_time();
+    }
+    stats_frame_done(handle);
+    if (handle->group_events != NULL)
+    {
+        xEventGroupSetBitsFromISR(handle->group_events, handle->group_bit, higher_priority_task_woken);
+    }
+    if (handle->notify_task != NULL)
+    {
+        xTaskNotifyFromISR(handle->notify_task, handle->notify_bits, eSetBits, higher_priority_task_woken);
+    }
+    if (handle->flush_done_callback != NULL && handle->flush_done_callback(handle, handle->flush_done_user_ctx))
+    {
+        *higher_priority_task_woken = pdTRUE;
+    }
+}
+
+extern esp_err_t led_strip_run_on_core(BaseType_t core_id, void (*function)(void *arg), void *arg)
+{
+#if !CONFIG_FREERTOS_UNICORE
+    if (core_id != tskNO_AFFINITY && core_id != xPortGetCoreID())
+    {
+        return esp_ipc_call_blocking((uint32_t)core_id, function, arg);
+    }
+#endif
+    function(arg);
+    return ESP_OK;
+}
+
+extern esp_err_t led_strip_load_frame(led_strip_handle_t handle, led_strip_color_component_t *frame)
+{
+    if (handle->external_framebuffer)
+    {
+        return led_strip_attach_buffer(handle, frame);
+    }
+    else if (handle->front_pixel_colors == NULL)
+    {
+        esp_err_t err = ensure_flush_done(handle);
+        if (err != ESP_OK)
+        {
+            return err;
+        }
+    }
+    memcpy(handle->pixel_colors, frame, handle->led_count * LED_STRIP_PIXEL_STRIDE(handle));
+    led_strip_mark_pixels_changed(handle, handle->led_count);
+    return ESP_OK;
+}
+
+extern void led_strip_mark_pixels_changed(led_strip_handle_t handle, size_t end)
+{
+    handle->live_baked_frame = NO_BAKED_FRAME;
+    if (end > handle->dirty_end)
+    {
+        handle->dirty_end = (led_strip_pixel_index_t)end;
+    }
+}
+
+extern led_strip_color_t led_strip_map_color(const led_strip_t *handle, led_strip_color_t color)
+{
+    return LED_STRIP_HAS_W_CHANNEL(handle) ? color : convert_from_rgbw_to_rgb(color);
+}
+
+extern led_strip_manual_timing_t led_strip_map_timing(led_strip_timing_config_t config)
+{
+    return map_timing(config);
+}
+
+// Private functions
+
+#if !LED_STRIP_CONST_SYMBOL_LUT
+static void build_symbol_lut(uint32_t *symbol_lut, const led_strip_manual_timing_t *timing, const uint8_t *levels)
+{
+    // Only the full byte table can have the levels folded in, a nibble doesn't know the rest of its byte.
+#if LED_STRIP_FIXED_TIMING
+    (void)timing;
+    const uint32_t high = FIXED_HIGH_SYMBOL;
+    const uint32_t low = FIXED_LOW_SYMBOL;
+#else
+    const uint32_t high = LED_STRIP_SYMBOL(1, timing->high_on, 0, timing->high_off);
+    const uint32_t low = LED_STRIP_SYMBOL(1, timing->low_on, 0, timing->low_off);
+#endif
+    for (int value = 0; value < SYMBOL_LUT_ENTRIES; value++)
+    {
+        uint32_t *symbols = symbol_lut + (value * SYMBOL_LUT_BITS);
+        const int level = (SYMBOL_LUT_BITS == 8 && levels != NULL) ? levels[value] : value;
+        for (int i = 0; i < SYMBOL_LUT_BITS; i++)
         {
-            items[i].duration0 = timing.low_on;
-            items[i].duration1 = timing.low_off;
+            int b_index = (SYMBOL_LUT_BITS - 1) - i; // MSB first
+            symbols[i] = BIT_SET(level, b_index) ? high : low;
         }
-        items[i].level0 = 1;
-        items[i].level1 = 0;
     }
 }
+#endif
 
 static led_strip_handle_t alloc_led_strip(const led_strip_config_t *config)
 {
@@ -479,24 +1040,116 @@ static led_strip_handle_t alloc_led_strip(const led_strip_config_t *config)
     {
         return NULL;
     }
-    const size_t color_cnt = config->led_count * CALC_COLOR_SIZE(config);
-    handle->pixel_colors = (led_strip_color_component_t *)heap_caps_calloc(color_cnt, sizeof(led_strip_color_component_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA);
+    // All members start out zeroed, so dealloc_led_strip can clean up whatever was allocated so far.
+#if CONFIG_LED_STRIP_ENABLE_STATS
+    portMUX_INITIALIZE(&handle->stats_lock);
+#endif
+    handle->framebuffer_in_spiram = config->memory_policy != LED_STRIP_MEMORY_INTERNAL;
+    handle->baked_frames_in_spiram = config->memory_policy == LED_STRIP_MEMORY_SPIRAM_ALL;
+    handle->pixel_stride = map_pixel_stride(config);
+    const size_t color_cnt = config->led_count * LED_STRIP_PIXEL_STRIDE(handle);
+    handle->external_framebuffer = config->external_buffer != NULL;
+    if (handle->external_framebuffer)
+    {
+        handle->pixel_colors = config->external_buffer;
+    }
+    else
+    {
+        handle->pixel_colors = (led_strip_color_component_t *)heap_caps_calloc(color_cnt, sizeof(led_strip_color_component_t), framebuffer_caps(handle));
+    }
     if (handle->pixel_colors == NULL)
     {
-        free(handle);
+        dealloc_led_strip(handle);
         return NULL;
     }
+    if (config->enable_double_buffer)
+    {
+        handle->front_pixel_colors = (led_strip_color_component_t *)heap_caps_calloc(color_cnt, sizeof(led_strip_color_component_t), framebuffer_caps(handle));
+        if (handle->front_pixel_colors == NULL)
+        {
+            dealloc_led_strip(handle);
+            return NULL;
+        }
+    }
+#if !LED_STRIP_CONST_SYMBOL_LUT
+    handle->symbol_lut = (uint32_t *)heap_caps_calloc(SYMBOL_LUT_SIZE, sizeof(uint32_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_32BIT);
+    if (handle->symbol_lut == NULL)
+    {
+        dealloc_led_strip(handle);
+        return NULL;
+    }
+#endif
+    if (config->enable_dithering)
+    {
+        handle->dither_pixels = (uint16_t *)calloc(color_cnt, sizeof(uint16_t));
+        handle->dither_error = (uint8_t *)calloc(color_cnt, sizeof(uint8_t));
+        if (handle->dither_pixels == NULL || handle->dither_error == NULL)
+        {
+            dealloc_led_strip(handle);
+            return NULL;
+        }
+    }
+    if (config->baked_frame_count > 0)
+    {
+        handle->baked_frames = (uint32_t **)calloc(config->baked_frame_count, sizeof(uint32_t *));
+        if (handle->baked_frames == NULL)
+        {
+            dealloc_led_strip(handle);
+            return NULL;
+        }
+        handle->baked_frame_count = config->baked_frame_count;
+    }
     return handle;
 }
 
+static esp_err_t alloc_remap(led_strip_handle_t handle)
+{
+    if (handle->remap == NULL)
+    {
+        handle->remap = (led_strip_pixel_index_t *)malloc(handle->led_count * sizeof(led_strip_pixel_index_t));
+        if (handle->remap == NULL)
+        {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    return ESP_OK;
+}
+
+static uint32_t framebuffer_caps(led_strip_handle_t handle)
+{
+    return handle->framebuffer_in_spiram ? MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT : MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA;
+}
+
 static void dealloc_led_strip(led_strip_handle_t handle)
 {
     if (handle != NULL)
     {
-        if (handle->pixel_colors != NULL)
+        if (handle->pixel_colors != NULL && handle->external_framebuffer == false)
         {
             free(handle->pixel_colors);
         }
+        if (handle->front_pixel_colors != NULL)
+        {
+            free(handle->front_pixel_colors);
+        }
+        if (handle->symbol_lut != NULL)
+        {
+            free(handle->symbol_lut);
+        }
+        free(handle->remap);
+        free(handle->dither_pixels);
+        free(handle->dither_error);
+        free(handle->gamma_table);
+        free(handle->level_lut);
+        free(handle->stage_buffer);
+        if (handle->baked_frames != NULL)
+        {
+            for (uint8_t i = 0; i < handle->baked_frame_count; i++)
+            {
+                free(handle->baked_frames[i]);
+            }
+            free(handle->baked_frames);
+        }
         free(handle);
     }
 }
@@ -511,18 +1164,18 @@ static led_strip_manual_timing_t map_timing(led_strip_timing_config_t config)
     {
         led_strip_manual_timing_t timing[] = {
             [LED_STRIP_TYPE_SK6822] = {
-                .low_on = LED_STRIP_NS_AS_TICKS(300),
-                .low_off = LED_STRIP_NS_AS_TICKS(900),
-                .high_on = LED_STRIP_NS_AS_TICKS(600),
-                .high_off = LED_STRIP_NS_AS_TICKS(600),
-                .reset_time = LED_STRIP_US_AS_TICKS(80),
+                .low_on = SK6822_LOW_ON,
+                .low_off = SK6822_LOW_OFF,
+                .high_on = SK6822_HIGH_ON,
+                .high_off = SK6822_HIGH_OFF,
+                .reset_time = SK6822_RESET_TIME,
             },
             [LED_STRIP_TYPE_WS281x] = {
-                .low_on = LED_STRIP_NS_AS_TICKS(350),
-                .low_off = LED_STRIP_NS_AS_TICKS(900),
-                .high_on = LED_STRIP_NS_AS_TICKS(900),
-                .high_off = LED_STRIP_NS_AS_TICKS(350),
-                .reset_time = LED_STRIP_US_AS_TICKS(50),
+                .low_on = WS281X_LOW_ON,
+                .low_off = WS281X_LOW_OFF,
+                .high_on = WS281X_HIGH_ON,
+                .high_off = WS281X_HIGH_OFF,
+                .reset_time = WS281X_RESET_TIME,
             },
         };
 
@@ -549,7 +1202,7 @@ static led_strip_color_t convert_from_rgbw_to_rgb(led_strip_color_t color)
     return col;
 }
 
-static led_strip_color_t convert_from_rgb_to_rgbw(led_strip_color_t color)
+static led_strip_color_t convert_from_rgb_to_rgbw(const white_extraction_t *white, led_strip_color_t color)
 {
     led_strip_color_t col = {
         .r = color.r,
@@ -557,38 +1210,457 @@ static led_strip_color_t convert_from_rgb_to_rgbw(led_strip_color_t color)
         .b = color.b,
         .w = 0x00,
     };
+    if (white->enabled == false)
+    {
+        return col;
+    }
+    // The white level is limited by the component that runs out first relative to the color of the W LED.
+    const uint32_t r_limit = ((color.r * white->scale[0] + 0x8000) >> 16) + white->bias[0];
+    const uint32_t g_limit = ((color.g * white->scale[1] + 0x8000) >> 16) + white->bias[1];
+    const uint32_t b_limit = ((color.b * white->scale[2] + 0x8000) >> 16) + white->bias[2];
+    uint32_t w = r_limit < g_limit ? r_limit : g_limit;
+    w = w < b_limit ? w : b_limit;
+    w = w < 255 ? w : 255;
+
+    // Take out what the W LED now emits.
+    const uint32_t r_used = DIV_255(w * white->point[0]);
+    const uint32_t g_used = DIV_255(w * white->point[1]);
+    const uint32_t b_used = DIV_255(w * white->point[2]);
+    col.r = (led_strip_color_component_t)(color.r - (r_used < color.r ? r_used : color.r));
+    col.g = (led_strip_color_component_t)(color.g - (g_used < color.g ? g_used : color.g));
+    col.b = (led_strip_color_component_t)(color.b - (b_used < color.b ? b_used : color.b));
+    col.w = (led_strip_color_component_t)w;
     return col;
 }
 
-static void set_color_data(led_strip_handle_t handle, led_strip_pixel_index_t index, led_strip_color_t color)
+static white_extraction_t map_white_point(led_strip_color_t white_point)
 {
-    size_t offset = CALC_COLOR_SIZE(handle) * index;
-    size_t r_offset = offset;
-    size_t g_offset = offset;
-    size_t b_offset = offset;
-    size_t w_offset = offset;
+    const uint8_t point[3] = {white_point.r, white_point.g, white_point.b};
+    white_extraction_t white;
+    white.enabled = false;
+    for (int i = 0; i < 3; i++)
+    {
+        white.point[i] = point[i];
+        if (point[i] == 0)
+        {
+            // The W LED doesn't emit this component, so the component never limits the white level.
+            white.scale[i] = 0;
+            white.bias[i] = 255;
+        }
+        else
+        {
+            white.scale[i] = ((255UL << 16) + (point[i] / 2)) / point[i];
+            white.bias[i] = 0;
+            white.enabled = true;
+        }
+    }
+    return white;
+}
+
+static color_offsets_t map_color_offsets(led_strip_color_order_t color_order)
+{
+    color_offsets_t offsets;
     // Weird thing in RMT requires 2nd and third bytes switched.
-    switch (handle->color_order)
+    switch (color_order)
     {
     case LED_STRIP_COLOR_ORDER_GRBW:
-        g_offset = offset;
-        r_offset = offset + 2;
-        b_offset = offset + 1;
-        w_offset = offset + 3;
+        offsets.g = 0;
+        offsets.r = 2;
+        offsets.b = 1;
+        offsets.w = 3;
         break;
     case LED_STRIP_COLOR_ORDER_RGBW:
     default:
-        r_offset = offset;
-        g_offset = offset + 2;
-        b_offset = offset + 1;
-        w_offset = offset + 3;
+        offsets.r = 0;
+        offsets.g = 2;
+        offsets.b = 1;
+        offsets.w = 3;
         break;
     }
-    if (handle->enable_w_channel)
+    return offsets;
+}
+
+static uint8_t map_pixel_stride(const led_strip_config_t *config)
+{
+    switch (config->pixel_format)
+    {
+    case LED_STRIP_PIXEL_FORMAT_RGB24:
+        return 3;
+    case LED_STRIP_PIXEL_FORMAT_RGBA32:
+        return 4;
+    case LED_STRIP_PIXEL_FORMAT_WIRE:
+    default:
+        return CALC_COLOR_SIZE(config);
+    }
+}
+
+static void map_swizzle(led_strip_handle_t handle)
+{
+    // The sent byte at the wire offset of a component is read from the offset of that component in pixel_colors.
+    const color_offsets_t wire = map_color_offsets(handle->color_order);
+    const color_offsets_t memory = LED_STRIP_COLOR_OFFSETS(handle);
+    handle->swizzle[wire.r] = memory.r;
+    handle->swizzle[wire.g] = memory.g;
+    handle->swizzle[wire.b] = memory.b;
+    handle->swizzle[wire.w] = memory.w;
+    handle->swizzled = LED_STRIP_PIXEL_STRIDE(handle) != CALC_COLOR_SIZE(handle);
+    for (int i = 0; i < CALC_COLOR_SIZE(handle); i++)
+    {
+        handle->swizzled = handle->swizzled || handle->swizzle[i] != i;
+    }
+}
+
+static void set_color_data(led_strip_handle_t handle, led_strip_pixel_index_t index, led_strip_color_t color)
+{
+    led_strip_color_component_t *pixel = handle->pixel_colors + (LED_STRIP_PIXEL_STRIDE(handle) * index);
+    if (LED_STRIP_PIXEL_STRIDE(handle) == 4)
+    {
+        pixel[LED_STRIP_COLOR_OFFSETS(handle).w] = color.w;
+    }
+    pixel[LED_STRIP_COLOR_OFFSETS(handle).r] = color.r;
+    pixel[LED_STRIP_COLOR_OFFSETS(handle).g] = color.g;
+    pixel[LED_STRIP_COLOR_OFFSETS(handle).b] = color.b;
+}
+
+static void fill_color_data(led_strip_handle_t handle, led_strip_color_t color)
+{
+    // The buffer is one repeating pattern: a 4 byte word per RGBW pixel, or 3 words per 4 RGB pixels.
+    const size_t color_size = LED_STRIP_PIXEL_STRIDE(handle);
+    const size_t pattern_words = color_size == 4 ? 1 : 3;
+    const size_t pattern_size = pattern_words * sizeof(uint32_t);
+    led_strip_color_component_t pattern[3 * sizeof(uint32_t)];
+    for (size_t pixel = 0; pixel < pattern_size; pixel += color_size)
+    {
+        if (color_size == 4)
+        {
+            pattern[pixel + LED_STRIP_COLOR_OFFSETS(handle).w] = color.w;
+        }
+        pattern[pixel + LED_STRIP_COLOR_OFFSETS(handle).r] = color.r;
+        pattern[pixel + LED_STRIP_COLOR_OFFSETS(handle).g] = color.g;
+        pattern[pixel + LED_STRIP_COLOR_OFFSETS(handle).b] = color.b;
+    }
+
+    // The pixel buffer can be an external buffer or an output slot without any alignment, the constant size memcpy
+    // still becomes word stores where the target allows them.
+    const size_t data_count = handle->led_count * color_size;
+    const size_t filled = (data_count / pattern_size) * pattern_size;
+    led_strip_color_component_t *pixels = handle->pixel_colors;
+    if (pattern_words == 1)
+    {
+        for (size_t offset = 0; offset < filled; offset += sizeof(uint32_t))
+        {
+            memcpy(pixels + offset, pattern, sizeof(uint32_t));
+        }
+    }
+    else
+    {
+        for (size_t offset = 0; offset < filled; offset += 3 * sizeof(uint32_t))
+        {
+            memcpy(pixels + offset, pattern, 3 * sizeof(uint32_t));
+        }
+    }
+    memcpy(pixels + filled, pattern, data_count - filled);
+}
+
+static esp_err_t check_pixel_range(led_strip_handle_t handle, led_strip_pixel_index_t start, led_strip_pixel_index_t count)
+{
+    if (start >= handle->led_count || count > handle->led_count - start)
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    return ESP_OK;
+}
+
+static size_t partial_flush_pixel_count(led_strip_handle_t handle)
+{
+    // Always send at least one pixel, so the flush still ends in a TX done event for the callbacks and groups.
+    return handle->dirty_end == 0 ? 1 : handle->dirty_end;
+}
+
+static esp_err_t update_levels(led_strip_handle_t handle)
+{
+    if (handle->levels_changed == false)
+    {
+        return ESP_OK;
+    }
+    // The dithering stage applies the levels to the 16 bit values, the sent frame is already leveled then.
+    const bool neutral = (handle->brightness == 255 && handle->gamma_table == NULL) || handle->dither_pixels != NULL;
+    if (neutral == false)
+    {
+        if (handle->level_lut == NULL)
+        {
+            handle->level_lut = (uint8_t *)heap_caps_malloc(LED_STRIP_GAMMA_TABLE_SIZE, MALLOC_CAP_INTERNAL);
+            if (handle->level_lut == NULL)
+            {
+                return ESP_ERR_NO_MEM;
+            }
+        }
+        for (int i = 0; i < LED_STRIP_GAMMA_TABLE_SIZE; i++)
+        {
+            const uint32_t level = handle->gamma_table != NULL ? handle->gamma_table[i] : (uint32_t)i;
+            handle->level_lut[i] = (uint8_t)(((level * handle->brightness) + 127) / 255);
+        }
+    }
+    handle->apply_levels = !neutral;
+#if CONFIG_LED_STRIP_SYMBOL_LUT_FULL
+    build_symbol_lut(handle->symbol_lut, &handle->led_timing, handle->apply_levels ? handle->level_lut : NULL);
+#endif
+    handle->levels_changed = false;
+    return ESP_OK;
+}
+
+static esp_err_t stage_frame(led_strip_handle_t handle, const led_strip_color_component_t *pixels, size_t pixel_count)
+{
+    if (handle->stage_buffer == NULL)
+    {
+        const size_t color_cnt = handle->led_count * CALC_COLOR_SIZE(handle);
+        handle->stage_buffer = (led_strip_color_component_t *)heap_caps_malloc(color_cnt, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        if (handle->stage_buffer == NULL)
+        {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    const uint8_t *levels = handle->apply_levels ? handle->level_lut : NULL;
+    led_strip_color_component_t *staged = handle->stage_buffer;
+    if (handle->swizzled == false && levels == NULL)
+    {
+        // A PSRAM frame that only has to be moved to internal RAM.
+        memcpy(staged, pixels, pixel_count * CALC_COLOR_SIZE(handle));
+        return ESP_OK;
+    }
+    if (handle->swizzled == false)
+    {
+        // Only the levels have to be applied, the pixels are in wire order already.
+        const size_t data_count = pixel_count * CALC_COLOR_SIZE(handle);
+        for (size_t i = 0; i < data_count; i++)
+        {
+            staged[i] = levels[pixels[i]];
+        }
+        return ESP_OK;
+    }
+    const size_t color_size = CALC_COLOR_SIZE(handle);
+    for (size_t i = 0; i < pixel_count; i++, pixels += LED_STRIP_PIXEL_STRIDE(handle), staged += color_size)
+    {
+        for (size_t j = 0; j < color_size; j++)
+        {
+            const uint8_t raw = pixels[handle->swizzle[j]];
+            staged[j] = levels != NULL ? levels[raw] : raw;
+        }
+    }
+    return ESP_OK;
+}
+
+static esp_err_t poll_flush_done(led_strip_handle_t handle, bool *done)
+{
+    if (handle->has_flushed == false)
+    {
+        *done = true;
+        return ESP_OK;
+    }
+    esp_err_t err = handle->backend->wait_tx_done(handle, 0);
+    LED_STRIP_HOT_PATH_ERROR_CHECK(err);
+    *done = (err == ESP_OK);
+    if (err != ESP_OK && err != ESP_ERR_TIMEOUT)
+    {
+        return err;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t ensure_flush_done(led_strip_handle_t handle)
+{
+    // Polled before every transmission, so it skips the argument checks of led_strip_flush_done.
+    bool ready = false;
+    esp_err_t err = poll_flush_done(handle, &ready);
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+    if (ready == false)
+    {
+        return ESP_ERR_NOT_FINISHED;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t transmit_frame(led_strip_handle_t handle, bool wait_tx_done)
+{
+    if (handle->dither_pixels != NULL)
+    {
+        // Every flush sends a new sub-frame, so a baked frame is never up to date.
+        handle->live_baked_frame = NO_BAKED_FRAME;
+    }
+    else if (handle->external_framebuffer)
+    {
+        // The caller writes to the buffer directly, so neither a baked frame nor the dirty range can be trusted.
+        led_strip_mark_pixels_changed(handle, handle->led_count);
+    }
+    if (handle->live_baked_frame != NO_BAKED_FRAME)
+    {
+        // Nothing changed since the frame was baked, so skip the translation.
+        return transmit_baked_frame(handle, handle->live_baked_frame, wait_tx_done);
+    }
+    esp_err_t err = ensure_flush_done(handle);
+    if (err != ESP_OK)
+    {
+        if (err == ESP_ERR_NOT_FINISHED)
+        {
+            stats_frame_dropped(handle);
+        }
+        return err;
+    }
+
+    err = update_levels(handle);
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+    if (handle->dither_pixels != NULL)
+    {
+        led_strip_dither_frame(handle);
+        led_strip_mark_pixels_changed(handle, handle->led_count);
+    }
+
+    led_strip_color_component_t *frame = handle->pixel_colors;
+    const size_t pixel_count = handle->enable_partial_flush ? partial_flush_pixel_count(handle) : handle->led_count;
+    const size_t data_count = pixel_count * LED_STRIP_PIXEL_STRIDE(handle);
+    const led_strip_color_component_t *data = frame;
+    size_t size = data_count;
+    // A backend that doesn't map the pixels reads them from its ISR, which can't read PSRAM while the flash cache is disabled.
+    if ((handle->apply_levels || handle->swizzled || handle->framebuffer_in_spiram) && handle->backend->maps_pixels == false)
+    {
+        err = stage_frame(handle, frame, pixel_count);
+        if (err != ESP_OK)
+        {
+            return err;
+        }
+        data = handle->stage_buffer;
+        size = pixel_count * CALC_COLOR_SIZE(handle);
+    }
+    wait_for_latch(handle);
+    stats_frame_started(handle);
+    err = handle->backend->transmit(handle, data, size, wait_tx_done);
+    LED_STRIP_HOT_PATH_ERROR_CHECK(err);
+    if (err != ESP_OK)
+    {
+        stats_frame_failed(handle, err);
+        return err;
+    }
+    if (handle->front_pixel_colors != NULL)
+    {
+        // The previous front buffer is no longer read by the RMT driver, so it becomes the new back buffer.
+        handle->pixel_colors = handle->front_pixel_colors;
+        handle->front_pixel_colors = frame;
+        if (handle->enable_partial_flush)
+        {
+            // Bring the new back buffer up to date with what the LEDs will show, otherwise the dirty range is meaningless for it.
+            memcpy(handle->pixel_colors, frame, data_count);
+        }
+    }
+    handle->dirty_end = 0;
+    handle->transmitting_baked_frame = NO_BAKED_FRAME;
+    handle->has_flushed = true;
+    return ESP_OK;
+}
+
+static esp_err_t transmit_baked_frame(led_strip_handle_t handle, int slot, bool wait_tx_done)
+{
+    if (handle->baked_frames[slot] == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    esp_err_t err = ensure_flush_done(handle);
+    if (err != ESP_OK)
+    {
+        if (err == ESP_ERR_NOT_FINISHED)
+        {
+            stats_frame_dropped(handle);
+        }
+        return err;
+    }
+
+    const size_t symbol_count = handle->led_count * CALC_COLOR_SIZE(handle) * 8;
+    wait_for_latch(handle);
+    stats_frame_started(handle);
+    err = handle->backend->transmit_symbols(handle, handle->baked_frames[slot], symbol_count, wait_tx_done);
+    LED_STRIP_HOT_PATH_ERROR_CHECK(err);
+    if (err != ESP_OK)
+    {
+        stats_frame_failed(handle, err);
+        return err;
+    }
+    // Only a frame that was baked from the current pixel buffer leaves the LEDs showing that buffer.
+    handle->dirty_end = (slot == handle->live_baked_frame) ? 0 : handle->led_count;
+    handle->transmitting_baked_frame = slot;
+    handle->has_flushed = true;
+    return ESP_OK;
+}
+
+static void wait_for_latch(led_strip_handle_t handle)
+{
+    if (handle->latch_time_us == 0 || handle->has_flushed == false)
+    {
+        return;
+    }
+    // Only called once the previous transmission is done, so the ISR doesn't write tx_done_time now.
+    const int64_t elapsed = esp_timer_get_time() - handle->tx_done_time;
+    if (elapsed < handle->latch_time_us)
+    {
+        // At most a few hundred microseconds, too short to give the CPU away.
+        esp_rom_delay_us((uint32_t)(handle->latch_time_us - elapsed));
+    }
+}
+
+static void stats_frame_started(led_strip_handle_t handle)
+{
+#if CONFIG_LED_STRIP_ENABLE_STATS
+    // The legacy driver translates the first part of the frame before the transmit call returns, so this comes first.
+    portENTER_CRITICAL(&handle->stats_lock);
+    handle->stats.frames_started++;
+    handle->frame_translator_calls = 0;
+    handle->frame_translator_cycles = 0;
+    handle->flush_start_time = esp_timer_get_time();
+    portEXIT_CRITICAL(&handle->stats_lock);
+#endif
+}
+
+static void stats_frame_failed(led_strip_handle_t handle, esp_err_t err)
+{
+#if CONFIG_LED_STRIP_ENABLE_STATS
+    // The backend didn't start the frame, so it never completes either. A busy backend is a dropped frame like a busy led strip.
+    portENTER_CRITICAL(&handle->stats_lock);
+    handle->stats.frames_started--;
+    if (err == ESP_ERR_NOT_FINISHED)
+    {
+        handle->stats.frames_dropped++;
+    }
+    portEXIT_CRITICAL(&handle->stats_lock);
+#endif
+}
+
+static void stats_frame_dropped(led_strip_handle_t handle)
+{
+#if CONFIG_LED_STRIP_ENABLE_STATS
+    portENTER_CRITICAL(&handle->stats_lock);
+    handle->stats.frames_dropped++;
+    portEXIT_CRITICAL(&handle->stats_lock);
+#endif
+}
+
+static void IRAM_ATTR stats_frame_done(led_strip_handle_t handle)
+{
+#if CONFIG_LED_STRIP_ENABLE_STATS
+    const int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL_ISR(&handle->stats_lock);
+    const uint32_t frame_time = (uint32_t)(now - handle->flush_start_time);
+    handle->stats.frames_completed++;
+    handle->stats.last_frame_translator_calls = handle->frame_translator_calls;
+    handle->stats.last_frame_translator_cycles = handle->frame_translator_cycles;
+    handle->stats.last_frame_time_us = frame_time;
+    if (frame_time > handle->stats.max_frame_time_us)
     {
-        handle->pixel_colors[w_offset] = color.w;
+        handle->stats.max_frame_time_us = frame_time;
     }
-    handle->pixel_colors[r_offset] = color.r;
-    handle->pixel_colors[g_offset] = color.g;
-    handle->pixel_colors[b_offset] = color.b;
+    portEXIT_CRITICAL_ISR(&handle->stats_lock);
+#endif
 }
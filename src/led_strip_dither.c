@@ -0,0 +1,270 @@
+/**
+ * @file led_strip_dither.c
+ * @author Giel Willemsen
+ * @brief Temporal dithering of a 16 bit framebuffer and the refresh task.
+ * @version 0.1 2022-09-07 Initial version
+ * @date 2022-09-07
+ *
+ * @copyright
+ * MIT License
+ *
+ * Copyright (c) 2022 Giel Willemsen
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <esp_log.h>
+#include <freertos/task.h>
+#include "led_strip_private.h"
+
+static void set_color16_data(led_strip_handle_t handle, led_strip_pixel_index_t index, led_strip_color16_t color);
+static led_strip_color16_t convert_from_rgb16_to_rgbw16(const white_extraction_t *white, led_strip_color16_t color);
+static uint32_t apply_levels16(const uint8_t *gamma_table, uint8_t brightness, uint16_t value);
+static void refresh_task(void *arg);
+
+extern esp_err_t led_strip_set_pixel_rgb16(led_strip_handle_t handle, led_strip_pixel_index_t index, uint16_t r, uint16_t g, uint16_t b)
+{
+    if (handle == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    led_strip_color16_t color = {
+        .r = r,
+        .g = g,
+        .b = b,
+        .w = 0x0000,
+    };
+    if (LED_STRIP_HAS_W_CHANNEL(handle))
+    {
+        color = convert_from_rgb16_to_rgbw16(&handle->white, color);
+    }
+    return led_strip_set_pixel_rgbw16(handle, index, color.r, color.g, color.b, color.w);
+}
+
+extern esp_err_t led_strip_set_pixel_rgbw16(led_strip_handle_t handle, led_strip_pixel_index_t index, uint16_t r, uint16_t g, uint16_t b, uint16_t w)
+{
+    if (handle == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    else if (handle->dither_pixels == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    else if (index >= handle->led_count)
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    led_strip_color16_t color = {
+        .r = r,
+        .g = g,
+        .b = b,
+        .w = w,
+    };
+    set_color16_data(handle, index, color);
+    return ESP_OK;
+}
+
+extern esp_err_t led_strip_fill16(led_strip_handle_t handle, led_strip_color16_t color)
+{
+    if (handle == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    else if (handle->dither_pixels == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    for (led_strip_pixel_index_t i = 0; i < handle->led_count; i++)
+    {
+        set_color16_data(handle, i, color);
+    }
+    return ESP_OK;
+}
+
+extern esp_err_t led_strip_set_pixels16(led_strip_handle_t handle, led_strip_pixel_index_t start, led_strip_pixel_index_t count, const led_strip_color16_t *colors)
+{
+    if (handle == NULL || colors == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    else if (handle->dither_pixels == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    else if (start >= handle->led_count || count > handle->led_count - start)
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    for (led_strip_pixel_index_t i = 0; i < count; i++)
+    {
+        set_color16_data(handle, start + i, colors[i]);
+    }
+    return ESP_OK;
+}
+
+extern esp_err_t led_strip_start_refresh(led_strip_handle_t handle, UBaseType_t priority, BaseType_t core_id)
+{
+    if (handle == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    else if (handle->refresh_task != NULL || handle->scheduler != NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    handle->refresh_stopped = xSemaphoreCreateBinary();
+    if (handle->refresh_stopped == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    handle->refresh_running = true;
+    if (xTaskCreatePinnedToCore(refresh_task, "led_strip_refresh", CONFIG_LED_STRIP_REFRESH_TASK_STACK_SIZE, handle, priority, &handle->refresh_task, core_id) != pdPASS)
+    {
+        handle->refresh_running = false;
+        handle->refresh_task = NULL;
+        vSemaphoreDelete(handle->refresh_stopped);
+        handle->refresh_stopped = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+extern esp_err_t led_strip_stop_refresh(led_strip_handle_t handle)
+{
+    if (handle == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    else if (handle->refresh_task == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    handle->refresh_running = false;
+    xSemaphoreTake(handle->refresh_stopped, portMAX_DELAY);
+    vSemaphoreDelete(handle->refresh_stopped);
+    handle->refresh_stopped = NULL;
+    handle->refresh_task = NULL;
+    return ESP_OK;
+}
+
+// Shared functions
+
+extern void led_strip_dither_frame(led_strip_handle_t handle)
+{
+    const size_t data_count = handle->led_count * LED_STRIP_PIXEL_STRIDE(handle);
+    const uint16_t *source = handle->dither_pixels;
+    uint8_t *error = handle->dither_error;
+    led_strip_color_component_t *frame = handle->pixel_colors;
+    const uint8_t *gamma_table = handle->gamma_table;
+    const uint8_t brightness = handle->brightness;
+    const bool neutral = gamma_table == NULL && brightness == 255;
+    for (size_t i = 0; i < data_count; i++)
+    {
+        // Send the upper 8 bits and carry the lower 8 bits over to the next sub-frame, so the average over time is the 16 bit value.
+        uint32_t value = neutral ? source[i] : apply_levels16(gamma_table, brightness, source[i]);
+        value += error[i];
+        if (value > 0xFFFF)
+        {
+            frame[i] = 0xFF;
+            error[i] = 0x00;
+        }
+        else
+        {
+            frame[i] = (led_strip_color_component_t)(value >> 8);
+            error[i] = (uint8_t)(value & 0xFF);
+        }
+    }
+}
+
+// Private functions
+
+static void set_color16_data(led_strip_handle_t handle, led_strip_pixel_index_t index, led_strip_color16_t color)
+{
+    uint16_t *pixel = handle->dither_pixels + (LED_STRIP_PIXEL_STRIDE(handle) * led_strip_physical_index(handle, index));
+    if (LED_STRIP_PIXEL_STRIDE(handle) == 4)
+    {
+        pixel[LED_STRIP_COLOR_OFFSETS(handle).w] = color.w;
+    }
+    pixel[LED_STRIP_COLOR_OFFSETS(handle).r] = color.r;
+    pixel[LED_STRIP_COLOR_OFFSETS(handle).g] = color.g;
+    pixel[LED_STRIP_COLOR_OFFSETS(handle).b] = color.b;
+}
+
+static led_strip_color16_t convert_from_rgb16_to_rgbw16(const white_extraction_t *white, led_strip_color16_t color)
+{
+    if (white->enabled == false)
+    {
+        return color;
+    }
+    // Same as the 8 bit conversion, the 16.16 scale needs 64 bit intermediates for 16 bit components.
+    const uint16_t components[3] = {color.r, color.g, color.b};
+    uint32_t w = 0xFFFF;
+    for (int i = 0; i < 3; i++)
+    {
+        const uint32_t limit = (uint32_t)((((uint64_t)components[i] * white->scale[i]) + 0x8000) >> 16) + (white->bias[i] * 257);
+        w = limit < w ? limit : w;
+    }
+    uint16_t result[3];
+    for (int i = 0; i < 3; i++)
+    {
+        const uint32_t used = ((w * white->point[i]) + 127) / 255;
+        result[i] = (uint16_t)(components[i] - (used < components[i] ? used : components[i]));
+    }
+    led_strip_color16_t col = {
+        .r = result[0],
+        .g = result[1],
+        .b = result[2],
+        .w = (uint16_t)w,
+    };
+    return col;
+}
+
+static uint32_t apply_levels16(const uint8_t *gamma_table, uint8_t brightness, uint16_t value)
+{
+    uint32_t level = value;
+    if (gamma_table != NULL)
+    {
+        // Interpolate between the 8 bit table entries, the lower byte of the value is the fraction.
+        const int32_t index = value >> 8;
+        const int32_t next = index < 255 ? index + 1 : index;
+        const int32_t step = (int32_t)gamma_table[next] - (int32_t)gamma_table[index];
+        level = (uint32_t)(((int32_t)gamma_table[index] << 8) + (step * (int32_t)(value & 0xFF)));
+    }
+    return ((level * brightness) + 127) / 255;
+}
+
+static void refresh_task(void *arg)
+{
+    led_strip_handle_t handle = (led_strip_handle_t)arg;
+    while (handle->refresh_running)
+    {
+        esp_err_t err = led_strip_flush(handle);
+        if (err != ESP_OK)
+        {
+            vTaskDelay(1); // Don't starve the other tasks while the error persists.
+        }
+    }
+    xSemaphoreGive(handle->refresh_stopped);
+    vTaskDelete(NULL);
+}
@@ -0,0 +1,489 @@
+/**
+ * @file led_strip_effect.c
+ * @author Giel Willemsen
+ * @brief Effects that render incrementally into a range of a led strip, one frame per call.
+ * @version 0.1 2022-09-07 Initial version
+ * @date 2022-09-07
+ *
+ * @copyright
+ * MIT License
+ *
+ * Copyright (c) 2022 Giel Willemsen
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <esp_log.h>
+#include "led_strip_private.h"
+#include "led_strip_effect.h"
+
+#define FADE_ONE (1UL << 16)
+
+typedef enum effect_kind
+{
+    EFFECT_NONE,
+    EFFECT_GRADIENT,
+    EFFECT_CROSSFADE,
+    EFFECT_CHASE,
+    EFFECT_PALETTE,
+} effect_kind_t;
+
+/// What a framebuffer of the led strip holds of the effect, so a render only writes what differs.
+typedef struct buffer_state
+{
+    const led_strip_color_component_t *buffer; ///< The framebuffer the state is for, NULL if unused.
+    uint32_t version;                          ///< The content version the framebuffer was rendered with, 0 if never.
+    uint32_t config_version;                   ///< The configuration the framebuffer was rendered with.
+    led_strip_pixel_index_t chase_start;       ///< The first pixel of the chase segment in the framebuffer.
+} buffer_state_t;
+
+typedef struct led_strip_effect
+{
+    led_strip_handle_t strip;
+    led_strip_pixel_index_t start;
+    led_strip_pixel_index_t count;
+    effect_kind_t kind;
+    uint32_t version;          ///< Incremented whenever the content of the range changes.
+    uint32_t config_version;   ///< Incremented by every effect function.
+    buffer_state_t states[2];  ///< One per framebuffer, the second one is only used with double buffering.
+    uint8_t next_state;        ///< The state that is taken over by a framebuffer that has none yet.
+    const buffer_state_t *rendered_state; ///< The state of the framebuffer that was rendered last, NULL before the first render.
+    size_t render_end;         ///< One past the highest physical pixel written by the current render.
+    led_strip_color_t colors[2]; ///< The gradient end points, or the chase segment and background color.
+    led_strip_color_component_t *snapshot; ///< The range in the layout of pixel_colors when the crossfade started, allocated on first use.
+    uint8_t fade_target[4];    ///< The target color in the layout of pixel_colors.
+    uint32_t fade_progress;    ///< 0 up to FADE_ONE.
+    uint32_t fade_step;
+    int64_t chase_position;    ///< The first pixel of the segment in 1/256 pixel, below count * 256.
+    led_strip_pixel_index_t chase_length;
+    int16_t chase_speed;
+    led_strip_color_t palette[LED_STRIP_EFFECT_MAX_PALETTE_SIZE];
+    uint8_t palette_size;
+    int64_t palette_phase;     ///< The palette position of the first pixel in 1/65536 entries, below palette_size << 16.
+    int32_t palette_speed;
+} led_strip_effect_t;
+
+static void begin_effect(led_strip_effect_handle_t effect, effect_kind_t kind);
+static void advance_effect(led_strip_effect_handle_t effect);
+static buffer_state_t *find_state(led_strip_effect_handle_t effect);
+static void render_gradient(led_strip_effect_handle_t effect);
+static void render_crossfade(led_strip_effect_handle_t effect);
+static void render_chase(led_strip_effect_handle_t effect, buffer_state_t *state);
+static void render_palette(led_strip_effect_handle_t effect);
+static void fill_range(led_strip_effect_handle_t effect, led_strip_pixel_index_t first, led_strip_pixel_index_t count, led_strip_color_t color);
+static led_strip_color_component_t *pixel_at(led_strip_effect_handle_t effect, led_strip_pixel_index_t i);
+static void put_pixel(led_strip_effect_handle_t effect, led_strip_pixel_index_t i, led_strip_color_t color);
+static uint8_t lerp8(uint8_t from, uint8_t to, uint32_t frac);
+
+extern esp_err_t led_strip_effect_create(led_strip_handle_t strip, led_strip_pixel_index_t start, led_strip_pixel_index_t count, led_strip_effect_handle_t *new_effect)
+{
+    if (strip == NULL || new_effect == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    else if (strip->dither_pixels != NULL || strip->external_framebuffer)
+    {
+        return ESP_ERR_INVALID_ARG; // The framebuffer is overwritten by the dithering, or can be swapped for one the effect never saw.
+    }
+    else if (count == 0 || start >= strip->led_count || count > strip->led_count - start)
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    led_strip_effect_handle_t effect = (led_strip_effect_handle_t)calloc(1, sizeof(led_strip_effect_t));
+    if (effect == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    effect->strip = strip;
+    effect->start = start;
+    effect->count = count;
+    effect->kind = EFFECT_NONE;
+    effect->version = 1;
+    *new_effect = effect;
+    return ESP_OK;
+}
+
+extern esp_err_t led_strip_effect_delete(led_strip_effect_handle_t effect)
+{
+    if (effect == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    free(effect->snapshot);
+    free(effect);
+    return ESP_OK;
+}
+
+extern esp_err_t led_strip_effect_gradient(led_strip_effect_handle_t effect, led_strip_color_t from, led_strip_color_t to)
+{
+    if (effect == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    begin_effect(effect, EFFECT_GRADIENT);
+    effect->colors[0] = led_strip_map_color(effect->strip, from);
+    effect->colors[1] = led_strip_map_color(effect->strip, to);
+    return ESP_OK;
+}
+
+extern esp_err_t led_strip_effect_crossfade(led_strip_effect_handle_t effect, led_strip_color_t target, uint16_t frames)
+{
+    if (effect == NULL || frames == 0)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    const size_t stride = LED_STRIP_PIXEL_STRIDE(effect->strip);
+    if (effect->snapshot == NULL)
+    {
+        effect->snapshot = (led_strip_color_component_t *)malloc(effect->count * stride);
+        if (effect->snapshot == NULL)
+        {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    for (led_strip_pixel_index_t i = 0; i < effect->count; i++)
+    {
+        memcpy(effect->snapshot + (i * stride), pixel_at(effect, i), stride);
+    }
+    const led_strip_color_t color = led_strip_map_color(effect->strip, target);
+    const color_offsets_t offsets = LED_STRIP_COLOR_OFFSETS(effect->strip);
+    memset(effect->fade_target, 0, sizeof(effect->fade_target));
+    effect->fade_target[offsets.r] = color.r;
+    effect->fade_target[offsets.g] = color.g;
+    effect->fade_target[offsets.b] = color.b;
+    if (stride == 4)
+    {
+        effect->fade_target[offsets.w] = color.w;
+    }
+    begin_effect(effect, EFFECT_CROSSFADE);
+    effect->fade_progress = 0;
+    effect->fade_step = (FADE_ONE + frames - 1) / frames;
+    return ESP_OK;
+}
+
+extern esp_err_t led_strip_effect_chase(led_strip_effect_handle_t effect, led_strip_color_t color, led_strip_color_t background, led_strip_pixel_index_t length, int16_t speed)
+{
+    if (effect == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    else if (length == 0 || length >= effect->count)
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    begin_effect(effect, EFFECT_CHASE);
+    effect->colors[0] = led_strip_map_color(effect->strip, color);
+    effect->colors[1] = led_strip_map_color(effect->strip, background);
+    effect->chase_position = 0;
+    effect->chase_length = length;
+    effect->chase_speed = speed;
+    return ESP_OK;
+}
+
+extern esp_err_t led_strip_effect_palette(led_strip_effect_handle_t effect, const led_strip_color_t *palette, uint8_t palette_size, int32_t speed)
+{
+    if (effect == NULL || palette == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    else if (palette_size < 2 || palette_size > LED_STRIP_EFFECT_MAX_PALETTE_SIZE)
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    begin_effect(effect, EFFECT_PALETTE);
+    for (uint8_t i = 0; i < palette_size; i++)
+    {
+        effect->palette[i] = led_strip_map_color(effect->strip, palette[i]);
+    }
+    effect->palette_size = palette_size;
+    effect->palette_phase = 0;
+    effect->palette_speed = speed;
+    return ESP_OK;
+}
+
+extern esp_err_t led_strip_effect_render(led_strip_effect_handle_t effect, bool *changed)
+{
+    if (effect == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    advance_effect(effect);
+    buffer_state_t *state = find_state(effect);
+    const bool render = effect->kind != EFFECT_NONE && state->version != effect->version;
+    if (render)
+    {
+        effect->render_end = 0;
+        switch (effect->kind)
+        {
+        case EFFECT_GRADIENT:
+            render_gradient(effect);
+            break;
+        case EFFECT_CROSSFADE:
+            render_crossfade(effect);
+            break;
+        case EFFECT_CHASE:
+            render_chase(effect, state);
+            break;
+        case EFFECT_PALETTE:
+            render_palette(effect);
+            break;
+        case EFFECT_NONE:
+        default:
+            break;
+        }
+        state->version = effect->version;
+        state->config_version = effect->config_version;
+        effect->rendered_state = state;
+        led_strip_mark_pixels_changed(effect->strip, effect->render_end);
+    }
+    if (changed != NULL)
+    {
+        *changed = render;
+    }
+    return ESP_OK;
+}
+
+extern bool led_strip_effect_frame_cb(led_strip_handle_t handle, void *user_ctx)
+{
+    bool changed = false;
+    esp_err_t err = led_strip_effect_render((led_strip_effect_handle_t)user_ctx, &changed);
+    LED_STRIP_HOT_PATH_ERROR_CHECK(err);
+    // A frame that was rendered before but couldn't be flushed yet still has to be sent.
+    return changed || handle->dirty_end != 0;
+}
+
+// Private functions
+
+static void begin_effect(led_strip_effect_handle_t effect, effect_kind_t kind)
+{
+    effect->kind = kind;
+    effect->config_version++;
+    effect->version++;
+}
+
+static void advance_effect(led_strip_effect_handle_t effect)
+{
+    switch (effect->kind)
+    {
+    case EFFECT_CROSSFADE:
+        if (effect->fade_progress < FADE_ONE)
+        {
+            const uint32_t progress = effect->fade_progress + effect->fade_step;
+            effect->fade_progress = progress < FADE_ONE ? progress : FADE_ONE;
+            effect->version++;
+        }
+        break;
+    case EFFECT_CHASE:
+        if (effect->chase_speed != 0)
+        {
+            const int64_t span = (int64_t)effect->count << 8;
+            const int64_t previous = effect->chase_position >> 8;
+            int64_t position = (effect->chase_position + effect->chase_speed) % span;
+            position = position < 0 ? position + span : position;
+            effect->chase_position = position;
+            if ((position >> 8) != previous)
+            {
+                effect->version++;
+            }
+        }
+        break;
+    case EFFECT_PALETTE:
+        if (effect->palette_speed != 0)
+        {
+            const int64_t span = (int64_t)effect->palette_size << 16;
+            int64_t phase = (effect->palette_phase + effect->palette_speed) % span;
+            effect->palette_phase = phase < 0 ? phase + span : phase;
+            effect->version++;
+        }
+        break;
+    case EFFECT_GRADIENT:
+    case EFFECT_NONE:
+    default:
+        break;
+    }
+}
+
+static buffer_state_t *find_state(led_strip_effect_handle_t effect)
+{
+    led_strip_handle_t strip = effect->strip;
+    const led_strip_color_component_t *buffer = strip->pixel_colors;
+    buffer_state_t *state = NULL;
+    for (size_t i = 0; i < sizeof(effect->states) / sizeof(effect->states[0]) && state == NULL; i++)
+    {
+        if (effect->states[i].buffer == buffer)
+        {
+            state = &effect->states[i];
+        }
+    }
+    if (state == NULL)
+    {
+        state = &effect->states[effect->next_state];
+        effect->next_state ^= 1;
+        state->buffer = buffer;
+        state->version = 0;
+        state->config_version = 0;
+    }
+    if (strip->front_pixel_colors != NULL && strip->enable_partial_flush && effect->rendered_state != NULL && effect->rendered_state != state)
+    {
+        // The flush copied the frame it sent into the new back buffer, so this buffer holds the last render and not
+        // what was rendered into it two frames ago.
+        const buffer_state_t *rendered = effect->rendered_state;
+        state->version = rendered->version;
+        state->config_version = rendered->config_version;
+        state->chase_start = rendered->chase_start;
+    }
+    return state;
+}
+
+static void render_gradient(led_strip_effect_handle_t effect)
+{
+    const led_strip_color_t from = effect->colors[0];
+    const led_strip_color_t to = effect->colors[1];
+    const int32_t steps = effect->count > 1 ? (int32_t)effect->count - 1 : 1;
+    // Every component walks from the first to the last color in 16.16 fixed point, one add per pixel.
+    int32_t r = ((int32_t)from.r << 16) + 0x8000;
+    int32_t g = ((int32_t)from.g << 16) + 0x8000;
+    int32_t b = ((int32_t)from.b << 16) + 0x8000;
+    int32_t w = ((int32_t)from.w << 16) + 0x8000;
+    const int32_t dr = (((int32_t)to.r - from.r) * 65536) / steps;
+    const int32_t dg = (((int32_t)to.g - from.g) * 65536) / steps;
+    const int32_t db = (((int32_t)to.b - from.b) * 65536) / steps;
+    const int32_t dw = (((int32_t)to.w - from.w) * 65536) / steps;
+    for (led_strip_pixel_index_t i = 0; i < effect->count; i++)
+    {
+        const led_strip_color_t color = {
+            .r = (led_strip_color_component_t)(r >> 16),
+            .g = (led_strip_color_component_t)(g >> 16),
+            .b = (led_strip_color_component_t)(b >> 16),
+            .w = (led_strip_color_component_t)(w >> 16),
+        };
+        put_pixel(effect, i, color);
+        r += dr;
+        g += dg;
+        b += db;
+        w += dw;
+    }
+}
+
+static void render_crossfade(led_strip_effect_handle_t effect)
+{
+    // Both ends are in the layout of pixel_colors, so the fade works on the bytes without knowing the color order.
+    const size_t stride = LED_STRIP_PIXEL_STRIDE(effect->strip);
+    const int32_t progress = (int32_t)effect->fade_progress;
+    const led_strip_color_component_t *source = effect->snapshot;
+    for (led_strip_pixel_index_t i = 0; i < effect->count; i++, source += stride)
+    {
+        led_strip_color_component_t *pixel = pixel_at(effect, i);
+        for (size_t j = 0; j < stride; j++)
+        {
+            const int32_t from = source[j];
+            pixel[j] = (led_strip_color_component_t)(from + ((((int32_t)effect->fade_target[j] - from) * progress) >> 16));
+        }
+        const size_t end = (size_t)led_strip_physical_index(effect->strip, effect->start + i) + 1;
+        effect->render_end = end > effect->render_end ? end : effect->render_end;
+    }
+}
+
+static void render_chase(led_strip_effect_handle_t effect, buffer_state_t *state)
+{
+    const led_strip_pixel_index_t first = (led_strip_pixel_index_t)(effect->chase_position >> 8);
+    if (state->config_version == effect->config_version)
+    {
+        // The framebuffer shows this chase already, only the pixels that the segment left and entered change.
+        fill_range(effect, state->chase_start, effect->chase_length, effect->colors[1]);
+    }
+    else
+    {
+        fill_range(effect, 0, effect->count, effect->colors[1]);
+    }
+    fill_range(effect, first, effect->chase_length, effect->colors[0]);
+    state->chase_start = first;
+}
+
+static void render_palette(led_strip_effect_handle_t effect)
+{
+    const int64_t span = (int64_t)effect->palette_size << 16;
+    const int64_t step = span / effect->count;
+    int64_t phase = effect->palette_phase;
+    for (led_strip_pixel_index_t i = 0; i < effect->count; i++)
+    {
+        const uint8_t index = (uint8_t)(phase >> 16);
+        const led_strip_color_t from = effect->palette[index];
+        const led_strip_color_t to = effect->palette[index + 1 < effect->palette_size ? index + 1 : 0];
+        const uint32_t frac = (uint32_t)(phase >> 8) & 0xFF;
+        const led_strip_color_t color = {
+            .r = lerp8(from.r, to.r, frac),
+            .g = lerp8(from.g, to.g, frac),
+            .b = lerp8(from.b, to.b, frac),
+            .w = lerp8(from.w, to.w, frac),
+        };
+        put_pixel(effect, i, color);
+        phase += step;
+        if (phase >= span)
+        {
+            phase -= span;
+        }
+    }
+}
+
+static void fill_range(led_strip_effect_handle_t effect, led_strip_pixel_index_t first, led_strip_pixel_index_t count, led_strip_color_t color)
+{
+    // The range wraps around, first is always within it.
+    led_strip_pixel_index_t i = first;
+    for (led_strip_pixel_index_t n = 0; n < count; n++)
+    {
+        put_pixel(effect, i, color);
+        i = i + 1 < effect->count ? i + 1 : 0;
+    }
+}
+
+static led_strip_color_component_t *pixel_at(led_strip_effect_handle_t effect, led_strip_pixel_index_t i)
+{
+    led_strip_handle_t strip = effect->strip;
+    return strip->pixel_colors + (LED_STRIP_PIXEL_STRIDE(strip) * led_strip_physical_index(strip, effect->start + i));
+}
+
+static void put_pixel(led_strip_effect_handle_t effect, led_strip_pixel_index_t i, led_strip_color_t color)
+{
+    led_strip_handle_t strip = effect->strip;
+    const led_strip_pixel_index_t index = led_strip_physical_index(strip, effect->start + i);
+    led_strip_color_component_t *pixel = strip->pixel_colors + (LED_STRIP_PIXEL_STRIDE(strip) * index);
+    const color_offsets_t offsets = LED_STRIP_COLOR_OFFSETS(strip);
+    if (LED_STRIP_PIXEL_STRIDE(strip) == 4)
+    {
+        pixel[offsets.w] = color.w;
+    }
+    pixel[offsets.r] = color.r;
+    pixel[offsets.g] = color.g;
+    pixel[offsets.b] = color.b;
+    if ((size_t)index >= effect->render_end)
+    {
+        effect->render_end = (size_t)index + 1;
+    }
+}
+
+static uint8_t lerp8(uint8_t from, uint8_t to, uint32_t frac)
+{
+    return (uint8_t)((int32_t)from + ((((int32_t)to - from) * (int32_t)frac) >> 8));
+}
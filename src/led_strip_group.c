@@ -0,0 +1,192 @@
+/**
+ * @file led_strip_group.c
+ * @author Giel Willemsen
+ * @brief Flushing multiple led strips together.
+ * @version 0.1 2022-09-07 Initial version
+ * @date 2022-09-07
+ *
+ * @copyright
+ * MIT License
+ *
+ * Copyright (c) 2022 Giel Willemsen
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <esp_log.h>
+#include "led_strip_private.h"
+
+typedef struct led_strip_group
+{
+    led_strip_handle_t *strips;
+    size_t strip_count;
+    EventGroupHandle_t events;
+    EventBits_t all_bits;
+    void *backend_context; ///< Owned by the backend of the strips.
+} led_strip_group_t;
+
+static void dealloc_group(led_strip_group_handle_t group);
+
+extern esp_err_t led_strip_group_create(const led_strip_handle_t *strips, size_t strip_count, led_strip_group_handle_t *new_group)
+{
+    if (strips == NULL || new_group == NULL || strip_count == 0)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    else if (strip_count > LED_STRIP_GROUP_MAX_STRIPS)
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    for (size_t i = 0; i < strip_count; i++)
+    {
+        if (strips[i] == NULL || strips[i]->backend != strips[0]->backend)
+        {
+            return ESP_ERR_INVALID_ARG;
+        }
+        else if (strips[i]->group_events != NULL)
+        {
+            return ESP_ERR_INVALID_STATE;
+        }
+    }
+
+    led_strip_group_handle_t group = (led_strip_group_handle_t)calloc(1, sizeof(led_strip_group_t));
+    if (group == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    group->strips = (led_strip_handle_t *)calloc(strip_count, sizeof(led_strip_handle_t));
+    group->events = xEventGroupCreate();
+    if (group->strips == NULL || group->events == NULL)
+    {
+        dealloc_group(group);
+        return ESP_ERR_NO_MEM;
+    }
+    memcpy(group->strips, strips, strip_count * sizeof(led_strip_handle_t));
+    group->strip_count = strip_count;
+
+    const led_strip_backend_t *backend = strips[0]->backend;
+    if (backend->group_install != NULL)
+    {
+        esp_err_t err = backend->group_install(group->strips, strip_count, &group->backend_context);
+        ESP_ERROR_CHECK_WITHOUT_ABORT(err);
+        if (err != ESP_OK)
+        {
+            dealloc_group(group);
+            return err;
+        }
+    }
+
+    for (size_t i = 0; i < strip_count; i++)
+    {
+        group->strips[i]->group_bit = (EventBits_t)1 << i;
+        group->all_bits |= group->strips[i]->group_bit;
+        group->strips[i]->group_events = group->events;
+    }
+    *new_group = group;
+    return ESP_OK;
+}
+
+extern esp_err_t led_strip_group_delete(led_strip_group_handle_t group)
+{
+    if (group == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    const led_strip_backend_t *backend = group->strips[0]->backend;
+    if (backend->group_uninstall != NULL)
+    {
+        esp_err_t err = backend->group_uninstall(group->strips, group->strip_count, group->backend_context);
+        ESP_ERROR_CHECK_WITHOUT_ABORT(err);
+        if (err != ESP_OK)
+        {
+            return err;
+        }
+    }
+    for (size_t i = 0; i < group->strip_count; i++)
+    {
+        group->strips[i]->group_events = NULL;
+        group->strips[i]->group_bit = 0;
+    }
+    dealloc_group(group);
+    return ESP_OK;
+}
+
+extern esp_err_t led_strip_group_flush(led_strip_group_handle_t group)
+{
+    if (group == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    // Check everything up front, a strip that can't start would otherwise stall the synchronized start of the others.
+    for (size_t i = 0; i < group->strip_count; i++)
+    {
+        bool done = false;
+        esp_err_t err = led_strip_flush_done(group->strips[i], &done);
+        if (err != ESP_OK)
+        {
+            return err;
+        }
+        if (done == false)
+        {
+            return ESP_ERR_NOT_FINISHED;
+        }
+    }
+
+    xEventGroupClearBits(group->events, group->all_bits);
+    for (size_t i = 0; i < group->strip_count; i++)
+    {
+        esp_err_t err = led_strip_start_flush(group->strips[i]);
+        LED_STRIP_HOT_PATH_ERROR_CHECK(err);
+        if (err != ESP_OK)
+        {
+            return err;
+        }
+    }
+    return ESP_OK;
+}
+
+extern esp_err_t led_strip_group_wait(led_strip_group_handle_t group, TickType_t timeout)
+{
+    if (group == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    EventBits_t bits = xEventGroupWaitBits(group->events, group->all_bits, pdFALSE, pdTRUE, timeout);
+    if ((bits & group->all_bits) != group->all_bits)
+    {
+        return ESP_ERR_TIMEOUT;
+    }
+    return ESP_OK;
+}
+
+// Private functions
+
+static void dealloc_group(led_strip_group_handle_t group)
+{
+    if (group->events != NULL)
+    {
+        vEventGroupDelete(group->events);
+    }
+    free(group->strips);
+    free(group);
+}
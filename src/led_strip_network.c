@@ -0,0 +1,648 @@
+/**
+ * @file led_strip_network.c
+ * @author Giel Willemsen
+ * @brief Receives DDP, E1.31 and Art-Net pixel data straight into the framebuffers of led strips.
+ * @version 0.1 2022-09-07 Initial version
+ * @date 2022-09-07
+ *
+ * @copyright
+ * MIT License
+ *
+ * Copyright (c) 2022 Giel Willemsen
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#include <lwip/sockets.h>
+#include "led_strip_private.h"
+#include "led_strip_network.h"
+
+#define PACKET_BUFFER_SIZE 1472 ///< The largest UDP payload that fits an Ethernet frame.
+#define RECEIVE_TIMEOUT_MS 100
+
+#define DDP_HEADER_SIZE 10
+#define DDP_TIMECODE_SIZE 4
+#define DDP_VERSION_MASK 0xC0
+#define DDP_VERSION_1 0x40
+#define DDP_FLAG_TIMECODE 0x10
+#define DDP_FLAG_STORAGE 0x08
+#define DDP_FLAG_REPLY 0x04
+#define DDP_FLAG_QUERY 0x02
+#define DDP_FLAG_PUSH 0x01
+#define DDP_ID_DISPLAY 1
+#define DDP_ID_ALL 255
+
+#define E131_DATA_HEADER_SIZE 126 ///< Up to and including the DMX start code.
+#define E131_SYNC_PACKET_SIZE 49
+#define E131_ROOT_VECTOR_DATA 0x00000004
+#define E131_ROOT_VECTOR_EXTENDED 0x00000008
+#define E131_FRAMING_VECTOR_DATA 0x00000002
+#define E131_EXTENDED_VECTOR_SYNC 0x00000001
+#define E131_DMP_VECTOR_SET_PROPERTY 0x02
+#define E131_OPTION_PREVIEW 0x80
+#define E131_OPTION_TERMINATED 0x40
+#define E131_MULTICAST_BASE 0xEFFF0000 ///< 239.255.0.0, the low 16 bits are the universe.
+
+#define ARTNET_HEADER_SIZE 18
+#define ARTNET_SYNC_SIZE 14
+#define ARTNET_OP_DMX 0x5000
+#define ARTNET_OP_SYNC 0x5200
+#define ARTNET_SYNC_TIMEOUT_US (4 * 1000 * 1000) ///< Without an ArtSync for this long the data is shown right away again.
+
+typedef struct network_strip
+{
+    led_strip_handle_t strip;
+    bool pending;           ///< Data was written since the last flush.
+    uint16_t sync_address;  ///< The E1.31 synchronization universe of the pending data, 0 to flush it right away.
+} network_strip_t;
+
+typedef struct network_mapping
+{
+    led_strip_network_mapping_t config;
+    network_strip_t *strip;
+    uint8_t sequence;       ///< The last E1.31 sequence number of the universe.
+    bool has_sequence;
+} network_mapping_t;
+
+typedef struct led_strip_network
+{
+    led_strip_network_protocol_t protocol;
+    uint16_t port;
+    network_mapping_t *mappings;
+    size_t mapping_count;
+    network_strip_t *strips; ///< The distinct led strips of the mappings.
+    size_t strip_count;
+    int64_t artnet_sync_time; ///< The esp_timer time of the last ArtSync, or 0.
+    led_strip_network_stats_t stats;
+    UBaseType_t task_priority;
+    BaseType_t core_id;
+    int socket;
+    TaskHandle_t task;
+    SemaphoreHandle_t stopped; ///< Given by the receive task right before it deletes itself.
+    volatile bool running;
+    uint8_t packet[PACKET_BUFFER_SIZE];
+} led_strip_network_t;
+
+static esp_err_t alloc_mappings(led_strip_network_handle_t network, const led_strip_network_config_t *config);
+static void dealloc_network(led_strip_network_handle_t network);
+static esp_err_t handle_ddp(led_strip_network_handle_t network, const uint8_t *data, size_t size);
+static esp_err_t handle_e131(led_strip_network_handle_t network, const uint8_t *data, size_t size);
+static esp_err_t handle_artnet(led_strip_network_handle_t network, const uint8_t *data, size_t size);
+static bool write_universe(led_strip_network_handle_t network, uint32_t universe, const uint8_t *payload, size_t size, uint16_t sync_address);
+static void write_pixels(network_mapping_t *mapping, size_t offset, const uint8_t *payload, size_t size, uint16_t sync_address);
+static void flush_pending(led_strip_network_handle_t network, bool any_sync_address, uint16_t sync_address);
+static esp_err_t open_socket(led_strip_network_handle_t network);
+static void receive_task(void *arg);
+static uint16_t read_be16(const uint8_t *data);
+static uint32_t read_be32(const uint8_t *data);
+
+extern void led_strip_network_init_config(led_strip_network_config_t *config)
+{
+    if (config == NULL)
+    {
+        return;
+    }
+    config->protocol = LED_STRIP_NETWORK_PROTOCOL_DDP;
+    config->mappings = NULL;
+    config->mapping_count = 0;
+    config->port = 0;
+    config->task_priority = 5;
+    config->core_id = tskNO_AFFINITY;
+    return;
+}
+
+extern esp_err_t led_strip_network_create(const led_strip_network_config_t *config, led_strip_network_handle_t *new_network)
+{
+    if (config == NULL || new_network == NULL || config->mappings == NULL || config->mapping_count == 0 || config->protocol > LED_STRIP_NETWORK_PROTOCOL_ARTNET)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (size_t i = 0; i < config->mapping_count; i++)
+    {
+        const led_strip_network_mapping_t *mapping = &config->mappings[i];
+        if (mapping->strip == NULL || mapping->strip->dither_pixels != NULL)
+        {
+            return ESP_ERR_INVALID_ARG; // The dithering overwrites pixel_colors from its own framebuffer every sub-frame.
+        }
+        else if (mapping->count == 0 || mapping->start >= mapping->strip->led_count || mapping->count > mapping->strip->led_count - mapping->start)
+        {
+            return ESP_ERR_INVALID_SIZE;
+        }
+    }
+
+    led_strip_network_handle_t network = (led_strip_network_handle_t)calloc(1, sizeof(led_strip_network_t));
+    if (network == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    network->protocol = config->protocol;
+    network->task_priority = config->task_priority;
+    network->core_id = config->core_id;
+    network->socket = -1;
+    network->port = config->port;
+    if (network->port == 0)
+    {
+        const uint16_t default_ports[] = {LED_STRIP_NETWORK_DDP_PORT, LED_STRIP_NETWORK_E131_PORT, LED_STRIP_NETWORK_ARTNET_PORT};
+        network->port = default_ports[config->protocol];
+    }
+    esp_err_t err = alloc_mappings(network, config);
+    if (err != ESP_OK)
+    {
+        dealloc_network(network);
+        return err;
+    }
+    *new_network = network;
+    return ESP_OK;
+}
+
+extern esp_err_t led_strip_network_delete(led_strip_network_handle_t network)
+{
+    if (network == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (network->task != NULL)
+    {
+        led_strip_network_stop(network);
+    }
+    dealloc_network(network);
+    return ESP_OK;
+}
+
+extern esp_err_t led_strip_network_handle_packet(led_strip_network_handle_t network, const uint8_t *data, size_t size)
+{
+    if (network == NULL || data == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    network->stats.packets++;
+    esp_err_t err = ESP_ERR_NOT_SUPPORTED;
+    switch (network->protocol)
+    {
+    case LED_STRIP_NETWORK_PROTOCOL_DDP:
+        err = handle_ddp(network, data, size);
+        break;
+    case LED_STRIP_NETWORK_PROTOCOL_E131:
+        err = handle_e131(network, data, size);
+        break;
+    case LED_STRIP_NETWORK_PROTOCOL_ARTNET:
+        err = handle_artnet(network, data, size);
+        break;
+    default:
+        break;
+    }
+    if (err == ESP_ERR_INVALID_SIZE || err == ESP_ERR_NOT_SUPPORTED)
+    {
+        network->stats.packets_malformed++;
+    }
+    return err;
+}
+
+extern esp_err_t led_strip_network_start(led_strip_network_handle_t network)
+{
+    if (network == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    else if (network->task != NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    esp_err_t err = open_socket(network);
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+    network->stopped = xSemaphoreCreateBinary();
+    if (network->stopped == NULL)
+    {
+        close(network->socket);
+        network->socket = -1;
+        return ESP_ERR_NO_MEM;
+    }
+    network->running = true;
+    if (xTaskCreatePinnedToCore(receive_task, "led_strip_net", CONFIG_LED_STRIP_NETWORK_TASK_STACK_SIZE, network, network->task_priority, &network->task, network->core_id) != pdPASS)
+    {
+        network->task = NULL;
+        vSemaphoreDelete(network->stopped);
+        network->stopped = NULL;
+        close(network->socket);
+        network->socket = -1;
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+extern esp_err_t led_strip_network_stop(led_strip_network_handle_t network)
+{
+    if (network == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    else if (network->task == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    // The receive timeout makes the task check running at least every RECEIVE_TIMEOUT_MS.
+    network->running = false;
+    xSemaphoreTake(network->stopped, portMAX_DELAY);
+    vSemaphoreDelete(network->stopped);
+    network->stopped = NULL;
+    network->task = NULL;
+    close(network->socket);
+    network->socket = -1;
+    return ESP_OK;
+}
+
+extern esp_err_t led_strip_network_get_stats(led_strip_network_handle_t network, led_strip_network_stats_t *stats)
+{
+    if (network == NULL || stats == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *stats = network->stats;
+    return ESP_OK;
+}
+
+// Private functions
+
+static esp_err_t alloc_mappings(led_strip_network_handle_t network, const led_strip_network_config_t *config)
+{
+    network->mappings = (network_mapping_t *)calloc(config->mapping_count, sizeof(network_mapping_t));
+    network->strips = (network_strip_t *)calloc(config->mapping_count, sizeof(network_strip_t));
+    if (network->mappings == NULL || network->strips == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    network->mapping_count = config->mapping_count;
+    for (size_t i = 0; i < config->mapping_count; i++)
+    {
+        network_mapping_t *mapping = &network->mappings[i];
+        mapping->config = config->mappings[i];
+        for (size_t j = 0; j < network->strip_count && mapping->strip == NULL; j++)
+        {
+            if (network->strips[j].strip == mapping->config.strip)
+            {
+                mapping->strip = &network->strips[j];
+            }
+        }
+        if (mapping->strip == NULL)
+        {
+            mapping->strip = &network->strips[network->strip_count++];
+            mapping->strip->strip = mapping->config.strip;
+        }
+    }
+    return ESP_OK;
+}
+
+static void dealloc_network(led_strip_network_handle_t network)
+{
+    free(network->mappings);
+    free(network->strips);
+    free(network);
+}
+
+static esp_err_t handle_ddp(led_strip_network_handle_t network, const uint8_t *data, size_t size)
+{
+    if (size < DDP_HEADER_SIZE)
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    const uint8_t flags = data[0];
+    if ((flags & DDP_VERSION_MASK) != DDP_VERSION_1)
+    {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    const size_t header_size = DDP_HEADER_SIZE + ((flags & DDP_FLAG_TIMECODE) ? DDP_TIMECODE_SIZE : 0);
+    const uint32_t offset = read_be32(data + 4);
+    const size_t length = read_be16(data + 8);
+    if (size < header_size + length)
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if ((flags & (DDP_FLAG_STORAGE | DDP_FLAG_REPLY | DDP_FLAG_QUERY)) != 0 || (data[3] != DDP_ID_DISPLAY && data[3] != DDP_ID_ALL))
+    {
+        network->stats.packets_ignored++; // Configuration, status and queries are for other devices or the application.
+        return ESP_OK;
+    }
+
+    const uint8_t *payload = data + header_size;
+    for (size_t i = 0; i < network->mapping_count; i++)
+    {
+        // The mapping covers a window of the stream, the packet writes the part of it that overlaps that window.
+        network_mapping_t *mapping = &network->mappings[i];
+        const size_t window_start = mapping->config.address;
+        const size_t window_end = window_start + ((size_t)mapping->config.count * LED_STRIP_PIXEL_STRIDE(mapping->config.strip));
+        const size_t start = offset > window_start ? offset : window_start;
+        const size_t end = offset + length < window_end ? offset + length : window_end;
+        if (start < end)
+        {
+            write_pixels(mapping, start - window_start, payload + (start - offset), end - start, 1);
+        }
+    }
+    if (flags & DDP_FLAG_PUSH)
+    {
+        network->stats.syncs++;
+        flush_pending(network, true, 0);
+    }
+    return ESP_OK;
+}
+
+static esp_err_t handle_e131(led_strip_network_handle_t network, const uint8_t *data, size_t size)
+{
+    static const uint8_t identifier[12] = {'A', 'S', 'C', '-', 'E', '1', '.', '1', '7', 0x00, 0x00, 0x00};
+    if (size < E131_SYNC_PACKET_SIZE)
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    else if (memcmp(data + 4, identifier, sizeof(identifier)) != 0)
+    {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    const uint32_t root_vector = read_be32(data + 18);
+    const uint32_t framing_vector = read_be32(data + 40);
+    if (root_vector == E131_ROOT_VECTOR_EXTENDED && framing_vector == E131_EXTENDED_VECTOR_SYNC)
+    {
+        network->stats.syncs++;
+        flush_pending(network, false, read_be16(data + 45));
+        return ESP_OK;
+    }
+    else if (root_vector != E131_ROOT_VECTOR_DATA || framing_vector != E131_FRAMING_VECTOR_DATA)
+    {
+        network->stats.packets_ignored++; // Universe discovery.
+        return ESP_OK;
+    }
+    else if (size < E131_DATA_HEADER_SIZE)
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    const uint16_t sync_address = read_be16(data + 109);
+    const uint8_t sequence = data[111];
+    const uint8_t options = data[112];
+    const uint16_t universe = read_be16(data + 113);
+    const size_t value_count = read_be16(data + 123);
+    if (data[117] != E131_DMP_VECTOR_SET_PROPERTY || value_count == 0 || size < (E131_DATA_HEADER_SIZE - 1) + value_count)
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    bool late = false;
+    for (size_t i = 0; i < network->mapping_count; i++)
+    {
+        // E1.31 drops a packet that is at most 20 sequence numbers behind the last one of its universe.
+        network_mapping_t *mapping = &network->mappings[i];
+        if (mapping->config.address == universe && mapping->has_sequence)
+        {
+            const int8_t difference = (int8_t)(sequence - mapping->sequence);
+            late = late || (difference <= 0 && difference > -20);
+        }
+    }
+    if (late)
+    {
+        network->stats.packets_late++;
+        return ESP_OK;
+    }
+    for (size_t i = 0; i < network->mapping_count; i++)
+    {
+        if (network->mappings[i].config.address == universe)
+        {
+            network->mappings[i].sequence = sequence;
+            network->mappings[i].has_sequence = true;
+        }
+    }
+    if ((options & (E131_OPTION_PREVIEW | E131_OPTION_TERMINATED)) != 0 || data[E131_DATA_HEADER_SIZE - 1] != 0x00)
+    {
+        network->stats.packets_ignored++; // Only DMX data with the null start code is pixel data.
+        return ESP_OK;
+    }
+
+    if (write_universe(network, universe, data + E131_DATA_HEADER_SIZE, value_count - 1, sync_address) == false)
+    {
+        network->stats.packets_ignored++;
+    }
+    else if (sync_address == 0)
+    {
+        network->stats.syncs++;
+        flush_pending(network, false, 0);
+    }
+    return ESP_OK;
+}
+
+static esp_err_t handle_artnet(led_strip_network_handle_t network, const uint8_t *data, size_t size)
+{
+    static const uint8_t identifier[8] = {'A', 'r', 't', '-', 'N', 'e', 't', 0x00};
+    if (size < ARTNET_SYNC_SIZE)
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    else if (memcmp(data, identifier, sizeof(identifier)) != 0)
+    {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    const uint16_t opcode = (uint16_t)(data[8] | (data[9] << 8));
+    if (opcode == ARTNET_OP_SYNC)
+    {
+        network->artnet_sync_time = esp_timer_get_time();
+        network->stats.syncs++;
+        flush_pending(network, true, 0);
+        return ESP_OK;
+    }
+    else if (opcode != ARTNET_OP_DMX)
+    {
+        network->stats.packets_ignored++; // Polls and the other operations are for the application.
+        return ESP_OK;
+    }
+    else if (size < ARTNET_HEADER_SIZE)
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    const uint16_t universe = (uint16_t)((data[14] | (data[15] << 8)) & 0x7FFF);
+    const size_t length = read_be16(data + 16);
+    if (size < ARTNET_HEADER_SIZE + length)
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (write_universe(network, universe, data + ARTNET_HEADER_SIZE, length, 0) == false)
+    {
+        network->stats.packets_ignored++;
+        return ESP_OK;
+    }
+    const bool synced = network->artnet_sync_time != 0 && esp_timer_get_time() - network->artnet_sync_time < ARTNET_SYNC_TIMEOUT_US;
+    if (synced == false)
+    {
+        network->stats.syncs++;
+        flush_pending(network, true, 0);
+    }
+    return ESP_OK;
+}
+
+static bool write_universe(led_strip_network_handle_t network, uint32_t universe, const uint8_t *payload, size_t size, uint16_t sync_address)
+{
+    bool mapped = false;
+    for (size_t i = 0; i < network->mapping_count; i++)
+    {
+        if (network->mappings[i].config.address == universe)
+        {
+            write_pixels(&network->mappings[i], 0, payload, size, sync_address);
+            mapped = true;
+        }
+    }
+    return mapped;
+}
+
+static void write_pixels(network_mapping_t *mapping, size_t offset, const uint8_t *payload, size_t size, uint16_t sync_address)
+{
+    led_strip_handle_t strip = mapping->config.strip;
+    const size_t stride = LED_STRIP_PIXEL_STRIDE(strip);
+    const size_t range_size = (size_t)mapping->config.count * stride;
+    if (offset >= range_size)
+    {
+        return;
+    }
+    size = size < range_size - offset ? size : range_size - offset;
+    const size_t first = mapping->config.start + (offset / stride);
+    const size_t last = mapping->config.start + ((offset + size - 1) / stride);
+    size_t end = last + 1;
+    if (strip->remap == NULL)
+    {
+        memcpy(strip->pixel_colors + (mapping->config.start * stride) + offset, payload, size);
+    }
+    else
+    {
+        // Every pixel goes to its own physical pixel, the first and last one may only be partly in the packet.
+        end = 0;
+        for (size_t pixel = first; pixel <= last; pixel++)
+        {
+            const size_t pixel_offset = (pixel - mapping->config.start) * stride;
+            const size_t from = pixel_offset > offset ? pixel_offset - offset : 0;
+            const size_t skip = offset > pixel_offset ? offset - pixel_offset : 0;
+            const size_t bytes = (stride - skip) < (size - from) ? stride - skip : size - from;
+            const led_strip_pixel_index_t physical = strip->remap[pixel];
+            memcpy(strip->pixel_colors + (physical * stride) + skip, payload + from, bytes);
+            end = physical >= end ? (size_t)physical + 1 : end;
+        }
+    }
+    led_strip_mark_pixels_changed(strip, end);
+    mapping->strip->pending = true;
+    mapping->strip->sync_address = sync_address;
+}
+
+static void flush_pending(led_strip_network_handle_t network, bool any_sync_address, uint16_t sync_address)
+{
+    for (size_t i = 0; i < network->strip_count; i++)
+    {
+        network_strip_t *entry = &network->strips[i];
+        if (entry->pending == false || (any_sync_address == false && entry->sync_address != sync_address))
+        {
+            continue;
+        }
+        esp_err_t err = led_strip_start_flush(entry->strip);
+        if (err == ESP_ERR_NOT_FINISHED)
+        {
+            // The previous frame is still being sent, waiting for it is shorter than waiting for the next sync.
+            err = led_strip_wait_for_flush_finish(entry->strip);
+            if (err == ESP_OK)
+            {
+                err = led_strip_start_flush(entry->strip);
+            }
+        }
+        LED_STRIP_HOT_PATH_ERROR_CHECK(err);
+        entry->pending = false;
+        if (err == ESP_OK)
+        {
+            network->stats.flushes++;
+        }
+    }
+}
+
+static esp_err_t open_socket(led_strip_network_handle_t network)
+{
+    network->socket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (network->socket < 0)
+    {
+        return ESP_FAIL;
+    }
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(network->port);
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    const struct timeval timeout = {
+        .tv_sec = 0,
+        .tv_usec = RECEIVE_TIMEOUT_MS * 1000,
+    };
+    bool opened = bind(network->socket, (struct sockaddr *)&address, sizeof(address)) == 0 &&
+                  setsockopt(network->socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) == 0;
+    if (network->protocol == LED_STRIP_NETWORK_PROTOCOL_E131)
+    {
+        // E1.31 sends every universe to its own multicast group.
+        for (size_t i = 0; i < network->mapping_count && opened; i++)
+        {
+            struct ip_mreq request;
+            memset(&request, 0, sizeof(request));
+            request.imr_multiaddr.s_addr = htonl(E131_MULTICAST_BASE | (network->mappings[i].config.address & 0xFFFF));
+            request.imr_interface.s_addr = htonl(INADDR_ANY);
+            opened = setsockopt(network->socket, IPPROTO_IP, IP_ADD_MEMBERSHIP, &request, sizeof(request)) == 0;
+        }
+    }
+    if (opened == false)
+    {
+        close(network->socket);
+        network->socket = -1;
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+static void receive_task(void *arg)
+{
+    led_strip_network_handle_t network = (led_strip_network_handle_t)arg;
+    while (network->running)
+    {
+        const int received = recv(network->socket, network->packet, sizeof(network->packet), 0);
+        if (received > 0)
+        {
+            led_strip_network_handle_packet(network, network->packet, (size_t)received);
+        }
+    }
+    xSemaphoreGive(network->stopped);
+    vTaskDelete(NULL);
+}
+
+static uint16_t read_be16(const uint8_t *data)
+{
+    return (uint16_t)((data[0] << 8) | data[1]);
+}
+
+static uint32_t read_be32(const uint8_t *data)
+{
+    return ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) | ((uint32_t)data[2] << 8) | data[3];
+}
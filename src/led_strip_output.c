@@ -0,0 +1,327 @@
+/**
+ * @file led_strip_output.c
+ * @author Giel Willemsen
+ * @brief An output service that flushes led strips from its own task, fed through a frame queue per led strip.
+ * @version 0.1 2022-09-07 Initial version
+ * @date 2022-09-07
+ *
+ * @copyright
+ * MIT License
+ *
+ * Copyright (c) 2022 Giel Willemsen
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <esp_log.h>
+#include <esp_heap_caps.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#include "led_strip_private.h"
+#include "led_strip_output.h"
+
+/// A single producer, single consumer ring of frame slots. Every counter only ever grows and is written by one side.
+/// head and tail are stored with release and loaded with acquire ordering, so the side that sees a counter move also
+/// sees the slot contents that were written before it moved.
+typedef struct output_ring
+{
+    led_strip_handle_t strip;
+    led_strip_color_component_t *slots; ///< slot_count frames of frame_size bytes.
+    led_strip_color_component_t *own_buffer; ///< The pixel_colors of the led strip before the output service, given back on delete.
+    size_t frame_size;
+    uint32_t head;          ///< Frames submitted, written by the producer.
+    uint32_t tail;          ///< Frames released, written by the output task. A slot is free when it is less than slot_count frames ahead.
+    bool acquired;          ///< The producer holds the slot at head.
+    bool transmitting;      ///< The output task is sending the frame at in_flight.
+    uint32_t in_flight;
+    led_strip_output_stats_t stats;
+} output_ring_t;
+
+typedef struct led_strip_output
+{
+    output_ring_t *rings;
+    size_t ring_count;
+    uint8_t slot_count;
+    TaskHandle_t task;
+    SemaphoreHandle_t stopped; ///< Given by the output task right before it deletes itself.
+    volatile bool running;
+} led_strip_output_t;
+
+static esp_err_t alloc_rings(led_strip_output_handle_t output, const led_strip_handle_t *strips);
+static void dealloc_output(led_strip_output_handle_t output);
+static bool start_transmissions(led_strip_output_handle_t output);
+static void finish_transmissions(led_strip_output_handle_t output);
+static void output_task(void *arg);
+
+extern void led_strip_output_init_config(led_strip_output_config_t *config)
+{
+    if (config == NULL)
+    {
+        return;
+    }
+    config->task_priority = 5;
+    config->core_id = tskNO_AFFINITY;
+    config->slot_count = 3;
+    return;
+}
+
+extern esp_err_t led_strip_output_create(const led_strip_handle_t *strips, size_t strip_count, const led_strip_output_config_t *config, led_strip_output_handle_t *new_output)
+{
+    if (strips == NULL || config == NULL || new_output == NULL || strip_count == 0 || config->slot_count < 2)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (size_t i = 0; i < strip_count; i++)
+    {
+        // Dithering, the refresh task and the scheduler would all flush the led strip behind the back of the output task.
+        if (strips[i] == NULL || strips[i]->dither_pixels != NULL || strips[i]->refresh_task != NULL || strips[i]->scheduler != NULL)
+        {
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+
+    led_strip_output_handle_t output = (led_strip_output_handle_t)calloc(1, sizeof(led_strip_output_t));
+    if (output == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    output->ring_count = strip_count;
+    output->slot_count = config->slot_count;
+    esp_err_t err = alloc_rings(output, strips);
+    if (err != ESP_OK)
+    {
+        dealloc_output(output);
+        return err;
+    }
+    output->stopped = xSemaphoreCreateBinary();
+    if (output->stopped == NULL)
+    {
+        dealloc_output(output);
+        return ESP_ERR_NO_MEM;
+    }
+    output->running = true;
+    if (xTaskCreatePinnedToCore(output_task, "led_strip_output", CONFIG_LED_STRIP_OUTPUT_TASK_STACK_SIZE, output, config->task_priority, &output->task, config->core_id) != pdPASS)
+    {
+        dealloc_output(output);
+        return ESP_ERR_NO_MEM;
+    }
+    *new_output = output;
+    return ESP_OK;
+}
+
+extern esp_err_t led_strip_output_delete(led_strip_output_handle_t output)
+{
+    if (output == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    output->running = false;
+    xTaskNotifyGive(output->task);
+    xSemaphoreTake(output->stopped, portMAX_DELAY);
+    for (size_t i = 0; i < output->ring_count; i++)
+    {
+        output_ring_t *ring = &output->rings[i];
+        if (ring->strip->external_framebuffer)
+        {
+            // The led strip transmits the slots in place, so it has to let go of them before they are freed.
+            led_strip_wait_for_flush_finish(ring->strip);
+            ring->strip->pixel_colors = ring->own_buffer;
+            led_strip_mark_pixels_changed(ring->strip, ring->strip->led_count);
+        }
+    }
+    dealloc_output(output);
+    return ESP_OK;
+}
+
+extern esp_err_t led_strip_output_acquire(led_strip_output_handle_t output, size_t strip_index, led_strip_color_component_t **frame)
+{
+    if (output == NULL || frame == NULL || strip_index >= output->ring_count)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    output_ring_t *ring = &output->rings[strip_index];
+    if (ring->head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) >= output->slot_count)
+    {
+        ring->stats.frames_dropped++;
+        return ESP_ERR_NOT_FINISHED;
+    }
+    ring->acquired = true;
+    *frame = ring->slots + ((ring->head % output->slot_count) * ring->frame_size);
+    return ESP_OK;
+}
+
+extern esp_err_t led_strip_output_submit(led_strip_output_handle_t output, size_t strip_index)
+{
+    if (output == NULL || strip_index >= output->ring_count)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    output_ring_t *ring = &output->rings[strip_index];
+    if (ring->acquired == false)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    ring->acquired = false;
+    ring->stats.frames_submitted++;
+    // The release store makes the frame visible to the output task before the new head.
+    __atomic_store_n(&ring->head, ring->head + 1, __ATOMIC_RELEASE);
+    xTaskNotifyGive(output->task);
+    return ESP_OK;
+}
+
+extern esp_err_t led_strip_output_get_stats(led_strip_output_handle_t output, size_t strip_index, led_strip_output_stats_t *stats)
+{
+    if (output == NULL || stats == NULL || strip_index >= output->ring_count)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *stats = output->rings[strip_index].stats;
+    return ESP_OK;
+}
+
+// Private functions
+
+static esp_err_t alloc_rings(led_strip_output_handle_t output, const led_strip_handle_t *strips)
+{
+    output->rings = (output_ring_t *)calloc(output->ring_count, sizeof(output_ring_t));
+    if (output->rings == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    for (size_t i = 0; i < output->ring_count; i++)
+    {
+        output_ring_t *ring = &output->rings[i];
+        const led_strip_handle_t strip = strips[i];
+        // The slots are transmitted directly by a led strip with an external framebuffer, so they follow its memory policy.
+        const uint32_t caps = strip->framebuffer_in_spiram ? MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT : MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA;
+        ring->strip = strip;
+        ring->own_buffer = strip->pixel_colors;
+        ring->frame_size = strip->led_count * LED_STRIP_PIXEL_STRIDE(strip);
+        ring->slots = (led_strip_color_component_t *)heap_caps_calloc(output->slot_count, ring->frame_size, caps);
+        if (ring->slots == NULL)
+        {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    return ESP_OK;
+}
+
+static void dealloc_output(led_strip_output_handle_t output)
+{
+    if (output->rings != NULL)
+    {
+        for (size_t i = 0; i < output->ring_count; i++)
+        {
+            free(output->rings[i].slots);
+        }
+        free(output->rings);
+    }
+    if (output->stopped != NULL)
+    {
+        vSemaphoreDelete(output->stopped);
+    }
+    free(output);
+}
+
+static bool start_transmissions(led_strip_output_handle_t output)
+{
+    bool started = false;
+    for (size_t i = 0; i < output->ring_count; i++)
+    {
+        output_ring_t *ring = &output->rings[i];
+        const uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+        if (head == ring->tail)
+        {
+            continue;
+        }
+        // Only the newest frame is worth sending, the older ones are coalesced into it.
+        const uint32_t newest = head - 1;
+        ring->stats.frames_coalesced += newest - ring->tail;
+        led_strip_color_component_t *frame = ring->slots + ((newest % output->slot_count) * ring->frame_size);
+        esp_err_t err = led_strip_load_frame(ring->strip, frame);
+        if (err == ESP_OK && ring->strip->external_framebuffer == false)
+        {
+            __atomic_store_n(&ring->tail, head, __ATOMIC_RELEASE); // The frame was copied, so the slots can be refilled while it is sent.
+        }
+        if (err == ESP_OK)
+        {
+            err = led_strip_start_flush(ring->strip);
+        }
+        LED_STRIP_HOT_PATH_ERROR_CHECK(err);
+        if (err != ESP_OK)
+        {
+            // The frame is given up, a retry would only hold back the newer frames the producer submits meanwhile.
+            ring->stats.frames_failed++;
+            __atomic_store_n(&ring->tail, head, __ATOMIC_RELEASE);
+            continue;
+        }
+        ring->in_flight = newest;
+        ring->transmitting = true;
+        started = true;
+    }
+    return started;
+}
+
+static void finish_transmissions(led_strip_output_handle_t output)
+{
+    for (size_t i = 0; i < output->ring_count; i++)
+    {
+        output_ring_t *ring = &output->rings[i];
+        if (ring->transmitting)
+        {
+            if (led_strip_wait_for_flush_finish(ring->strip) == ESP_OK)
+            {
+                ring->stats.frames_shown++;
+            }
+            else
+            {
+                ring->stats.frames_failed++;
+            }
+            ring->transmitting = false;
+            if (ring->strip->external_framebuffer)
+            {
+                __atomic_store_n(&ring->tail, ring->in_flight + 1, __ATOMIC_RELEASE); // The slot was sent in place, it is free only now.
+            }
+        }
+    }
+}
+
+static void output_task(void *arg)
+{
+    led_strip_output_handle_t output = (led_strip_output_handle_t)arg;
+    while (output->running)
+    {
+        if (start_transmissions(output))
+        {
+            finish_transmissions(output);
+        }
+        else
+        {
+            // A submit between the check and here leaves the notification pending, so it isn't missed.
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        }
+    }
+    xSemaphoreGive(output->stopped);
+    vTaskDelete(NULL);
+}
@@ -0,0 +1,567 @@
+/**
+ * @file led_strip_parallel.c
+ * @author Giel Willemsen
+ * @brief The parallel bus backend, sends up to 16 led strips in one I2S or LCD_CAM DMA transfer.
+ * @version 0.1 2022-09-07 Initial version
+ * @date 2022-09-07
+ *
+ * @copyright
+ * MIT License
+ *
+ * Copyright (c) 2022 Giel Willemsen
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <esp_log.h>
+#include <esp_heap_caps.h>
+#include <esp_lcd_panel_io.h>
+#include "led_strip_private.h"
+#include "led_strip_parallel.h"
+
+#define SLOTS_PER_BIT 3 ///< Clock cycles per bit: high, the bit and low.
+#define WORDS_PER_BYTE (8 * SLOTS_PER_BIT)
+#define PSRAM_TRANS_ALIGN 64
+#define SRAM_TRANS_ALIGN 4
+
+typedef struct parallel_lane
+{
+    led_strip_handle_t strip;   ///< The led strip installed on the lane, or NULL.
+    const led_strip_color_component_t *data; ///< The wire order frame of the next transfer.
+    size_t size;
+    uint32_t group_lanes;       ///< The lanes that are sent in one transfer with this one, only this lane when it isn't grouped.
+} parallel_lane_t;
+
+typedef struct led_strip_parallel_bus
+{
+    esp_lcd_i80_bus_handle_t i80_bus;
+    esp_lcd_panel_io_handle_t io;
+    led_strip_manual_timing_t led_timing;
+    int lane_gpio_nums[LED_STRIP_PARALLEL_MAX_LANES];
+    parallel_lane_t lanes[LED_STRIP_PARALLEL_MAX_LANES];
+    uint8_t lane_count;
+    uint8_t word_size;          ///< Bytes per clock cycle, 1 for 8 lanes and 2 for 16.
+    size_t max_lane_bytes;
+    size_t reset_words;         ///< The low clock cycles after the frame for the reset (latch) time.
+    uint8_t *buffer;            ///< The DMA buffer, WORDS_PER_BYTE words for every byte of the longest lane followed by the reset.
+    uint32_t pending_lanes;     ///< Lanes that were flushed and wait for the rest of their group.
+    uint32_t transmitting_lanes; ///< The lanes of the transfer in progress, read by the TX done ISR.
+    SemaphoreHandle_t lock;     ///< Guards the lanes and pending_lanes.
+    SemaphoreHandle_t idle;     ///< Taken for as long as a transfer is encoded and sent, given back by the TX done ISR.
+} led_strip_parallel_bus_t;
+
+typedef struct parallel_context
+{
+    led_strip_parallel_bus_handle_t bus;
+    uint8_t lane;
+} parallel_context_t;
+
+static esp_err_t parallel_backend_install(led_strip_handle_t handle, const led_strip_config_t *config);
+static esp_err_t parallel_backend_uninstall(led_strip_handle_t handle);
+static esp_err_t parallel_backend_transmit(led_strip_handle_t handle, const led_strip_color_component_t *data, size_t size, bool wait_tx_done);
+static esp_err_t parallel_backend_wait_tx_done(led_strip_handle_t handle, TickType_t timeout);
+static esp_err_t parallel_backend_group_install(const led_strip_handle_t *strips, size_t strip_count, void **group_context);
+static esp_err_t parallel_backend_group_uninstall(const led_strip_handle_t *strips, size_t strip_count, void *group_context);
+static bool IRAM_ATTR on_color_trans_done(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_io_event_data_t *edata, void *user_ctx);
+static esp_err_t open_bus(led_strip_parallel_bus_handle_t bus, const led_strip_parallel_bus_config_t *config, uint32_t pclk_hz);
+static void dealloc_bus(led_strip_parallel_bus_handle_t bus);
+static bool same_timing(const led_strip_manual_timing_t *a, const led_strip_manual_timing_t *b);
+static esp_err_t start_transfer(led_strip_parallel_bus_handle_t bus, uint32_t lanes, const led_strip_color_component_t *const *lane_data, const size_t *lane_sizes);
+static size_t encode_lanes(led_strip_parallel_bus_handle_t bus, uint32_t lanes, const led_strip_color_component_t *const *lane_data, const size_t *lane_sizes);
+static uint64_t transpose_8x8(uint64_t x);
+
+const led_strip_backend_t led_strip_parallel_backend = {
+    .init = NULL,
+    .install = parallel_backend_install,
+    .uninstall = parallel_backend_uninstall,
+    .transmit = parallel_backend_transmit,
+    .transmit_symbols = NULL, // Baked frames are RMT symbols, install refuses baked frame slots.
+    .wait_tx_done = parallel_backend_wait_tx_done,
+    .group_install = parallel_backend_group_install,
+    .group_uninstall = parallel_backend_group_uninstall,
+    .frame_period_us = NULL,
+    .maps_pixels = false,    // The transpose reads the staged wire order bytes of all lanes.
+    .sends_reset = true,     // Every transfer ends with reset_words low cycles.
+};
+
+extern void led_strip_parallel_bus_init_config(led_strip_parallel_bus_config_t *config)
+{
+    if (config == NULL)
+    {
+        return;
+    }
+    for (size_t i = 0; i < LED_STRIP_PARALLEL_MAX_LANES; i++)
+    {
+        config->lane_gpio_nums[i] = -1;
+    }
+    config->lane_count = 8;
+    config->clock_gpio_num = -1;
+    config->dc_gpio_num = -1;
+    config->timing_config.use_manual_timing = false;
+    config->timing_config.timing.type = LED_STRIP_TYPE_SK6822;
+    config->max_led_count = 0;
+    config->enable_w_channel = false;
+    return;
+}
+
+extern esp_err_t led_strip_parallel_bus_create(const led_strip_parallel_bus_config_t *config, led_strip_parallel_bus_handle_t *new_bus)
+{
+    if (config == NULL || new_bus == NULL || (config->lane_count != 8 && config->lane_count != 16) || config->max_led_count == 0 ||
+        config->clock_gpio_num < 0 || config->dc_gpio_num < 0)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (size_t i = 0; i < config->lane_count; i++)
+    {
+        if (config->lane_gpio_nums[i] < 0)
+        {
+            return ESP_ERR_INVALID_ARG; // The peripheral drives every data line of the bus.
+        }
+    }
+
+    led_strip_parallel_bus_handle_t bus = (led_strip_parallel_bus_handle_t)calloc(1, sizeof(led_strip_parallel_bus_t));
+    if (bus == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    bus->led_timing = led_strip_map_timing(config->timing_config);
+    bus->lane_count = config->lane_count;
+    bus->word_size = config->lane_count / 8;
+    memcpy(bus->lane_gpio_nums, config->lane_gpio_nums, sizeof(bus->lane_gpio_nums));
+    for (size_t i = 0; i < LED_STRIP_PARALLEL_MAX_LANES; i++)
+    {
+        bus->lanes[i].group_lanes = 1UL << i;
+    }
+
+    // One clock cycle is a third of the average bit period of the timing.
+    const led_strip_manual_timing_t *timing = &bus->led_timing;
+    const uint32_t bit_period_ns = (uint32_t)(((timing->low_on + timing->low_off + timing->high_on + timing->high_off) * LED_STRIP_NS_PER_TICK) / 2);
+    const uint32_t pclk_hz = (uint32_t)((SLOTS_PER_BIT * LED_STRIP_NS_PER_SECOND) / bit_period_ns);
+    bus->reset_words = (((size_t)LED_STRIP_TICKS_AS_US(timing->reset_time) * pclk_hz) / 1000000) + 1;
+    bus->max_lane_bytes = (size_t)config->max_led_count * (config->enable_w_channel ? 4 : 3);
+    const size_t buffer_size = ((bus->max_lane_bytes * WORDS_PER_BYTE) + bus->reset_words) * bus->word_size;
+
+    bus->lock = xSemaphoreCreateMutex();
+    bus->idle = xSemaphoreCreateBinary();
+    bus->buffer = (uint8_t *)heap_caps_calloc(1, buffer_size, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+    if (bus->lock == NULL || bus->idle == NULL || bus->buffer == NULL)
+    {
+        dealloc_bus(bus);
+        return ESP_ERR_NO_MEM;
+    }
+    xSemaphoreGive(bus->idle);
+
+    esp_err_t err = open_bus(bus, config, pclk_hz);
+    ESP_ERROR_CHECK_WITHOUT_ABORT(err);
+    if (err != ESP_OK)
+    {
+        dealloc_bus(bus);
+        return err;
+    }
+    *new_bus = bus;
+    return ESP_OK;
+}
+
+extern esp_err_t led_strip_parallel_bus_delete(led_strip_parallel_bus_handle_t bus)
+{
+    if (bus == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (size_t i = 0; i < bus->lane_count; i++)
+    {
+        if (bus->lanes[i].strip != NULL)
+        {
+            return ESP_ERR_INVALID_STATE;
+        }
+    }
+    dealloc_bus(bus);
+    return ESP_OK;
+}
+
+// Private functions
+
+static esp_err_t parallel_backend_install(led_strip_handle_t handle, const led_strip_config_t *config)
+{
+    led_strip_parallel_bus_handle_t bus = config->parallel_bus;
+    if (config->baked_frame_count != 0)
+    {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    else if (same_timing(&handle->led_timing, &bus->led_timing) == false)
+    {
+        return ESP_ERR_INVALID_ARG; // The timing is the clock of the whole bus.
+    }
+    else if ((size_t)config->led_count * CALC_COLOR_SIZE(handle) > bus->max_lane_bytes)
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    size_t lane = 0;
+    while (lane < bus->lane_count && bus->lane_gpio_nums[lane] != config->gpio_output_num)
+    {
+        lane++;
+    }
+    if (lane == bus->lane_count)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    parallel_context_t *context = (parallel_context_t *)calloc(1, sizeof(parallel_context_t));
+    if (context == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    context->bus = bus;
+    context->lane = (uint8_t)lane;
+
+    xSemaphoreTake(bus->lock, portMAX_DELAY);
+    const bool lane_free = bus->lanes[lane].strip == NULL;
+    if (lane_free)
+    {
+        bus->lanes[lane].strip = handle;
+    }
+    xSemaphoreGive(bus->lock);
+    if (lane_free == false)
+    {
+        free(context);
+        return ESP_ERR_INVALID_STATE;
+    }
+    handle->backend_context = context;
+    return ESP_OK;
+}
+
+static esp_err_t parallel_backend_uninstall(led_strip_handle_t handle)
+{
+    parallel_context_t *context = (parallel_context_t *)handle->backend_context;
+    led_strip_parallel_bus_handle_t bus = context->bus;
+    // A frame that waits for the rest of the group is never sent, otherwise the wait below wouldn't end.
+    xSemaphoreTake(bus->lock, portMAX_DELAY);
+    bus->pending_lanes &= ~(1UL << context->lane);
+    xSemaphoreGive(bus->lock);
+    // The TX done ISR of a transfer with this lane still reads the handle.
+    esp_err_t err = parallel_backend_wait_tx_done(handle, portMAX_DELAY);
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+    xSemaphoreTake(bus->lock, portMAX_DELAY);
+    bus->lanes[context->lane].strip = NULL;
+    bus->pending_lanes &= ~(1UL << context->lane);
+    xSemaphoreGive(bus->lock);
+    free(context);
+    handle->backend_context = NULL;
+    return ESP_OK;
+}
+
+static esp_err_t parallel_backend_transmit(led_strip_handle_t handle, const led_strip_color_component_t *data, size_t size, bool wait_tx_done)
+{
+    parallel_context_t *context = (parallel_context_t *)handle->backend_context;
+    led_strip_parallel_bus_handle_t bus = context->bus;
+    const uint32_t lane_bit = 1UL << context->lane;
+    const led_strip_color_component_t *lane_data[LED_STRIP_PARALLEL_MAX_LANES];
+    size_t lane_sizes[LED_STRIP_PARALLEL_MAX_LANES];
+    uint32_t lanes = 0;
+    esp_err_t err = ESP_OK;
+
+    xSemaphoreTake(bus->lock, portMAX_DELAY);
+    parallel_lane_t *lane = &bus->lanes[context->lane];
+    lane->data = data;
+    lane->size = size;
+    bus->pending_lanes |= lane_bit;
+    // A grouped lane waits for the rest of its group, unless the caller waits for this frame.
+    if (wait_tx_done || (bus->pending_lanes & lane->group_lanes) == lane->group_lanes)
+    {
+        if (xSemaphoreTake(bus->idle, 0) == pdTRUE)
+        {
+            lanes = bus->pending_lanes;
+            bus->pending_lanes = 0;
+            for (size_t i = 0; i < bus->lane_count; i++)
+            {
+                lane_data[i] = bus->lanes[i].data;
+                lane_sizes[i] = bus->lanes[i].size;
+            }
+        }
+        else
+        {
+            bus->pending_lanes &= ~lane_bit;
+            err = ESP_ERR_NOT_FINISHED;
+        }
+    }
+    xSemaphoreGive(bus->lock);
+    if (lanes == 0)
+    {
+        return err;
+    }
+
+    err = start_transfer(bus, lanes, lane_data, lane_sizes);
+    LED_STRIP_HOT_PATH_ERROR_CHECK(err);
+    if (err != ESP_OK || wait_tx_done == false)
+    {
+        return err;
+    }
+    return parallel_backend_wait_tx_done(handle, portMAX_DELAY);
+}
+
+static esp_err_t parallel_backend_wait_tx_done(led_strip_handle_t handle, TickType_t timeout)
+{
+    // Every lane is driven by every transfer, so a lane is busy for as long as the bus is.
+    const parallel_context_t *context = (const parallel_context_t *)handle->backend_context;
+    led_strip_parallel_bus_handle_t bus = context->bus;
+    xSemaphoreTake(bus->lock, portMAX_DELAY);
+    const bool pending = (bus->pending_lanes & (1UL << context->lane)) != 0;
+    xSemaphoreGive(bus->lock);
+    if (pending)
+    {
+        // The frame waits for the rest of the group, only their flushes can start it, so waiting here wouldn't help.
+        return ESP_ERR_TIMEOUT;
+    }
+    if (xSemaphoreTake(bus->idle, timeout) != pdTRUE)
+    {
+        return ESP_ERR_TIMEOUT;
+    }
+    xSemaphoreGive(bus->idle);
+    return ESP_OK;
+}
+
+static esp_err_t parallel_backend_group_install(const led_strip_handle_t *strips, size_t strip_count, void **group_context)
+{
+    led_strip_parallel_bus_handle_t bus = ((parallel_context_t *)strips[0]->backend_context)->bus;
+    uint32_t lanes = 0;
+    for (size_t i = 0; i < strip_count; i++)
+    {
+        const parallel_context_t *context = (const parallel_context_t *)strips[i]->backend_context;
+        if (context->bus != bus)
+        {
+            return ESP_ERR_INVALID_ARG; // Only the lanes of one bus share a transfer.
+        }
+        lanes |= 1UL << context->lane;
+    }
+    xSemaphoreTake(bus->lock, portMAX_DELAY);
+    for (size_t i = 0; i < bus->lane_count; i++)
+    {
+        if (lanes & (1UL << i))
+        {
+            bus->lanes[i].group_lanes = lanes;
+        }
+    }
+    xSemaphoreGive(bus->lock);
+    *group_context = NULL;
+    return ESP_OK;
+}
+
+static esp_err_t parallel_backend_group_uninstall(const led_strip_handle_t *strips, size_t strip_count, void *group_context)
+{
+    led_strip_parallel_bus_handle_t bus = ((parallel_context_t *)strips[0]->backend_context)->bus;
+    xSemaphoreTake(bus->lock, portMAX_DELAY);
+    for (size_t i = 0; i < strip_count; i++)
+    {
+        const uint8_t lane = ((const parallel_context_t *)strips[i]->backend_context)->lane;
+        bus->lanes[lane].group_lanes = 1UL << lane;
+        bus->pending_lanes &= ~(1UL << lane); // A frame that waited for the rest of the group is never sent.
+    }
+    xSemaphoreGive(bus->lock);
+    return ESP_OK;
+}
+
+static bool IRAM_ATTR on_color_trans_done(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_io_event_data_t *edata, void *user_ctx)
+{
+    led_strip_parallel_bus_handle_t bus = (led_strip_parallel_bus_handle_t)user_ctx;
+    BaseType_t higher_priority_task_woken = pdFALSE;
+    for (size_t i = 0; i < bus->lane_count; i++)
+    {
+        if ((bus->transmitting_lanes & (1UL << i)) && bus->lanes[i].strip != NULL)
+        {
+            led_strip_on_tx_done_from_isr(bus->lanes[i].strip, &higher_priority_task_woken);
+        }
+    }
+    xSemaphoreGiveFromISR(bus->idle, &higher_priority_task_woken);
+    return higher_priority_task_woken == pdTRUE;
+}
+
+static esp_err_t open_bus(led_strip_parallel_bus_handle_t bus, const led_strip_parallel_bus_config_t *config, uint32_t pclk_hz)
+{
+    const size_t buffer_size = ((bus->max_lane_bytes * WORDS_PER_BYTE) + bus->reset_words) * bus->word_size;
+    esp_lcd_i80_bus_config_t bus_config = {
+        .dc_gpio_num = config->dc_gpio_num,
+        .wr_gpio_num = config->clock_gpio_num,
+        .clk_src = LCD_CLK_SRC_DEFAULT,
+        .bus_width = config->lane_count,
+        .max_transfer_bytes = buffer_size,
+        .psram_trans_align = PSRAM_TRANS_ALIGN,
+        .sram_trans_align = SRAM_TRANS_ALIGN,
+    };
+    for (size_t i = 0; i < config->lane_count; i++)
+    {
+        bus_config.data_gpio_nums[i] = config->lane_gpio_nums[i];
+    }
+    esp_err_t err = esp_lcd_new_i80_bus(&bus_config, &bus->i80_bus);
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+
+    esp_lcd_panel_io_i80_config_t io_config = {
+        .cs_gpio_num = -1,
+        .pclk_hz = pclk_hz,
+        .trans_queue_depth = 1, // The buffer holds one transfer.
+        .on_color_trans_done = on_color_trans_done,
+        .user_ctx = bus,
+        .lcd_cmd_bits = 8,      // Unused, every transfer is sent without a command.
+        .lcd_param_bits = 8,
+        .dc_levels = {
+            .dc_idle_level = 0,
+            .dc_cmd_level = 0,
+            .dc_dummy_level = 0,
+            .dc_data_level = 1,
+        },
+    };
+    return esp_lcd_new_panel_io_i80(bus->i80_bus, &io_config, &bus->io);
+}
+
+static void dealloc_bus(led_strip_parallel_bus_handle_t bus)
+{
+    if (bus->io != NULL)
+    {
+        esp_lcd_panel_io_del(bus->io);
+    }
+    if (bus->i80_bus != NULL)
+    {
+        esp_lcd_del_i80_bus(bus->i80_bus);
+    }
+    if (bus->lock != NULL)
+    {
+        vSemaphoreDelete(bus->lock);
+    }
+    if (bus->idle != NULL)
+    {
+        vSemaphoreDelete(bus->idle);
+    }
+    heap_caps_free(bus->buffer);
+    free(bus);
+}
+
+static bool same_timing(const led_strip_manual_timing_t *a, const led_strip_manual_timing_t *b)
+{
+    return a->low_on == b->low_on && a->low_off == b->low_off && a->high_on == b->high_on && a->high_off == b->high_off && a->reset_time == b->reset_time;
+}
+
+static esp_err_t start_transfer(led_strip_parallel_bus_handle_t bus, uint32_t lanes, const led_strip_color_component_t *const *lane_data, const size_t *lane_sizes)
+{
+    // The idle semaphore is held, so neither the ISR nor another transfer touches the buffer.
+    const uint32_t start_cycles = led_strip_stats_cycle_count();
+    const size_t size = encode_lanes(bus, lanes, lane_data, lane_sizes);
+    for (size_t i = 0; i < bus->lane_count; i++)
+    {
+        if (lanes & (1UL << i))
+        {
+            // Every lane of the transfer is charged the whole transpose, it is one pass over all of them.
+            led_strip_stats_record_translation(bus->lanes[i].strip, lane_sizes[i], start_cycles);
+        }
+    }
+    bus->transmitting_lanes = lanes;
+    esp_err_t err = esp_lcd_panel_io_tx_color(bus->io, -1, bus->buffer, size);
+    if (err != ESP_OK)
+    {
+        bus->transmitting_lanes = 0;
+        xSemaphoreGive(bus->idle);
+    }
+    return err;
+}
+
+static size_t encode_lanes(led_strip_parallel_bus_handle_t bus, uint32_t lanes, const led_strip_color_component_t *const *lane_data, const size_t *lane_sizes)
+{
+    uint8_t lane_indices[LED_STRIP_PARALLEL_MAX_LANES];
+    size_t lane_count = 0;
+    size_t frame_bytes = 0;
+    for (size_t i = 0; i < bus->lane_count; i++)
+    {
+        if (lanes & (1UL << i))
+        {
+            lane_indices[lane_count++] = (uint8_t)i;
+            frame_bytes = lane_sizes[i] > frame_bytes ? lane_sizes[i] : frame_bytes;
+        }
+    }
+
+    uint8_t *words8 = bus->buffer;
+    uint16_t *words16 = (uint16_t *)bus->buffer;
+    size_t word = 0;
+    for (size_t i = 0; i < frame_bytes; i++)
+    {
+        // Byte i of lane n goes to byte n % 8 of low or high, the transpose turns that into one byte per bit with a bit per lane.
+        uint64_t low = 0;
+        uint64_t high = 0;
+        uint32_t active = 0; ///< The lanes that are still sending, the others stay low.
+        for (size_t j = 0; j < lane_count; j++)
+        {
+            const uint8_t lane = lane_indices[j];
+            if (i < lane_sizes[lane])
+            {
+                const uint64_t value = lane_data[lane][i];
+                active |= 1UL << lane;
+                if (lane < 8)
+                {
+                    low |= value << (lane * 8);
+                }
+                else
+                {
+                    high |= value << ((lane - 8) * 8);
+                }
+            }
+        }
+        low = transpose_8x8(low);
+        high = transpose_8x8(high);
+        for (int bit = 7; bit >= 0; bit--)
+        {
+            const uint32_t bits = (uint32_t)((low >> (bit * 8)) & 0xFF) | ((uint32_t)((high >> (bit * 8)) & 0xFF) << 8);
+            if (bus->word_size == 1)
+            {
+                words8[word] = (uint8_t)active;
+                words8[word + 1] = (uint8_t)bits;
+                words8[word + 2] = 0;
+            }
+            else
+            {
+                words16[word] = (uint16_t)active;
+                words16[word + 1] = (uint16_t)bits;
+                words16[word + 2] = 0;
+            }
+            word += SLOTS_PER_BIT;
+        }
+    }
+    // A longer earlier frame may have left data where the reset goes now.
+    memset(bus->buffer + (word * bus->word_size), 0, bus->reset_words * bus->word_size);
+    return (word + bus->reset_words) * bus->word_size;
+}
+
+static uint64_t transpose_8x8(uint64_t x)
+{
+    // Swaps the 8x8 bit matrix over its diagonal, so bit c of byte r becomes bit r of byte c.
+    uint64_t t = (x ^ (x >> 7)) & 0x00AA00AA00AA00AAULL;
+    x = x ^ t ^ (t << 7);
+    t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCULL;
+    x = x ^ t ^ (t << 14);
+    t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ULL;
+    x = x ^ t ^ (t << 28);
+    return x;
+}
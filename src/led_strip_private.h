@@ -0,0 +1,417 @@
+/**
+ * @file led_strip_private.h
+ * @author Giel Willemsen
+ * @brief The internal definitions shared between the led strip core and its transmission backends.
+ * @version 0.1 2022-09-07 Initial version
+ * @date 2022-09-07
+ *
+ * @copyright
+ * MIT License
+ *
+ * Copyright (c) 2022 Giel Willemsen
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#pragma once
+#ifndef LED_STRIP_PRIVATE_H_
+#define LED_STRIP_PRIVATE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <esp_err.h>
+#include <esp_attr.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/event_groups.h>
+#include <freertos/semphr.h>
+#if CONFIG_LED_STRIP_ENABLE_STATS
+#include <esp_cpu.h>
+#include <esp_idf_version.h>
+#endif
+#include "sdkconfig.h"
+#include "led_strip.h"
+
+// Macros
+#if CONFIG_LED_STRIP_FIXED_COLOR_ORDER_RGB || CONFIG_LED_STRIP_FIXED_COLOR_ORDER_GRB || CONFIG_LED_STRIP_FIXED_COLOR_ORDER_RGBW || CONFIG_LED_STRIP_FIXED_COLOR_ORDER_GRBW
+#define LED_STRIP_FIXED_COLOR_ORDER 1
+#if CONFIG_LED_STRIP_FIXED_COLOR_ORDER_RGBW || CONFIG_LED_STRIP_FIXED_COLOR_ORDER_GRBW
+#define LED_STRIP_FIXED_W_CHANNEL 1
+#else
+#define LED_STRIP_FIXED_W_CHANNEL 0
+#endif
+#if CONFIG_LED_STRIP_FIXED_COLOR_ORDER_GRB || CONFIG_LED_STRIP_FIXED_COLOR_ORDER_GRBW
+#define LED_STRIP_FIXED_ORDER LED_STRIP_COLOR_ORDER_GRBW
+#define LED_STRIP_FIXED_OFFSETS {.r = 2, .g = 0, .b = 1, .w = 3} ///< Must match map_color_offsets.
+#else
+#define LED_STRIP_FIXED_ORDER LED_STRIP_COLOR_ORDER_RGBW
+#define LED_STRIP_FIXED_OFFSETS {.r = 0, .g = 2, .b = 1, .w = 3} ///< Must match map_color_offsets.
+#endif
+#define LED_STRIP_HAS_W_CHANNEL(handle) (LED_STRIP_FIXED_W_CHANNEL != 0)
+// A fixed color order also fixes the pixel format to LED_STRIP_PIXEL_FORMAT_WIRE, so the layout is all constants.
+#define LED_STRIP_COLOR_OFFSETS(handle) ((const color_offsets_t)LED_STRIP_FIXED_OFFSETS)
+#define LED_STRIP_PIXEL_STRIDE(handle) CALC_COLOR_SIZE(handle) ///< The bytes per pixel in pixel_colors.
+#else
+#define LED_STRIP_FIXED_COLOR_ORDER 0
+#define LED_STRIP_HAS_W_CHANNEL(handle) ((handle)->enable_w_channel)
+#define LED_STRIP_COLOR_OFFSETS(handle) ((handle)->color_offsets)
+#define LED_STRIP_PIXEL_STRIDE(handle) ((handle)->pixel_stride) ///< The bytes per pixel in pixel_colors.
+#endif
+#define CALC_COLOR_SIZE(handle) (LED_STRIP_HAS_W_CHANNEL(handle) ? 4 : 3) ///< The bytes that are sent per pixel.
+#define LED_STRIP_CANONICAL_OFFSETS {.r = 0, .g = 1, .b = 2, .w = 3} ///< The offsets for LED_STRIP_PIXEL_FORMAT_RGB24 and LED_STRIP_PIXEL_FORMAT_RGBA32.
+
+#if CONFIG_LED_STRIP_FIXED_TIMING_SK6822 || CONFIG_LED_STRIP_FIXED_TIMING_WS281X
+#define LED_STRIP_FIXED_TIMING 1
+#if CONFIG_LED_STRIP_FIXED_TIMING_WS281X
+#define LED_STRIP_FIXED_TYPE LED_STRIP_TYPE_WS281x
+#else
+#define LED_STRIP_FIXED_TYPE LED_STRIP_TYPE_SK6822
+#endif
+#else
+#define LED_STRIP_FIXED_TIMING 0
+#endif
+#define BIT_SET(val, bit) (((val) & (1UL << (bit))) == (1UL << (bit)))
+#define DIV_255(x) ((((x) + 128) + (((x) + 128) >> 8)) >> 8) ///< Rounded division by 255 without a divide.
+
+/// Logs an error of the flush and poll paths, but not the ESP_ERR_TIMEOUT and ESP_ERR_NOT_FINISHED of a transmission that isn't done.
+#if CONFIG_LED_STRIP_HOT_PATH_ERROR_LOG
+#define LED_STRIP_HOT_PATH_ERROR_CHECK(x) do {                                  \
+        const esp_err_t hot_path_err = (x);                                     \
+        if (hot_path_err != ESP_ERR_TIMEOUT && hot_path_err != ESP_ERR_NOT_FINISHED) \
+        {                                                                       \
+            ESP_ERROR_CHECK_WITHOUT_ABORT(hot_path_err);                        \
+        }                                                                       \
+    } while (0)
+#else
+#define LED_STRIP_HOT_PATH_ERROR_CHECK(x) ((void)(x))
+#endif
+
+#if CONFIG_LED_STRIP_SYMBOL_LUT_FULL
+#define SYMBOL_LUT_BITS 8
+#else
+#define SYMBOL_LUT_BITS 4
+#endif
+#define SYMBOL_LUT_ENTRIES (1 << SYMBOL_LUT_BITS)
+#define SYMBOL_LUT_SIZE (SYMBOL_LUT_ENTRIES * SYMBOL_LUT_BITS)
+
+/// Packs a symbol in the layout that both rmt_item32_t and rmt_symbol_word_t use.
+#define LED_STRIP_SYMBOL(level0, duration0, level1, duration1) \
+    ((uint32_t)((duration0) & 0x7FFF) | ((uint32_t)((level0) & 0x1) << 15) | ((uint32_t)((duration1) & 0x7FFF) << 16) | ((uint32_t)((level1) & 0x1) << 31))
+
+#define NO_BAKED_FRAME (-1)
+
+/// The symbol table is shared and constant when nothing is folded into it, which is only with a fixed timing and the nibble table.
+#define LED_STRIP_CONST_SYMBOL_LUT (LED_STRIP_FIXED_TIMING && !CONFIG_LED_STRIP_SYMBOL_LUT_FULL)
+
+// Structs
+typedef struct color_offsets
+{
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+    uint8_t w;
+} color_offsets_t;
+
+typedef struct white_extraction
+{
+    uint32_t scale[3]; ///< 16.16 factor from the r, g and b component to the white level that component allows.
+    uint32_t bias[3];  ///< 255 for a component that the W LED doesn't emit, so it never limits the white level.
+    uint8_t point[3];  ///< The color of the W LED, derived from led_strip_config_t.white_point.
+    bool enabled;      ///< False if the white point is black, then no white is extracted.
+} white_extraction_t;
+
+typedef struct led_strip_backend
+{
+    void (*init)(void);                                                                        ///< Called once by led_strip_init, may be NULL.
+    esp_err_t (*install)(led_strip_handle_t handle, const led_strip_config_t *config);         ///< Claim and configure the hardware for a new led strip.
+    esp_err_t (*uninstall)(led_strip_handle_t handle);                                         ///< Release everything install claimed.
+    esp_err_t (*transmit)(led_strip_handle_t handle, const led_strip_color_component_t *data, size_t size, bool wait_tx_done); ///< Send pixel data.
+    esp_err_t (*transmit_symbols)(led_strip_handle_t handle, const uint32_t *symbols, size_t count, bool wait_tx_done);        ///< Send pre-encoded symbols.
+    esp_err_t (*wait_tx_done)(led_strip_handle_t handle, TickType_t timeout);                  ///< ESP_ERR_TIMEOUT if the transmission isn't done in time.
+    esp_err_t (*group_install)(const led_strip_handle_t *strips, size_t strip_count, void **group_context); ///< Make the strips start transmitting together.
+    esp_err_t (*group_uninstall)(const led_strip_handle_t *strips, size_t strip_count, void *group_context);
+    uint32_t (*frame_period_us)(led_strip_handle_t handle); ///< The time to send a whole frame, NULL to derive it from the bit timing.
+    bool maps_pixels; ///< The translator applies the brightness, gamma and swizzle itself, otherwise the core stages the mapped pixels first.
+    bool sends_reset; ///< Every transmission ends with the reset (latch) time, otherwise the core waits it out before the next one.
+} led_strip_backend_t;
+
+typedef struct led_strip_scheduler led_strip_scheduler_t;
+
+typedef struct led_strip
+{
+    const led_strip_backend_t *backend;
+    void *backend_context; ///< Owned by the backend.
+    led_strip_manual_timing_t led_timing;
+    led_strip_color_order_t color_order;
+    led_strip_pixel_format_t pixel_format;
+    color_offsets_t color_offsets; ///< Offsets of the color components within a pixel of pixel_colors, derived from color_order and pixel_format.
+    uint8_t pixel_stride; ///< The bytes per pixel in pixel_colors, use LED_STRIP_PIXEL_STRIDE.
+    uint8_t swizzle[4]; ///< For every sent byte of a pixel the offset within the pixel of pixel_colors that it is read from.
+    bool swizzled; ///< swizzle isn't the identity or the pixel stride differs from the sent bytes per pixel.
+    white_extraction_t white; ///< How RGB colors are converted for the W channel.
+    led_strip_pixel_index_t *remap; ///< The physical pixel for every logical pixel index, or NULL when they are the same.
+    led_strip_color_component_t *pixel_colors; ///< The buffer that the set and fill functions write to.
+    led_strip_color_component_t *front_pixel_colors; ///< The buffer that is being transmitted when double buffered, otherwise NULL.
+    uint32_t *symbol_lut; ///< Precomputed RMT symbols, SYMBOL_LUT_BITS symbols for each of the SYMBOL_LUT_ENTRIES values. NULL with LED_STRIP_CONST_SYMBOL_LUT. The translators read it in the RMT ISR, which may run while the flash cache and so PSRAM are disabled, so it and everything else the ISR reads is in internal RAM.
+    uint8_t brightness;
+    uint8_t *gamma_table; ///< Copy of the table given to led_strip_set_gamma_table, or NULL.
+    uint8_t *level_lut; ///< Gamma and brightness combined into one output level per input level. In internal RAM for the legacy RMT translator, the other backends only read it while the core stages the frame.
+    led_strip_color_component_t *stage_buffer; ///< The leveled pixels in wire order, or the copy of a PSRAM frame, for backends that don't map the pixels themselves. In internal RAM, allocated on first use.
+    bool apply_levels; ///< level_lut has to be applied, false when the brightness and gamma are neutral.
+    bool levels_changed; ///< The brightness or gamma changed, level_lut is rebuilt before the next transmission.
+    uint32_t **baked_frames; ///< The encoded frames per slot, a slot is NULL until it is baked.
+    uint8_t baked_frame_count;
+    int live_baked_frame; ///< The slot that holds the current content of pixel_colors, or NO_BAKED_FRAME.
+    int transmitting_baked_frame; ///< The slot used by the last transmission, or NO_BAKED_FRAME.
+    uint16_t *dither_pixels; ///< The 16 bit framebuffer in the layout of pixel_colors when dithering, otherwise NULL.
+    uint8_t *dither_error; ///< The accumulated quantization error for every component of dither_pixels.
+    TaskHandle_t refresh_task; ///< The task started by led_strip_start_refresh, or NULL.
+    SemaphoreHandle_t refresh_stopped; ///< Given by the refresh task right before it deletes itself.
+    volatile bool refresh_running;
+    led_strip_scheduler_t *scheduler; ///< Started by led_strip_start_scheduler, or NULL.
+    uint32_t latch_time_us; ///< The idle time before the next transmission may start, 0 if the backend sends the reset itself.
+    int64_t tx_done_time; ///< The esp_timer time at which the last transmission was done.
+    led_strip_pixel_index_t led_count;
+    led_strip_pixel_index_t dirty_end; ///< One past the highest pixel of pixel_colors that differs from what the LEDs show.
+    bool enable_partial_flush;
+    bool framebuffer_in_spiram; ///< pixel_colors and front_pixel_colors are allocated in PSRAM.
+    bool baked_frames_in_spiram;
+    bool external_framebuffer; ///< pixel_colors is owned by the caller, see led_strip_attach_buffer.
+    bool iram_safe; ///< Installed with ESP_INTR_FLAG_IRAM, everything the interrupt reads has to be in internal RAM.
+    EventGroupHandle_t group_events; ///< The event group of the led_strip_group_t this strip belongs to, or NULL.
+    EventBits_t group_bit; ///< The bit that is set in group_events when a transmission of this strip is done.
+    led_strip_flush_done_cb_t flush_done_callback; ///< Called from the TX done ISR, or NULL.
+    void *flush_done_user_ctx;
+    TaskHandle_t notify_task; ///< Notified from the TX done ISR, or NULL.
+    uint32_t notify_bits;
+#if CONFIG_LED_STRIP_ENABLE_STATS
+    led_strip_stats_t stats;
+    portMUX_TYPE stats_lock; ///< Guards the statistics, they are updated from the translator, the TX done ISR and the flushing task.
+    uint32_t frame_translator_calls; ///< Translator invocations of the frame that is being transmitted.
+    uint32_t frame_translator_cycles; ///< CPU cycles spent in the translator for the frame that is being transmitted.
+    int64_t flush_start_time; ///< The esp_timer time at which the frame that is being transmitted was started.
+#endif
+    bool enable_w_channel;
+    bool has_flushed;
+} led_strip_t;
+
+// Backends
+extern const led_strip_backend_t led_strip_rmt_backend;
+extern const led_strip_backend_t led_strip_spi_backend;
+#if CONFIG_LED_STRIP_ENABLE_PARALLEL
+extern const led_strip_backend_t led_strip_parallel_backend;
+#endif
+
+#if LED_STRIP_CONST_SYMBOL_LUT
+extern const uint32_t led_strip_fixed_symbol_lut[SYMBOL_LUT_SIZE]; ///< The symbol table of the fixed timing, shared by all led strips. In DRAM like symbol_lut.
+#endif
+
+// Shared functions
+
+/**
+ * @brief Must be called by the backends from their ISR every time a transmission of the led strip is done.
+ * 
+ * @param handle The led strip that finished transmitting.
+ * @param higher_priority_task_woken Set to pdTRUE if a higher priority task was woken, never set to pdFALSE.
+ */
+extern void led_strip_on_tx_done_from_isr(led_strip_handle_t handle, BaseType_t *higher_priority_task_woken);
+
+/**
+ * @brief Maps a logical pixel index, as given to the public functions, to the pixel in the buffers.
+ * 
+ * @param handle The led strip the index is for.
+ * @param index The logical index, must be smaller than the led count.
+ * @return led_strip_pixel_index_t The physical index.
+ */
+FORCE_INLINE_ATTR led_strip_pixel_index_t led_strip_physical_index(const led_strip_t *handle, led_strip_pixel_index_t index)
+{
+    return handle->remap != NULL ? handle->remap[index] : index;
+}
+
+/**
+ * @brief Calls a function on the given core and waits for it, used by the backends to allocate their interrupt on that core.
+ * 
+ * @param core_id The core to run the function on, tskNO_AFFINITY runs it on the calling core.
+ * @param function The function to run.
+ * @param arg The argument for the function.
+ * @return esp_err_t The success code for running the function, ESP_ERR_INVALID_ARG for a core that doesn't exist.
+ */
+extern esp_err_t led_strip_run_on_core(BaseType_t core_id, void (*function)(void *arg), void *arg);
+
+/**
+ * @brief Makes a whole frame the content of the framebuffer for the next flush. It is attached with an external
+ * framebuffer and copied otherwise.
+ * 
+ * @param handle The led strip to load the frame into.
+ * @param frame led_count pixels in the layout of pixel_colors.
+ * @return esp_err_t The success code for loading the frame, ESP_ERR_NOT_FINISHED if the framebuffer is still being transmitted.
+ */
+extern esp_err_t led_strip_load_frame(led_strip_handle_t handle, led_strip_color_component_t *frame);
+
+/**
+ * @brief Records that pixels of pixel_colors were written, which invalidates the live baked frame and grows the dirty range.
+ * 
+ * @param handle The led strip that was written to.
+ * @param end One past the highest physical pixel that was written.
+ */
+extern void led_strip_mark_pixels_changed(led_strip_handle_t handle, size_t end);
+
+/**
+ * @brief Converts a color to what the led strip can show, without a W channel the W component is dropped and R, G and B are kept as they are.
+ * This is the conversion led_strip_set_pixel_rgbw does.
+ * 
+ * @param handle The led strip the color is for.
+ * @param color The color to convert.
+ * @return led_strip_color_t The converted color.
+ */
+extern led_strip_color_t led_strip_map_color(const led_strip_t *handle, led_strip_color_t color);
+
+/**
+ * @brief Resolves a timing config to the bit timing it stands for, as led_strip_install does.
+ * 
+ * @param config The timing config to resolve.
+ * @return led_strip_manual_timing_t The bit timing.
+ */
+extern led_strip_manual_timing_t led_strip_map_timing(led_strip_timing_config_t config);
+
+/**
+ * @brief Quantizes the 16 bit dithering framebuffer into pixel_colors for the next sub-frame. The brightness and gamma are applied
+ * to the 16 bit values here, the translator doesn't level the result again.
+ * 
+ * @param handle The led strip to dither, must have enable_dithering configured and may not be transmitting pixel_colors.
+ */
+extern void led_strip_dither_frame(led_strip_handle_t handle);
+
+/**
+ * @brief Reads the CPU cycle counter as start point for led_strip_stats_record_translation, always 0 when the statistics are disabled.
+ * 
+ * @return uint32_t The current CPU cycle count.
+ */
+FORCE_INLINE_ATTR uint32_t led_strip_stats_cycle_count(void)
+{
+#if CONFIG_LED_STRIP_ENABLE_STATS
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+    return (uint32_t)esp_cpu_get_cycle_count();
+#else
+    return esp_cpu_get_ccount();
+#endif
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @brief Records one translator invocation in the statistics of the led strip, compiles to nothing when the statistics are disabled.
+ * Must be called by the translators of the backends, from ISR or task context.
+ * 
+ * @param handle The led strip that was translated for.
+ * @param bytes The number of pixel bytes that were translated.
+ * @param start_cycles The result of led_strip_stats_cycle_count at the start of the invocation.
+ */
+FORCE_INLINE_ATTR void led_strip_stats_record_translation(led_strip_handle_t handle, size_t bytes, uint32_t start_cycles)
+{
+#if CONFIG_LED_STRIP_ENABLE_STATS
+    const uint32_t cycles = led_strip_stats_cycle_count() - start_cycles;
+    portENTER_CRITICAL_SAFE(&handle->stats_lock);
+    handle->stats.translator_calls++;
+    handle->stats.translator_cycles += cycles;
+    handle->stats.bytes_translated += bytes;
+    if (cycles > handle->stats.max_translator_call_cycles)
+    {
+        handle->stats.max_translator_call_cycles = cycles;
+    }
+    handle->frame_translator_calls++;
+    handle->frame_translator_cycles += cycles;
+    portEXIT_CRITICAL_SAFE(&handle->stats_lock);
+#endif
+}
+
+/**
+ * @brief Returns the level table that a translator has to map every byte through before calling led_strip_translate_byte.
+ * With the full symbol table the levels are folded into the symbol table itself, then this is always NULL.
+ * 
+ * @param handle The led strip that is translated for.
+ * @return const uint8_t* The level table, or NULL if the bytes can be translated as they are.
+ */
+FORCE_INLINE_ATTR const uint8_t *led_strip_translator_levels(const led_strip_t *handle)
+{
+#if CONFIG_LED_STRIP_SYMBOL_LUT_FULL
+    return NULL;
+#else
+    return handle->apply_levels ? handle->level_lut : NULL;
+#endif
+}
+
+/**
+ * @brief Returns the swizzle that a translator reads the bytes of a pixel with, a pixel of LED_STRIP_PIXEL_STRIDE bytes is then
+ * sent as CALC_COLOR_SIZE bytes.
+ * 
+ * @param handle The led strip that is translated for.
+ * @return const uint8_t* The swizzle, or NULL if pixel_colors is in wire order already and can be translated byte by byte.
+ */
+FORCE_INLINE_ATTR const uint8_t *led_strip_translator_swizzle(const led_strip_t *handle)
+{
+    return handle->swizzled ? handle->swizzle : NULL;
+}
+
+/**
+ * @brief Returns the symbol table that a translator passes to led_strip_translate_byte.
+ * 
+ * @param handle The led strip that is translated for.
+ * @return const uint32_t* The symbol table, a constant address with LED_STRIP_CONST_SYMBOL_LUT.
+ */
+FORCE_INLINE_ATTR const uint32_t *led_strip_symbol_lut(const led_strip_t *handle)
+{
+#if LED_STRIP_CONST_SYMBOL_LUT
+    (void)handle;
+    return led_strip_fixed_symbol_lut;
+#else
+    return handle->symbol_lut;
+#endif
+}
+
+/**
+ * @brief Writes the 8 RMT symbols for a byte (MSB first) by copying them from the symbol lookup table.
+ * Always inlined so it ends up in IRAM together with the translator that calls it.
+ * 
+ * @param symbols The destination for the 8 symbols.
+ * @param data The byte to translate.
+ * @param symbol_lut The lookup table of the led strip.
+ */
+FORCE_INLINE_ATTR void led_strip_translate_byte(uint32_t *symbols, uint8_t data, const uint32_t *symbol_lut)
+{
+#if CONFIG_LED_STRIP_SYMBOL_LUT_FULL
+    const uint32_t *byte_symbols = symbol_lut + (data * SYMBOL_LUT_BITS);
+    for (int i = 0; i < 8; i++)
+    {
+        symbols[i] = byte_symbols[i];
+    }
+#else
+    const uint32_t *high_symbols = symbol_lut + ((data >> 4) * SYMBOL_LUT_BITS);
+    const uint32_t *low_symbols = symbol_lut + ((data & 0x0F) * SYMBOL_LUT_BITS);
+    for (int i = 0; i < 4; i++)
+    {
+        symbols[i] = high_symbols[i];
+        symbols[i + 4] = low_symbols[i];
+    }
+#endif
+}
+
+#endif // LED_STRIP_PRIVATE_H_
@@ -0,0 +1,468 @@
+/**
+ * @file led_strip_rmt.c
+ * @author Giel Willemsen
+ * @brief The led strip backend for the ESP-IDF 5.x RMT TX channel and encoder driver.
+ * @version 0.1 2022-09-07 Initial version
+ * @date 2022-09-07
+ *
+ * @copyright
+ * MIT License
+ *
+ * Copyright (c) 2022 Giel Willemsen
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <esp_log.h>
+#include <esp_heap_caps.h>
+#include <esp_intr_alloc.h>
+#include <esp_idf_version.h>
+#include <soc/soc_caps.h>
+#include <driver/rmt_tx.h>
+#include <driver/rmt_encoder.h>
+#include "led_strip_private.h"
+
+#define RMT_RESOLUTION_HZ (APB_CLK_FREQ / LED_STRIP_CLOCK_DIVIDER)
+#define RMT_DMA_SYMBOLS_PER_BLOCK 256
+
+/**
+ * @brief Sends the data with a sub encoder followed by the reset (latch) pulse.
+ * The sub encoder is a bytes encoder for pixel data or a copy encoder for baked symbols.
+ */
+typedef struct rmt_led_strip_encoder
+{
+    rmt_encoder_t base;
+    rmt_encoder_handle_t data_encoder;
+    rmt_encoder_handle_t reset_encoder;
+    led_strip_handle_t stats_handle; ///< The led strip to record translator statistics for, NULL for the baked symbol encoder.
+    int state;
+    rmt_symbol_word_t reset_code;
+} rmt_led_strip_encoder_t;
+
+typedef struct rmt_group_context
+{
+    rmt_sync_manager_handle_t sync_manager;
+} rmt_group_context_t;
+
+typedef struct new_channel_args
+{
+    const rmt_tx_channel_config_t *config;
+    rmt_channel_handle_t channel;
+    esp_err_t result;
+} new_channel_args_t;
+
+typedef struct rmt_context
+{
+    rmt_channel_handle_t channel;
+    rmt_encoder_handle_t pixel_encoder;  ///< Translates pixel bytes to symbols.
+    rmt_encoder_handle_t symbol_encoder; ///< Copies baked symbols.
+} rmt_context_t;
+
+static esp_err_t rmt_backend_install(led_strip_handle_t handle, const led_strip_config_t *config);
+static esp_err_t rmt_backend_uninstall(led_strip_handle_t handle);
+static esp_err_t rmt_backend_transmit(led_strip_handle_t handle, const led_strip_color_component_t *data, size_t size, bool wait_tx_done);
+static esp_err_t rmt_backend_transmit_symbols(led_strip_handle_t handle, const uint32_t *symbols, size_t count, bool wait_tx_done);
+static esp_err_t rmt_backend_wait_tx_done(led_strip_handle_t handle, TickType_t timeout);
+static esp_err_t rmt_backend_group_install(const led_strip_handle_t *strips, size_t strip_count, void **group_context);
+static esp_err_t rmt_backend_group_uninstall(const led_strip_handle_t *strips, size_t strip_count, void *group_context);
+static bool IRAM_ATTR on_trans_done(rmt_channel_handle_t channel, const rmt_tx_done_event_data_t *event_data, void *user_ctx);
+static void release_context(rmt_context_t *context);
+static void new_channel(void *arg);
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 2, 0)
+static int map_intr_priority(int intr_flags);
+#endif
+static esp_err_t new_led_strip_encoder(led_strip_handle_t handle, bool copy_symbols, rmt_encoder_handle_t *ret_encoder);
+static size_t IRAM_ATTR encode_led_strip(rmt_encoder_t *encoder, rmt_channel_handle_t channel, const void *primary_data, size_t data_size, rmt_encode_state_t *ret_state);
+static esp_err_t reset_led_strip_encoder(rmt_encoder_t *encoder);
+static esp_err_t del_led_strip_encoder(rmt_encoder_t *encoder);
+
+const led_strip_backend_t led_strip_rmt_backend = {
+    .init = NULL,
+    .install = rmt_backend_install,
+    .uninstall = rmt_backend_uninstall,
+    .transmit = rmt_backend_transmit,
+    .transmit_symbols = rmt_backend_transmit_symbols,
+    .wait_tx_done = rmt_backend_wait_tx_done,
+    .group_install = rmt_backend_group_install,
+    .group_uninstall = rmt_backend_group_uninstall,
+    .frame_period_us = NULL,
+    .maps_pixels = false,    // The bytes encoder can't map the data, the core stages the mapped pixels.
+    .sends_reset = true,     // The encoder appends the reset code.
+};
+
+static esp_err_t rmt_backend_install(led_strip_handle_t handle, const led_strip_config_t *config)
+{
+    if (config->mem_block_num == 0)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+#if !SOC_RMT_SUPPORT_DMA
+    if (config->with_dma)
+    {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+#endif
+#if !CONFIG_RMT_ISR_IRAM_SAFE
+    if (config->intr_flags & ESP_INTR_FLAG_IRAM)
+    {
+        return ESP_ERR_NOT_SUPPORTED; // The driver decides this at build time, with CONFIG_RMT_ISR_IRAM_SAFE.
+    }
+#endif
+    rmt_context_t *context = (rmt_context_t *)calloc(1, sizeof(rmt_context_t));
+    if (context == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+
+    rmt_tx_channel_config_t channel_config = {
+        .gpio_num = config->gpio_output_num,
+        .clk_src = RMT_CLK_SRC_DEFAULT,
+        .resolution_hz = RMT_RESOLUTION_HZ,
+        // With DMA the memory only bounds the DMA buffer, so it can be made a lot larger than the channel memory.
+        .mem_block_symbols = config->mem_block_num * (config->with_dma ? RMT_DMA_SYMBOLS_PER_BLOCK : SOC_RMT_MEM_WORDS_PER_CHANNEL),
+        .trans_queue_depth = 1, // A flush waits for the previous one, the single framebuffer can't be queued twice.
+        .flags.with_dma = config->with_dma,
+    };
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 2, 0)
+    channel_config.intr_priority = map_intr_priority(config->intr_flags);
+#endif
+    new_channel_args_t channel_args = {
+        .config = &channel_config,
+        .channel = NULL,
+        .result = ESP_FAIL,
+    };
+    // The driver allocates the interrupt of the channel on the core that creates it.
+    esp_err_t err = led_strip_run_on_core(config->intr_core, new_channel, &channel_args);
+    if (err == ESP_OK)
+    {
+        err = channel_args.result;
+        context->channel = channel_args.channel;
+    }
+    ESP_ERROR_CHECK_WITHOUT_ABORT(err);
+    if (err != ESP_OK)
+    {
+        release_context(context);
+        return err;
+    }
+
+    err = new_led_strip_encoder(handle, false, &context->pixel_encoder);
+    ESP_ERROR_CHECK_WITHOUT_ABORT(err);
+    if (err != ESP_OK)
+    {
+        release_context(context);
+        return err;
+    }
+
+    err = new_led_strip_encoder(handle, true, &context->symbol_encoder);
+    ESP_ERROR_CHECK_WITHOUT_ABORT(err);
+    if (err != ESP_OK)
+    {
+        release_context(context);
+        return err;
+    }
+
+    // Callbacks can only be registered while the channel is still disabled.
+    const rmt_tx_event_callbacks_t callbacks = {
+        .on_trans_done = on_trans_done,
+    };
+    err = rmt_tx_register_event_callbacks(context->channel, &callbacks, handle);
+    ESP_ERROR_CHECK_WITHOUT_ABORT(err);
+    if (err != ESP_OK)
+    {
+        release_context(context);
+        return err;
+    }
+
+    err = rmt_enable(context->channel);
+    ESP_ERROR_CHECK_WITHOUT_ABORT(err);
+    if (err != ESP_OK)
+    {
+        release_context(context);
+        return err;
+    }
+
+    handle->backend_context = context;
+    return ESP_OK;
+}
+
+static esp_err_t rmt_backend_uninstall(led_strip_handle_t handle)
+{
+    rmt_context_t *context = (rmt_context_t *)handle->backend_context;
+    esp_err_t err = rmt_disable(context->channel);
+    ESP_ERROR_CHECK_WITHOUT_ABORT(err);
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+    release_context(context);
+    handle->backend_context = NULL;
+    return ESP_OK;
+}
+
+static esp_err_t rmt_backend_transmit(led_strip_handle_t handle, const led_strip_color_component_t *data, size_t size, bool wait_tx_done)
+{
+    rmt_context_t *context = (rmt_context_t *)handle->backend_context;
+    const rmt_transmit_config_t transmit_config = {
+        .loop_count = 0,
+    };
+    esp_err_t err = rmt_transmit(context->channel, context->pixel_encoder, data, size, &transmit_config);
+    LED_STRIP_HOT_PATH_ERROR_CHECK(err);
+    if (err != ESP_OK || wait_tx_done == false)
+    {
+        return err;
+    }
+    return rmt_backend_wait_tx_done(handle, portMAX_DELAY);
+}
+
+static esp_err_t rmt_backend_transmit_symbols(led_strip_handle_t handle, const uint32_t *symbols, size_t count, bool wait_tx_done)
+{
+    rmt_context_t *context = (rmt_context_t *)handle->backend_context;
+    const rmt_transmit_config_t transmit_config = {
+        .loop_count = 0,
+    };
+    // The symbols are packed in the rmt_symbol_word_t layout, see LED_STRIP_SYMBOL.
+    esp_err_t err = rmt_transmit(context->channel, context->symbol_encoder, symbols, count * sizeof(uint32_t), &transmit_config);
+    LED_STRIP_HOT_PATH_ERROR_CHECK(err);
+    if (err != ESP_OK || wait_tx_done == false)
+    {
+        return err;
+    }
+    return rmt_backend_wait_tx_done(handle, portMAX_DELAY);
+}
+
+static esp_err_t rmt_backend_wait_tx_done(led_strip_handle_t handle, TickType_t timeout)
+{
+    rmt_context_t *context = (rmt_context_t *)handle->backend_context;
+    const int timeout_ms = (timeout == portMAX_DELAY) ? -1 : (int)pdTICKS_TO_MS(timeout);
+    return rmt_tx_wait_all_done(context->channel, timeout_ms);
+}
+
+static esp_err_t rmt_backend_group_install(const led_strip_handle_t *strips, size_t strip_count, void **group_context)
+{
+    rmt_group_context_t *context = (rmt_group_context_t *)calloc(1, sizeof(rmt_group_context_t));
+    rmt_channel_handle_t *channels = (rmt_channel_handle_t *)calloc(strip_count, sizeof(rmt_channel_handle_t));
+    if (context == NULL || channels == NULL)
+    {
+        free(context);
+        free(channels);
+        return ESP_ERR_NO_MEM;
+    }
+    for (size_t i = 0; i < strip_count; i++)
+    {
+        channels[i] = ((rmt_context_t *)strips[i]->backend_context)->channel;
+    }
+
+    const rmt_sync_manager_config_t sync_config = {
+        .tx_channel_array = channels,
+        .array_size = strip_count,
+    };
+    esp_err_t err = rmt_new_sync_manager(&sync_config, &context->sync_manager);
+    free(channels);
+    if (err == ESP_ERR_NOT_SUPPORTED)
+    {
+        // No TX synchronization on this chip, the channels are started right after each other instead.
+        context->sync_manager = NULL;
+        err = ESP_OK;
+    }
+    ESP_ERROR_CHECK_WITHOUT_ABORT(err);
+    if (err != ESP_OK)
+    {
+        free(context);
+        return err;
+    }
+    *group_context = context;
+    return ESP_OK;
+}
+
+static esp_err_t rmt_backend_group_uninstall(const led_strip_handle_t *strips, size_t strip_count, void *group_context)
+{
+    rmt_group_context_t *context = (rmt_group_context_t *)group_context;
+    if (context->sync_manager != NULL)
+    {
+        esp_err_t err = rmt_del_sync_manager(context->sync_manager);
+        ESP_ERROR_CHECK_WITHOUT_ABORT(err);
+        if (err != ESP_OK)
+        {
+            return err;
+        }
+    }
+    free(context);
+    return ESP_OK;
+}
+
+static bool IRAM_ATTR on_trans_done(rmt_channel_handle_t channel, const rmt_tx_done_event_data_t *event_data, void *user_ctx)
+{
+    BaseType_t higher_priority_task_woken = pdFALSE;
+    led_strip_on_tx_done_from_isr((led_strip_handle_t)user_ctx, &higher_priority_task_woken);
+    return higher_priority_task_woken == pdTRUE;
+}
+
+static void release_context(rmt_context_t *context)
+{
+    if (context->pixel_encoder != NULL)
+    {
+        rmt_del_encoder(context->pixel_encoder);
+    }
+    if (context->symbol_encoder != NULL)
+    {
+        rmt_del_encoder(context->symbol_encoder);
+    }
+    if (context->channel != NULL)
+    {
+        rmt_del_channel(context->channel);
+    }
+    free(context);
+}
+
+static void new_channel(void *arg)
+{
+    new_channel_args_t *args = (new_channel_args_t *)arg;
+    args->result = rmt_new_tx_channel(args->config, &args->channel);
+}
+
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 2, 0)
+static int map_intr_priority(int intr_flags)
+{
+    // The lowest level that the flags allow, 0 lets the driver choose.
+    for (int level = 1; level <= 6; level++)
+    {
+        if (intr_flags & (ESP_INTR_FLAG_LEVEL1 << (level - 1)))
+        {
+            return level;
+        }
+    }
+    return 0;
+}
+#endif
+
+static esp_err_t new_led_strip_encoder(led_strip_handle_t handle, bool copy_symbols, rmt_encoder_handle_t *ret_encoder)
+{
+    const led_strip_manual_timing_t *timing = &handle->led_timing;
+    rmt_led_strip_encoder_t *encoder = (rmt_led_strip_encoder_t *)heap_caps_calloc(1, sizeof(rmt_led_strip_encoder_t), MALLOC_CAP_INTERNAL);
+    if (encoder == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    encoder->base.encode = encode_led_strip;
+    encoder->base.reset = reset_led_strip_encoder;
+    encoder->base.del = del_led_strip_encoder;
+    encoder->stats_handle = copy_symbols ? NULL : handle;
+    encoder->reset_code.val = LED_STRIP_SYMBOL(0, timing->reset_time / 2, 0, timing->reset_time - (timing->reset_time / 2));
+
+    esp_err_t err = ESP_OK;
+    if (copy_symbols)
+    {
+        const rmt_copy_encoder_config_t copy_config = {};
+        err = rmt_new_copy_encoder(&copy_config, &encoder->data_encoder);
+    }
+    else
+    {
+        const rmt_bytes_encoder_config_t bytes_config = {
+            .bit0.val = LED_STRIP_SYMBOL(1, timing->low_on, 0, timing->low_off),
+            .bit1.val = LED_STRIP_SYMBOL(1, timing->high_on, 0, timing->high_off),
+            .flags.msb_first = 1,
+        };
+        err = rmt_new_bytes_encoder(&bytes_config, &encoder->data_encoder);
+    }
+    if (err != ESP_OK)
+    {
+        free(encoder);
+        return err;
+    }
+
+    const rmt_copy_encoder_config_t reset_config = {};
+    err = rmt_new_copy_encoder(&reset_config, &encoder->reset_encoder);
+    if (err != ESP_OK)
+    {
+        rmt_del_encoder(encoder->data_encoder);
+        free(encoder);
+        return err;
+    }
+    *ret_encoder = &encoder->base;
+    return ESP_OK;
+}
+
+static size_t IRAM_ATTR encode_led_strip(rmt_encoder_t *encoder, rmt_channel_handle_t channel, const void *primary_data, size_t data_size, rmt_encode_state_t *ret_state)
+{
+    rmt_led_strip_encoder_t *led_encoder = __containerof(encoder, rmt_led_strip_encoder_t, base);
+    rmt_encode_state_t session_state = RMT_ENCODING_RESET;
+    int state = RMT_ENCODING_RESET;
+    size_t encoded_symbols = 0;
+    switch (led_encoder->state)
+    {
+    case 0: // Send the pixel data.
+    {
+        const uint32_t start_cycles = led_strip_stats_cycle_count();
+        encoded_symbols += led_encoder->data_encoder->encode(led_encoder->data_encoder, channel, primary_data, data_size, &session_state);
+        if (session_state & RMT_ENCODING_COMPLETE)
+        {
+            led_encoder->state = 1;
+        }
+        if (led_encoder->stats_handle != NULL)
+        {
+            // The bytes encoder can stop halfway a byte, so the bytes are only counted once the whole frame is encoded.
+            led_strip_stats_record_translation(led_encoder->stats_handle, (session_state & RMT_ENCODING_COMPLETE) ? data_size : 0, start_cycles);
+        }
+        if (session_state & RMT_ENCODING_MEM_FULL)
+        {
+            state |= RMT_ENCODING_MEM_FULL;
+            break; // Continue with the rest when the driver has space again.
+        }
+    }
+    // fall-through
+    case 1: // Send the reset code so the LEDs latch the new frame.
+        encoded_symbols += led_encoder->reset_encoder->encode(led_encoder->reset_encoder, channel, &led_encoder->reset_code, sizeof(led_encoder->reset_code), &session_state);
+        if (session_state & RMT_ENCODING_COMPLETE)
+        {
+            led_encoder->state = 0;
+            state |= RMT_ENCODING_COMPLETE;
+        }
+        if (session_state & RMT_ENCODING_MEM_FULL)
+        {
+            state |= RMT_ENCODING_MEM_FULL;
+        }
+        break;
+    default:
+        break;
+    }
+    *ret_state = (rmt_encode_state_t)state;
+    return encoded_symbols;
+}
+
+static esp_err_t reset_led_strip_encoder(rmt_encoder_t *encoder)
+{
+    rmt_led_strip_encoder_t *led_encoder = __containerof(encoder, rmt_led_strip_encoder_t, base);
+    rmt_encoder_reset(led_encoder->data_encoder);
+    rmt_encoder_reset(led_encoder->reset_encoder);
+    led_encoder->state = 0;
+    return ESP_OK;
+}
+
+static esp_err_t del_led_strip_encoder(rmt_encoder_t *encoder)
+{
+    rmt_led_strip_encoder_t *led_encoder = __containerof(encoder, rmt_led_strip_encoder_t, base);
+    rmt_del_encoder(led_encoder->data_encoder);
+    rmt_del_encoder(led_encoder->reset_encoder);
+    free(led_encoder);
+    return ESP_OK;
+}
@@ -0,0 +1,571 @@
+/**
+ * @file led_strip_rmt_legacy.c
+ * @author Giel Willemsen
+ * @brief The led strip backend for the legacy (driver/rmt.h) RMT driver.
+ * @version 0.1 2022-09-07 Initial version
+ * @date 2022-09-07
+ *
+ * @copyright
+ * MIT License
+ *
+ * Copyright (c) 2022 Giel Willemsen
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <esp_log.h>
+#include <soc/soc_caps.h>
+#include <esp_heap_caps.h>
+#include <freertos/semphr.h>
+#include <driver/rmt.h>
+#include "led_strip_private.h"
+
+#define BOUNCE_BUFFER_SIZE CONFIG_LED_STRIP_BOUNCE_BUFFER_SIZE
+#define BOUNCE_CHUNK_SIZE (BOUNCE_BUFFER_SIZE / 2)
+#define BOUNCE_TIMEOUT pdMS_TO_TICKS(100)
+
+typedef struct driver_install_args
+{
+    rmt_channel_t channel;
+    int intr_flags;
+    esp_err_t result;
+} driver_install_args_t;
+
+typedef struct rmt_legacy_context
+{
+    rmt_channel_t channel;
+    uint8_t mem_block_num;
+    uint8_t bit_offset; ///< The bits of the current byte (pixel when swizzled) that the translator already sent, when a refill ended halfway it.
+    uint8_t *bounce; ///< Internal RAM copy of two chunks of a PSRAM framebuffer, NULL when the framebuffer is in internal RAM.
+    SemaphoreHandle_t chunk_consumed; ///< Given by the translator every time it finished a chunk of the bounce buffer.
+    const uint8_t *bounce_source; ///< The frame that is being transmitted through the bounce buffer.
+    volatile size_t staged_end; ///< The bytes of bounce_source before this offset are in the bounce buffer, at their offset modulo BOUNCE_BUFFER_SIZE.
+    volatile size_t consumed; ///< The bytes of bounce_source before this offset are fully translated.
+} rmt_legacy_context_t;
+
+static void rmt_legacy_init(void);
+static esp_err_t rmt_legacy_install(led_strip_handle_t handle, const led_strip_config_t *config);
+static esp_err_t rmt_legacy_uninstall(led_strip_handle_t handle);
+static esp_err_t rmt_legacy_transmit(led_strip_handle_t handle, const led_strip_color_component_t *data, size_t size, bool wait_tx_done);
+static esp_err_t rmt_legacy_transmit_symbols(led_strip_handle_t handle, const uint32_t *symbols, size_t count, bool wait_tx_done);
+static esp_err_t rmt_legacy_wait_tx_done(led_strip_handle_t handle, TickType_t timeout);
+static esp_err_t rmt_legacy_group_install(const led_strip_handle_t *strips, size_t strip_count, void **group_context);
+static esp_err_t rmt_legacy_group_uninstall(const led_strip_handle_t *strips, size_t strip_count, void *group_context);
+static void IRAM_ATTR rmt_legacy_tx_end(rmt_channel_t channel, void *arg);
+static esp_err_t configure_channel(rmt_channel_t channel, const led_strip_config_t *config, led_strip_handle_t handle);
+static esp_err_t alloc_bounce_buffer(rmt_legacy_context_t *context);
+static void free_context(rmt_legacy_context_t *context);
+static esp_err_t transmit_bounced(rmt_legacy_context_t *context, const uint8_t *data, size_t size, bool wait_tx_done);
+static void install_driver(void *arg);
+static esp_err_t find_empty_channel(rmt_channel_t *channel, uint8_t mem_block_num);
+static void mark_channel_free(rmt_channel_t channel, uint8_t mem_block_num);
+static void mark_channel_used(rmt_channel_t channel, uint8_t mem_block_num);
+static void IRAM_ATTR rmt_adapter(led_strip_handle_t handle, const void *src, rmt_item32_t *dest, size_t src_size, size_t wanted_num, size_t *translated_size, size_t *item_num);
+FORCE_INLINE_ATTR uint8_t read_source(const rmt_legacy_context_t *context, const uint8_t *raw_data, size_t index, size_t source_offset, size_t staged_end);
+
+static bool rmt_channel_used[RMT_CHANNEL_MAX];
+static led_strip_handle_t rmt_channel_owner[RMT_CHANNEL_MAX]; ///< The driver has one TX end callback for all channels.
+static bool tx_end_callback_registered = false;
+
+/// A translator per channel that passes the owner of the channel on, rmt_translator_get_context lives in flash.
+#define CHANNEL_TRANSLATOR(channel) \
+    static void IRAM_ATTR rmt_adapter_##channel(const void *src, rmt_item32_t *dest, size_t src_size, size_t wanted_num, size_t *translated_size, size_t *item_num) \
+    { \
+        rmt_adapter(rmt_channel_owner[channel], src, dest, src_size, wanted_num, translated_size, item_num); \
+    }
+
+CHANNEL_TRANSLATOR(0)
+CHANNEL_TRANSLATOR(1)
+CHANNEL_TRANSLATOR(2)
+CHANNEL_TRANSLATOR(3)
+#if SOC_RMT_CHANNELS_PER_GROUP > 4
+CHANNEL_TRANSLATOR(4)
+CHANNEL_TRANSLATOR(5)
+CHANNEL_TRANSLATOR(6)
+CHANNEL_TRANSLATOR(7)
+#endif
+
+static const sample_to_rmt_t channel_translators[] = {
+    rmt_adapter_0,
+    rmt_adapter_1,
+    rmt_adapter_2,
+    rmt_adapter_3,
+#if SOC_RMT_CHANNELS_PER_GROUP > 4
+    rmt_adapter_4,
+    rmt_adapter_5,
+    rmt_adapter_6,
+    rmt_adapter_7,
+#endif
+};
+
+const led_strip_backend_t led_strip_rmt_backend = {
+    .init = rmt_legacy_init,
+    .install = rmt_legacy_install,
+    .uninstall = rmt_legacy_uninstall,
+    .transmit = rmt_legacy_transmit,
+    .transmit_symbols = rmt_legacy_transmit_symbols,
+    .wait_tx_done = rmt_legacy_wait_tx_done,
+    .group_install = rmt_legacy_group_install,
+    .group_uninstall = rmt_legacy_group_uninstall,
+    .frame_period_us = NULL,
+    .maps_pixels = true,
+    .sends_reset = false,
+};
+
+static void rmt_legacy_init(void)
+{
+    for (int i = 0; i < (int)RMT_CHANNEL_MAX; i++)
+    {
+        rmt_channel_used[i] = false;
+    }
+}
+
+static esp_err_t rmt_legacy_install(led_strip_handle_t handle, const led_strip_config_t *config)
+{
+    if (config->with_dma)
+    {
+        return ESP_ERR_NOT_SUPPORTED; // The legacy RMT driver can't stream from DMA.
+    }
+    rmt_legacy_context_t *context = (rmt_legacy_context_t *)heap_caps_calloc(1, sizeof(rmt_legacy_context_t), MALLOC_CAP_INTERNAL);
+    if (context == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    if (handle->framebuffer_in_spiram)
+    {
+        esp_err_t err = alloc_bounce_buffer(context);
+        if (err != ESP_OK)
+        {
+            free_context(context);
+            return err;
+        }
+    }
+
+    rmt_channel_t channel = RMT_CHANNEL_MAX;
+    esp_err_t err = find_empty_channel(&channel, config->mem_block_num);
+    ESP_ERROR_CHECK_WITHOUT_ABORT(err);
+    if (err != ESP_OK)
+    {
+        free_context(context);
+        return err;
+    }
+    mark_channel_used(channel, config->mem_block_num);
+
+    err = configure_channel(channel, config, handle);
+    if (err != ESP_OK)
+    {
+        mark_channel_free(channel, config->mem_block_num);
+        free_context(context);
+        return err;
+    }
+
+    context->channel = channel;
+    context->mem_block_num = config->mem_block_num;
+    handle->backend_context = context;
+    rmt_channel_owner[channel] = handle;
+    if (tx_end_callback_registered == false)
+    {
+        rmt_register_tx_end_callback(rmt_legacy_tx_end, NULL);
+        tx_end_callback_registered = true;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t rmt_legacy_uninstall(led_strip_handle_t handle)
+{
+    rmt_legacy_context_t *context = (rmt_legacy_context_t *)handle->backend_context;
+    esp_err_t err = rmt_driver_uninstall(context->channel);
+    ESP_ERROR_CHECK_WITHOUT_ABORT(err);
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+    rmt_channel_owner[context->channel] = NULL;
+    mark_channel_free(context->channel, context->mem_block_num);
+    free_context(context);
+    handle->backend_context = NULL;
+    return ESP_OK;
+}
+
+static esp_err_t rmt_legacy_transmit(led_strip_handle_t handle, const led_strip_color_component_t *data, size_t size, bool wait_tx_done)
+{
+    rmt_legacy_context_t *context = (rmt_legacy_context_t *)handle->backend_context;
+    context->bit_offset = 0; // The driver isn't translating, so nothing can be halfway.
+    if (context->bounce != NULL)
+    {
+        return transmit_bounced(context, data, size, wait_tx_done);
+    }
+    esp_err_t err = rmt_write_sample(context->channel, data, size, wait_tx_done);
+    LED_STRIP_HOT_PATH_ERROR_CHECK(err);
+    return err;
+}
+
+static esp_err_t rmt_legacy_transmit_symbols(led_strip_handle_t handle, const uint32_t *symbols, size_t count, bool wait_tx_done)
+{
+    rmt_legacy_context_t *context = (rmt_legacy_context_t *)handle->backend_context;
+    // The symbols are packed in the rmt_item32_t layout, see LED_STRIP_SYMBOL.
+    esp_err_t err = rmt_write_items(context->channel, (const rmt_item32_t *)symbols, (int)count, wait_tx_done);
+    LED_STRIP_HOT_PATH_ERROR_CHECK(err);
+    return err;
+}
+
+static esp_err_t rmt_legacy_wait_tx_done(led_strip_handle_t handle, TickType_t timeout)
+{
+    rmt_legacy_context_t *context = (rmt_legacy_context_t *)handle->backend_context;
+    return rmt_wait_tx_done(context->channel, timeout);
+}
+
+static esp_err_t rmt_legacy_group_install(const led_strip_handle_t *strips, size_t strip_count, void **group_context)
+{
+    *group_context = NULL;
+    for (size_t i = 0; i < strip_count; i++)
+    {
+        const rmt_legacy_context_t *context = (const rmt_legacy_context_t *)strips[i]->backend_context;
+        if (context->bounce != NULL)
+        {
+            // The flush stages the frame into the bounce buffer before it returns, so a strip that waits for the other
+            // channels of the group would wait out the staging timeout and the ISR would read PSRAM anyway.
+            return ESP_ERR_NOT_SUPPORTED;
+        }
+    }
+#if SOC_RMT_SUPPORT_TX_SYNCHRO
+    for (size_t i = 0; i < strip_count; i++)
+    {
+        rmt_legacy_context_t *context = (rmt_legacy_context_t *)strips[i]->backend_context;
+        esp_err_t err = rmt_add_channel_to_group(context->channel);
+        ESP_ERROR_CHECK_WITHOUT_ABORT(err);
+        if (err != ESP_OK)
+        {
+            rmt_legacy_group_uninstall(strips, i, NULL);
+            return err;
+        }
+    }
+#endif
+    return ESP_OK;
+}
+
+static esp_err_t rmt_legacy_group_uninstall(const led_strip_handle_t *strips, size_t strip_count, void *group_context)
+{
+#if SOC_RMT_SUPPORT_TX_SYNCHRO
+    for (size_t i = 0; i < strip_count; i++)
+    {
+        rmt_legacy_context_t *context = (rmt_legacy_context_t *)strips[i]->backend_context;
+        esp_err_t err = rmt_remove_channel_from_group(context->channel);
+        ESP_ERROR_CHECK_WITHOUT_ABORT(err);
+        if (err != ESP_OK)
+        {
+            return err;
+        }
+    }
+#endif
+    return ESP_OK;
+}
+
+static void IRAM_ATTR rmt_legacy_tx_end(rmt_channel_t channel, void *arg)
+{
+    led_strip_handle_t handle = rmt_channel_owner[channel];
+    if (handle == NULL)
+    {
+        return;
+    }
+    BaseType_t higher_priority_task_woken = pdFALSE;
+    led_strip_on_tx_done_from_isr(handle, &higher_priority_task_woken);
+    if (higher_priority_task_woken == pdTRUE)
+    {
+        portYIELD_FROM_ISR();
+    }
+}
+
+static esp_err_t configure_channel(rmt_channel_t channel, const led_strip_config_t *config, led_strip_handle_t handle)
+{
+    rmt_config_t rmt_channel_config = RMT_DEFAULT_CONFIG_TX(config->gpio_output_num, channel);
+    rmt_channel_config.clk_div = LED_STRIP_CLOCK_DIVIDER;
+    rmt_channel_config.mem_block_num = config->mem_block_num;
+    esp_err_t err = rmt_config(&rmt_channel_config);
+    ESP_ERROR_CHECK_WITHOUT_ABORT(err);
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+
+    driver_install_args_t install_args = {
+        .channel = rmt_channel_config.channel,
+        .intr_flags = config->intr_flags,
+        .result = ESP_FAIL,
+    };
+    // The driver allocates its interrupt on the core that installs it.
+    err = led_strip_run_on_core(config->intr_core, install_driver, &install_args);
+    if (err == ESP_OK)
+    {
+        err = install_args.result;
+    }
+    ESP_ERROR_CHECK_WITHOUT_ABORT(err);
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+
+    if ((size_t)channel >= sizeof(channel_translators) / sizeof(channel_translators[0]))
+    {
+        rmt_driver_uninstall(channel);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    err = rmt_translator_init(rmt_channel_config.channel, channel_translators[channel]);
+    ESP_ERROR_CHECK_WITHOUT_ABORT(err);
+    if (err != ESP_OK)
+    {
+        rmt_driver_uninstall(channel);
+        return err;
+    }
+
+    err = rmt_set_tx_loop_mode(rmt_channel_config.channel, false);
+    ESP_ERROR_CHECK_WITHOUT_ABORT(err);
+    if (err != ESP_OK)
+    {
+        rmt_driver_uninstall(channel);
+        return err;
+    }
+    return ESP_OK;
+}
+
+static void install_driver(void *arg)
+{
+    driver_install_args_t *args = (driver_install_args_t *)arg;
+    args->result = rmt_driver_install(args->channel, 0, args->intr_flags);
+}
+
+static esp_err_t alloc_bounce_buffer(rmt_legacy_context_t *context)
+{
+    context->bounce = (uint8_t *)heap_caps_malloc(BOUNCE_BUFFER_SIZE, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    context->chunk_consumed = xSemaphoreCreateBinary();
+    if (context->bounce == NULL || context->chunk_consumed == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+static void free_context(rmt_legacy_context_t *context)
+{
+    if (context->bounce != NULL)
+    {
+        free(context->bounce);
+    }
+    if (context->chunk_consumed != NULL)
+    {
+        vSemaphoreDelete(context->chunk_consumed);
+    }
+    free(context);
+}
+
+static esp_err_t transmit_bounced(rmt_legacy_context_t *context, const uint8_t *data, size_t size, bool wait_tx_done)
+{
+    size_t staged = size < BOUNCE_BUFFER_SIZE ? size : BOUNCE_BUFFER_SIZE;
+    memcpy(context->bounce, data, staged);
+    context->bounce_source = data;
+    context->consumed = 0;
+    context->staged_end = staged;
+    xSemaphoreTake(context->chunk_consumed, 0); // Drop a give that is left over from the previous frame.
+    esp_err_t err = rmt_write_sample(context->channel, data, size, false);
+    LED_STRIP_HOT_PATH_ERROR_CHECK(err);
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+
+    // Every chunk goes to the half of the bounce buffer that held the chunk before the previous one, so that chunk has to be translated first.
+    bool translator_stalled = false;
+    while (staged < size && translator_stalled == false)
+    {
+        while (context->consumed + BOUNCE_BUFFER_SIZE < staged + BOUNCE_CHUNK_SIZE)
+        {
+            if (xSemaphoreTake(context->chunk_consumed, BOUNCE_TIMEOUT) != pdTRUE)
+            {
+                // The translator reads the rest of the frame from the framebuffer itself, which is still correct, only slower.
+                translator_stalled = true;
+                break;
+            }
+        }
+        if (translator_stalled == false)
+        {
+            const size_t chunk = size - staged < BOUNCE_CHUNK_SIZE ? size - staged : BOUNCE_CHUNK_SIZE;
+            memcpy(context->bounce + (staged % BOUNCE_BUFFER_SIZE), data + staged, chunk);
+            staged += chunk;
+            context->staged_end = staged;
+        }
+    }
+    if (wait_tx_done)
+    {
+        err = rmt_wait_tx_done(context->channel, portMAX_DELAY);
+        LED_STRIP_HOT_PATH_ERROR_CHECK(err);
+    }
+    return err;
+}
+
+static esp_err_t find_empty_channel(rmt_channel_t *channel, uint8_t mem_block_num)
+{
+    if (channel == NULL || mem_block_num == 0)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    // A channel with multiple memory blocks borrows the blocks of the channels after it, so those have to be free as well.
+    for (size_t i = 0; i + mem_block_num <= (size_t)RMT_CHANNEL_MAX; i++)
+    {
+        bool blocks_free = true;
+        for (size_t j = i; j < i + mem_block_num; j++)
+        {
+            blocks_free = blocks_free && (rmt_channel_used[j] == false);
+        }
+        if (blocks_free)
+        {
+            *channel = (rmt_channel_t)i;
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+static void mark_channel_free(rmt_channel_t channel, uint8_t mem_block_num)
+{
+    for (int i = (int)channel; i < (int)channel + mem_block_num && i < (int)RMT_CHANNEL_MAX; i++)
+    {
+        rmt_channel_used[i] = false;
+    }
+}
+
+static void mark_channel_used(rmt_channel_t channel, uint8_t mem_block_num)
+{
+    for (int i = (int)channel; i < (int)channel + mem_block_num && i < (int)RMT_CHANNEL_MAX; i++)
+    {
+        rmt_channel_used[i] = true;
+    }
+}
+
+static void IRAM_ATTR rmt_adapter(led_strip_handle_t handle, const void *src, rmt_item32_t *dest, size_t src_size, size_t wanted_num, size_t *translated_size, size_t *item_num)
+{
+    *translated_size = 0;
+    *item_num = 0;
+    const uint8_t *raw_data = (const uint8_t *)src;
+    if (handle == NULL)
+    {
+        return; // Just bail out and hope that the driver gets it when translated_size and item_num are zero.
+    }
+
+    rmt_legacy_context_t *context = (rmt_legacy_context_t *)handle->backend_context;
+    const uint32_t start_cycles = led_strip_stats_cycle_count();
+    const uint8_t *levels = led_strip_translator_levels(handle);
+    const uint8_t *swizzle = led_strip_translator_swizzle(handle);
+    const uint32_t *symbol_lut = led_strip_symbol_lut(handle);
+    // With a bounce buffer the bytes that are already staged are read from internal RAM instead of from raw_data.
+    const size_t source_offset = context->bounce != NULL ? (size_t)(raw_data - context->bounce_source) : 0;
+    const size_t staged_end = context->bounce != NULL ? context->staged_end : 0;
+
+    // Every byte is 8 items (1 period on, 1 period off per bit). The driver can ask for any number of items, so a refill may end
+    // halfway a byte. Such a byte isn't reported as translated, the driver passes it again and the rest of its bits are sent then.
+    size_t bytes = 0;
+    size_t items = 0;
+    uint8_t bit = context->bit_offset;
+    if (swizzle == NULL)
+    {
+        while (bytes < src_size && items < wanted_num)
+        {
+            const uint8_t raw = read_source(context, raw_data, bytes, source_offset, staged_end);
+            const uint8_t value = levels != NULL ? levels[raw] : raw;
+            if (bit == 0 && wanted_num - items >= 8)
+            {
+                led_strip_translate_byte(&dest[items].val, value, symbol_lut);
+                items += 8;
+                bytes++;
+                continue;
+            }
+            uint32_t symbols[8];
+            led_strip_translate_byte(symbols, value, symbol_lut);
+            while (bit < 8 && items < wanted_num)
+            {
+                dest[items++].val = symbols[bit++];
+            }
+            if (bit == 8)
+            {
+                bit = 0;
+                bytes++;
+            }
+        }
+    }
+    else
+    {
+        // The bytes of a pixel are sent out of order, so only whole pixels are reported as translated and bit counts the bits of the pixel.
+        const size_t stride = LED_STRIP_PIXEL_STRIDE(handle);
+        const uint8_t pixel_bits = CALC_COLOR_SIZE(handle) * 8;
+        while (bytes + stride <= src_size && items < wanted_num)
+        {
+            const uint8_t raw = read_source(context, raw_data, bytes + swizzle[bit / 8], source_offset, staged_end);
+            const uint8_t value = levels != NULL ? levels[raw] : raw;
+            if (bit % 8 == 0 && wanted_num - items >= 8)
+            {
+                led_strip_translate_byte(&dest[items].val, value, symbol_lut);
+                items += 8;
+                bit += 8;
+            }
+            else
+            {
+                uint32_t symbols[8];
+                led_strip_translate_byte(symbols, value, symbol_lut);
+                do
+                {
+                    dest[items++].val = symbols[bit % 8];
+                    bit++;
+                } while (bit % 8 != 0 && items < wanted_num);
+            }
+            if (bit == pixel_bits)
+            {
+                bit = 0;
+                bytes += stride;
+            }
+        }
+    }
+    context->bit_offset = bit;
+    if (context->bounce != NULL)
+    {
+        context->consumed = source_offset + bytes;
+        if (source_offset / BOUNCE_CHUNK_SIZE != (source_offset + bytes) / BOUNCE_CHUNK_SIZE && xPortInIsrContext())
+        {
+            // The first refill happens in rmt_write_sample itself, the flushing task isn't waiting yet then.
+            BaseType_t higher_priority_task_woken = pdFALSE;
+            xSemaphoreGiveFromISR(context->chunk_consumed, &higher_priority_task_woken);
+            if (higher_priority_task_woken == pdTRUE)
+            {
+                portYIELD_FROM_ISR();
+            }
+        }
+    }
+
+    *translated_size = bytes;
+    *item_num = items;
+    led_strip_stats_record_translation(handle, bytes, start_cycles);
+}
+
+FORCE_INLINE_ATTR uint8_t read_source(const rmt_legacy_context_t *context, const uint8_t *raw_data, size_t index, size_t source_offset, size_t staged_end)
+{
+    const size_t offset = source_offset + index;
+    return offset < staged_end ? context->bounce[offset % BOUNCE_BUFFER_SIZE] : raw_data[index];
+}
@@ -0,0 +1,258 @@
+/**
+ * @file led_strip_scheduler.c
+ * @author Giel Willemsen
+ * @brief Flushing a led strip at a fixed frame rate.
+ * @version 0.1 2022-09-07 Initial version
+ * @date 2022-09-07
+ *
+ * @copyright
+ * MIT License
+ *
+ * Copyright (c) 2022 Giel Willemsen
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#include "led_strip_private.h"
+
+struct led_strip_scheduler
+{
+    led_strip_handle_t handle;
+    esp_timer_handle_t timer;
+    TaskHandle_t task;
+    SemaphoreHandle_t stopped; ///< Given by the scheduler task right before it deletes itself.
+    volatile bool running;
+    led_strip_frame_cb_t callback;
+    void *user_ctx;
+    int64_t start_time; ///< The esp_timer time of period 0, period n ideally starts at start_time + n * frame_period_us.
+    led_strip_scheduler_stats_t stats;
+};
+
+static void dealloc_scheduler(led_strip_scheduler_t *scheduler);
+static void on_period(void *arg);
+static void scheduler_task(void *arg);
+static void record_period(led_strip_scheduler_t *scheduler, uint32_t periods);
+
+extern esp_err_t led_strip_get_min_frame_period(led_strip_handle_t handle, uint32_t *period_us)
+{
+    if (handle == NULL || period_us == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (handle->backend->frame_period_us != NULL)
+    {
+        *period_us = handle->backend->frame_period_us(handle);
+        return ESP_OK;
+    }
+    const led_strip_manual_timing_t *timing = &handle->led_timing;
+    const uint32_t low_ticks = timing->low_on + timing->low_off;
+    const uint32_t high_ticks = timing->high_on + timing->high_off;
+    const uint64_t bits = (uint64_t)handle->led_count * CALC_COLOR_SIZE(handle) * 8;
+    const uint64_t ticks = (bits * (low_ticks > high_ticks ? low_ticks : high_ticks)) + timing->reset_time;
+    *period_us = (uint32_t)LED_STRIP_TICKS_AS_US(ticks);
+    return ESP_OK;
+}
+
+extern esp_err_t led_strip_start_scheduler(led_strip_handle_t handle, uint32_t fps, UBaseType_t priority, BaseType_t core_id, led_strip_frame_cb_t callback, void *user_ctx)
+{
+    if (handle == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    else if (handle->scheduler != NULL || handle->refresh_task != NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    uint32_t min_period_us = 0;
+    esp_err_t err = led_strip_get_min_frame_period(handle, &min_period_us);
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+    const uint32_t period_us = fps == 0 ? min_period_us : 1000000 / fps;
+    if (period_us < min_period_us || period_us == 0)
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    led_strip_scheduler_t *scheduler = (led_strip_scheduler_t *)calloc(1, sizeof(led_strip_scheduler_t));
+    if (scheduler == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    scheduler->handle = handle;
+    scheduler->callback = callback;
+    scheduler->user_ctx = user_ctx;
+    scheduler->stats.frame_period_us = period_us;
+    scheduler->running = true;
+    scheduler->stopped = xSemaphoreCreateBinary();
+    if (scheduler->stopped == NULL)
+    {
+        dealloc_scheduler(scheduler);
+        return ESP_ERR_NO_MEM;
+    }
+
+    // The timer callback only wakes the task, so the esp_timer task is never held up by rendering the frame.
+    const esp_timer_create_args_t timer_args = {
+        .callback = on_period,
+        .arg = scheduler,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "led_strip_sched",
+        .skip_unhandled_events = false,
+    };
+    err = esp_timer_create(&timer_args, &scheduler->timer);
+    ESP_ERROR_CHECK_WITHOUT_ABORT(err);
+    if (err != ESP_OK)
+    {
+        scheduler->timer = NULL;
+        dealloc_scheduler(scheduler);
+        return err;
+    }
+    // The timer isn't started yet, so nothing can notify the task before it exists.
+    if (xTaskCreatePinnedToCore(scheduler_task, "led_strip_sched", CONFIG_LED_STRIP_SCHEDULER_TASK_STACK_SIZE, scheduler, priority, &scheduler->task, core_id) != pdPASS)
+    {
+        dealloc_scheduler(scheduler);
+        return ESP_ERR_NO_MEM;
+    }
+
+    handle->scheduler = scheduler;
+    scheduler->start_time = esp_timer_get_time();
+    err = esp_timer_start_periodic(scheduler->timer, period_us);
+    ESP_ERROR_CHECK_WITHOUT_ABORT(err);
+    if (err != ESP_OK)
+    {
+        led_strip_stop_scheduler(handle);
+        return err;
+    }
+    return ESP_OK;
+}
+
+extern esp_err_t led_strip_stop_scheduler(led_strip_handle_t handle)
+{
+    if (handle == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    else if (handle->scheduler == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    led_strip_scheduler_t *scheduler = handle->scheduler;
+    if (scheduler->timer != NULL)
+    {
+        esp_timer_stop(scheduler->timer);
+    }
+    scheduler->running = false;
+    xTaskNotifyGive(scheduler->task);
+    xSemaphoreTake(scheduler->stopped, portMAX_DELAY);
+    handle->scheduler = NULL;
+    dealloc_scheduler(scheduler);
+    return ESP_OK;
+}
+
+extern esp_err_t led_strip_get_scheduler_stats(led_strip_handle_t handle, led_strip_scheduler_stats_t *stats)
+{
+    if (handle == NULL || stats == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    else if (handle->scheduler == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    *stats = handle->scheduler->stats;
+    return ESP_OK;
+}
+
+// Private functions
+
+static void dealloc_scheduler(led_strip_scheduler_t *scheduler)
+{
+    if (scheduler->timer != NULL)
+    {
+        esp_timer_delete(scheduler->timer);
+    }
+    if (scheduler->stopped != NULL)
+    {
+        vSemaphoreDelete(scheduler->stopped);
+    }
+    free(scheduler);
+}
+
+static void on_period(void *arg)
+{
+    led_strip_scheduler_t *scheduler = (led_strip_scheduler_t *)arg;
+    xTaskNotifyGive(scheduler->task);
+}
+
+static void scheduler_task(void *arg)
+{
+    led_strip_scheduler_t *scheduler = (led_strip_scheduler_t *)arg;
+    led_strip_handle_t handle = scheduler->handle;
+    while (true)
+    {
+        // Every period that passed since the last wake up is counted in the notification value.
+        const uint32_t periods = ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        if (scheduler->running == false)
+        {
+            break;
+        }
+        record_period(scheduler, periods);
+        if (scheduler->callback != NULL && scheduler->callback(handle, scheduler->user_ctx) == false)
+        {
+            scheduler->stats.frames_skipped++;
+            continue;
+        }
+        esp_err_t err = led_strip_start_flush(handle);
+        if (err == ESP_OK)
+        {
+            scheduler->stats.frames_flushed++;
+        }
+        else if (err == ESP_ERR_NOT_FINISHED)
+        {
+            scheduler->stats.frames_late++;
+        }
+    }
+    xSemaphoreGive(scheduler->stopped);
+    vTaskDelete(NULL);
+}
+
+static void record_period(led_strip_scheduler_t *scheduler, uint32_t periods)
+{
+    led_strip_scheduler_stats_t *stats = &scheduler->stats;
+    stats->periods += periods;
+    stats->periods_missed += periods - 1;
+    const int64_t ideal_time = scheduler->start_time + ((int64_t)stats->periods * stats->frame_period_us);
+    const int64_t jitter = esp_timer_get_time() - ideal_time;
+    stats->last_jitter_us = jitter > 0 ? (uint32_t)jitter : 0;
+    stats->total_jitter_us += stats->last_jitter_us;
+    if (stats->last_jitter_us > stats->max_jitter_us)
+    {
+        stats->max_jitter_us = stats->last_jitter_us;
+    }
+}
@@ -0,0 +1,322 @@
+/**
+ * @file led_strip_spi.c
+ * @author Giel Willemsen
+ * @brief The SPI backend for clocked APA102 and SK9822 led strips.
+ * @version 0.1 2022-09-07 Initial version
+ * @date 2022-09-07
+ *
+ * @copyright
+ * MIT License
+ *
+ * Copyright (c) 2022 Giel Willemsen
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <esp_log.h>
+#include <esp_heap_caps.h>
+#include <driver/spi_master.h>
+#include "led_strip_private.h"
+
+#define START_FRAME_SIZE 4
+#define PIXEL_FRAME_SIZE 4
+#define LATCH_FRAME_SIZE 4 ///< The extra zero frame SK9822 needs to show the new colors right away.
+#define PIXEL_HEADER 0xE0 ///< The three 1 bits that start every pixel frame, followed by the 5 bit global brightness.
+#define MAX_GLOBAL_BRIGHTNESS 31
+
+typedef struct spi_context
+{
+    spi_host_device_t host;
+    spi_device_handle_t device;
+    spi_transaction_t transaction;
+    uint8_t *buffer;            ///< The DMA buffer with the start frame, a frame per pixel and the end frame.
+    uint8_t *global_brightness; ///< The 5 bit global brightness of every physical pixel.
+    uint32_t clock_hz;
+    bool owns_bus;              ///< The bus was initialized by install, otherwise the application did it.
+    bool in_flight;             ///< A transaction was queued and its result wasn't collected yet.
+} spi_context_t;
+
+typedef struct open_device_args
+{
+    const led_strip_config_t *config;
+    spi_context_t *context;
+    size_t buffer_size;
+    esp_err_t result;
+} open_device_args_t;
+
+static esp_err_t spi_backend_install(led_strip_handle_t handle, const led_strip_config_t *config);
+static esp_err_t spi_backend_uninstall(led_strip_handle_t handle);
+static esp_err_t spi_backend_transmit(led_strip_handle_t handle, const led_strip_color_component_t *data, size_t size, bool wait_tx_done);
+static esp_err_t spi_backend_wait_tx_done(led_strip_handle_t handle, TickType_t timeout);
+static uint32_t spi_backend_frame_period_us(led_strip_handle_t handle);
+static void IRAM_ATTR on_trans_done(spi_transaction_t *transaction);
+static void open_device(void *arg);
+static void release_context(spi_context_t *context);
+static size_t frame_size(size_t pixel_count);
+static size_t encode_frame(led_strip_handle_t handle, const led_strip_color_component_t *pixels, size_t pixel_count);
+
+const led_strip_backend_t led_strip_spi_backend = {
+    .init = NULL,
+    .install = spi_backend_install,
+    .uninstall = spi_backend_uninstall,
+    .transmit = spi_backend_transmit,
+    .transmit_symbols = NULL, // Baked frames are RMT symbols, install refuses baked frame slots.
+    .wait_tx_done = spi_backend_wait_tx_done,
+    .group_install = NULL,
+    .group_uninstall = NULL,
+    .frame_period_us = spi_backend_frame_period_us,
+    .maps_pixels = true,     // The pixel frames are built from pixel_colors, in the B, G, R order of the LEDs.
+    .sends_reset = true,     // The LEDs latch on the end frame, there is no reset time.
+};
+
+extern esp_err_t led_strip_set_pixel_global_brightness(led_strip_handle_t handle, led_strip_pixel_index_t index, uint8_t level)
+{
+    if (handle == NULL || level > MAX_GLOBAL_BRIGHTNESS)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    else if (handle->backend != &led_strip_spi_backend)
+    {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    else if (index >= handle->led_count)
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    spi_context_t *context = (spi_context_t *)handle->backend_context;
+    const led_strip_pixel_index_t physical = led_strip_physical_index(handle, index);
+    context->global_brightness[physical] = level;
+    led_strip_mark_pixels_changed(handle, (size_t)physical + 1);
+    return ESP_OK;
+}
+
+// Private functions
+
+static esp_err_t spi_backend_install(led_strip_handle_t handle, const led_strip_config_t *config)
+{
+    if (config->enable_w_channel || config->spi_clock_gpio_num < 0 || config->spi_clock_hz == 0)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    else if (config->baked_frame_count != 0)
+    {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    spi_context_t *context = (spi_context_t *)calloc(1, sizeof(spi_context_t));
+    if (context == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    context->host = (spi_host_device_t)config->spi_host;
+    context->clock_hz = config->spi_clock_hz;
+    const size_t buffer_size = frame_size(config->led_count);
+    context->buffer = (uint8_t *)heap_caps_calloc(1, buffer_size, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+    context->global_brightness = (uint8_t *)malloc(config->led_count);
+    if (context->buffer == NULL || context->global_brightness == NULL)
+    {
+        release_context(context);
+        return ESP_ERR_NO_MEM;
+    }
+    memset(context->global_brightness, MAX_GLOBAL_BRIGHTNESS, config->led_count);
+
+    open_device_args_t device_args = {
+        .config = config,
+        .context = context,
+        .buffer_size = buffer_size,
+        .result = ESP_FAIL,
+    };
+    // The driver allocates the interrupt of the bus on the core that initializes it.
+    esp_err_t err = led_strip_run_on_core(config->intr_core, open_device, &device_args);
+    if (err == ESP_OK)
+    {
+        err = device_args.result;
+    }
+    ESP_ERROR_CHECK_WITHOUT_ABORT(err);
+    if (err != ESP_OK)
+    {
+        release_context(context);
+        return err;
+    }
+    context->transaction.user = handle;
+    handle->backend_context = context;
+    return ESP_OK;
+}
+
+static esp_err_t spi_backend_uninstall(led_strip_handle_t handle)
+{
+    spi_context_t *context = (spi_context_t *)handle->backend_context;
+    esp_err_t err = spi_backend_wait_tx_done(handle, portMAX_DELAY);
+    ESP_ERROR_CHECK_WITHOUT_ABORT(err);
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+    release_context(context);
+    handle->backend_context = NULL;
+    return ESP_OK;
+}
+
+static esp_err_t spi_backend_transmit(led_strip_handle_t handle, const led_strip_color_component_t *data, size_t size, bool wait_tx_done)
+{
+    spi_context_t *context = (spi_context_t *)handle->backend_context;
+    // The result of the previous frame has to be collected before the buffer may be written again.
+    esp_err_t err = spi_backend_wait_tx_done(handle, 0);
+    if (err != ESP_OK)
+    {
+        return ESP_ERR_NOT_FINISHED;
+    }
+    const uint32_t start_cycles = led_strip_stats_cycle_count();
+    const size_t pixel_count = size / LED_STRIP_PIXEL_STRIDE(handle);
+    const size_t frame_bytes = encode_frame(handle, data, pixel_count);
+    led_strip_stats_record_translation(handle, size, start_cycles);
+
+    context->transaction.length = frame_bytes * 8;
+    context->transaction.tx_buffer = context->buffer;
+    context->transaction.rx_buffer = NULL;
+    err = spi_device_queue_trans(context->device, &context->transaction, portMAX_DELAY);
+    LED_STRIP_HOT_PATH_ERROR_CHECK(err);
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+    context->in_flight = true;
+    if (wait_tx_done == false)
+    {
+        return ESP_OK;
+    }
+    return spi_backend_wait_tx_done(handle, portMAX_DELAY);
+}
+
+static esp_err_t spi_backend_wait_tx_done(led_strip_handle_t handle, TickType_t timeout)
+{
+    spi_context_t *context = (spi_context_t *)handle->backend_context;
+    if (context->in_flight == false)
+    {
+        return ESP_OK;
+    }
+    spi_transaction_t *transaction = NULL;
+    if (spi_device_get_trans_result(context->device, &transaction, timeout) != ESP_OK)
+    {
+        return ESP_ERR_TIMEOUT;
+    }
+    context->in_flight = false;
+    return ESP_OK;
+}
+
+static uint32_t spi_backend_frame_period_us(led_strip_handle_t handle)
+{
+    const spi_context_t *context = (const spi_context_t *)handle->backend_context;
+    const uint64_t bits = (uint64_t)frame_size(handle->led_count) * 8;
+    return (uint32_t)(((bits * 1000000) + context->clock_hz - 1) / context->clock_hz);
+}
+
+static void IRAM_ATTR on_trans_done(spi_transaction_t *transaction)
+{
+    BaseType_t higher_priority_task_woken = pdFALSE;
+    led_strip_on_tx_done_from_isr((led_strip_handle_t)transaction->user, &higher_priority_task_woken);
+    if (higher_priority_task_woken == pdTRUE)
+    {
+        portYIELD_FROM_ISR();
+    }
+}
+
+static void open_device(void *arg)
+{
+    open_device_args_t *args = (open_device_args_t *)arg;
+    const led_strip_config_t *config = args->config;
+    spi_context_t *context = args->context;
+    const spi_bus_config_t bus_config = {
+        .mosi_io_num = config->gpio_output_num,
+        .miso_io_num = -1,
+        .sclk_io_num = config->spi_clock_gpio_num,
+        .quadwp_io_num = -1,
+        .quadhd_io_num = -1,
+        .max_transfer_sz = (int)args->buffer_size,
+        .intr_flags = config->intr_flags,
+    };
+    esp_err_t err = spi_bus_initialize(context->host, &bus_config, SPI_DMA_CH_AUTO);
+    if (err == ESP_OK)
+    {
+        context->owns_bus = true;
+    }
+    else if (err != ESP_ERR_INVALID_STATE)
+    {
+        args->result = err;
+        return;
+    }
+    // ESP_ERR_INVALID_STATE: the application initialized the bus already, the led strip becomes one of its devices.
+
+    const spi_device_interface_config_t device_config = {
+        .mode = 0, // The LEDs sample the data on the rising clock edge.
+        .clock_speed_hz = (int)config->spi_clock_hz,
+        .spics_io_num = -1,
+        .queue_size = 1,
+        .post_cb = on_trans_done,
+    };
+    args->result = spi_bus_add_device(context->host, &device_config, &context->device);
+}
+
+static void release_context(spi_context_t *context)
+{
+    if (context->device != NULL)
+    {
+        spi_bus_remove_device(context->device);
+    }
+    if (context->owns_bus)
+    {
+        spi_bus_free(context->host);
+    }
+    heap_caps_free(context->buffer);
+    free(context->global_brightness);
+    free(context);
+}
+
+static size_t frame_size(size_t pixel_count)
+{
+    // Every LED delays the data by half a clock cycle, so the end frame needs a clock edge for every 2 LEDs.
+    const size_t end_frame_size = LATCH_FRAME_SIZE + ((pixel_count + 15) / 16);
+    return START_FRAME_SIZE + (pixel_count * PIXEL_FRAME_SIZE) + end_frame_size;
+}
+
+static size_t encode_frame(led_strip_handle_t handle, const led_strip_color_component_t *pixels, size_t pixel_count)
+{
+    spi_context_t *context = (spi_context_t *)handle->backend_context;
+    const color_offsets_t offsets = LED_STRIP_COLOR_OFFSETS(handle);
+    const uint8_t *levels = handle->apply_levels ? handle->level_lut : NULL;
+    const size_t stride = LED_STRIP_PIXEL_STRIDE(handle);
+    uint8_t *out = context->buffer;
+    memset(out, 0x00, START_FRAME_SIZE);
+    out += START_FRAME_SIZE;
+    for (size_t i = 0; i < pixel_count; i++, pixels += stride, out += PIXEL_FRAME_SIZE)
+    {
+        out[0] = PIXEL_HEADER | context->global_brightness[i];
+        out[1] = levels != NULL ? levels[pixels[offsets.b]] : pixels[offsets.b];
+        out[2] = levels != NULL ? levels[pixels[offsets.g]] : pixels[offsets.g];
+        out[3] = levels != NULL ? levels[pixels[offsets.r]] : pixels[offsets.r];
+    }
+    // Zeros instead of the ones of the APA102 datasheet, SK9822 takes them as its latch frame and APA102 only needs the clock edges.
+    const size_t size = frame_size(pixel_count);
+    memset(out, 0x00, size - (size_t)(out - context->buffer));
+    return size;
+}